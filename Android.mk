@@ -97,6 +97,7 @@ LOCAL_SRC_FILES:= \
 		glslang/MachineIndependent/limits.cpp \
 		glslang/MachineIndependent/linkValidate.cpp \
 		glslang/MachineIndependent/parseConst.cpp \
+		glslang/MachineIndependent/NodeTypes.cpp \
 		glslang/MachineIndependent/ParseContextBase.cpp \
 		glslang/MachineIndependent/ParseHelper.cpp \
 		glslang/MachineIndependent/PoolAlloc.cpp \
@@ -107,6 +108,7 @@ LOCAL_SRC_FILES:= \
 		glslang/MachineIndependent/ShaderLang.cpp \
 		glslang/MachineIndependent/SpirvIntrinsics.cpp \
 		glslang/MachineIndependent/SymbolTable.cpp \
+		glslang/MachineIndependent/SymbolTableImage.cpp \
 		glslang/MachineIndependent/Versions.cpp \
 		glslang/MachineIndependent/preprocessor/PpAtom.cpp \
 		glslang/MachineIndependent/preprocessor/PpContext.cpp \
@@ -78,20 +78,28 @@ namespace {
 class SpecConstantOpModeGuard {
 public:
     SpecConstantOpModeGuard(spv::Builder* builder)
-        : builder_(builder) {
+        : builder_(builder), released_(false) {
         previous_flag_ = builder->isInSpecConstCodeGenMode();
     }
     ~SpecConstantOpModeGuard() {
+        if (released_)
+            return;
         previous_flag_ ? builder_->setToSpecConstCodeGenMode()
                        : builder_->setToNormalCodeGenMode();
     }
     void turnOnSpecConstantOpMode() {
         builder_->setToSpecConstCodeGenMode();
     }
+    // Leave restoring the previous mode to the caller.
+    bool release() {
+        released_ = true;
+        return previous_flag_;
+    }
 
 private:
     spv::Builder* builder_;
     bool previous_flag_;
+    bool released_;
 };
 
 struct OpDecorations {
@@ -274,6 +282,13 @@ protected:
     // for mapping glslang symbol struct to symbol Id
     std::unordered_map<const glslang::TTypeList*, long long> glslangTypeToIdMap;
     std::stack<bool> breakForLoop;  // false means break for switch
+    // Generic binary operations whose operands are being traversed, innermost last
+    struct TBinaryOperands {
+        const glslang::TIntermBinary* node;
+        spv::Id left;
+        bool specConstantOpMode;    // mode to go back to when done
+    };
+    std::vector<TBinaryOperands> binaryOperands;
     std::unordered_map<std::string, const glslang::TIntermSymbol*> counterOriginator;
     // Map pointee types for EbtReference to their forward pointers
     std::map<const glslang::TType *, spv::Id> forwardPointers;
@@ -1528,7 +1543,7 @@ bool HasNonLayoutQualifiers(const glslang::TType& type, const glslang::TQualifie
 TGlslangToSpvTraverser::TGlslangToSpvTraverser(unsigned int spvVersion,
     const glslang::TIntermediate* glslangIntermediate,
     spv::SpvBuildLogger* buildLogger, glslang::SpvOptions& options) :
-        TIntermTraverser(true, false, true),
+        TIntermTraverser(true, true, true),
         options(options),
         shaderEntry(nullptr), currentFunction(nullptr),
         sequenceDepth(0), logger(buildLogger),
@@ -2092,7 +2107,7 @@ void TGlslangToSpvTraverser::visitSymbol(glslang::TIntermSymbol* symbol)
     }
 
     // Only process non-linkage-only nodes for generating actual static uses
-    if (! linkageOnly || symbol->getQualifier().isSpecConstant()) {
+    if (! linkageOnly || symbol->getType().getQualifier().isSpecConstant()) {
         // Prepare to generate code for the access
 
         // L-value chains will be computed left to right.  We're on the symbol now,
@@ -2107,7 +2122,7 @@ void TGlslangToSpvTraverser::visitSymbol(glslang::TIntermSymbol* symbol)
         // B) Specialization constants (normal constants don't even come in as a variable),
         //    These are also pure R-values.
         // C) R-Values from type translation, see above call to translateForcedType()
-        glslang::TQualifier qualifier = symbol->getQualifier();
+        glslang::TQualifier qualifier = symbol->getType().getQualifier();
         if (qualifier.isSpecConstant() || rValueParameters.find(symbol->getId()) != rValueParameters.end() ||
             !builder.isPointerType(builder.getTypeId(id)))
             builder.setAccessChainRValue(id);
@@ -2150,8 +2165,45 @@ void TGlslangToSpvTraverser::visitSymbol(glslang::TIntermSymbol* symbol)
 #endif
 }
 
-bool TGlslangToSpvTraverser::visitBinary(glslang::TVisit /* visit */, glslang::TIntermBinary* node)
+bool TGlslangToSpvTraverser::visitBinary(glslang::TVisit visit, glslang::TIntermBinary* node)
 {
+    if (visit != glslang::EvPreVisit) {
+        // Only the generic binary operations below leave their operands to the traversal.
+        if (binaryOperands.empty() || binaryOperands.back().node != node)
+            return true;
+
+        if (visit == glslang::EvInVisit) {
+            // get left operand
+            binaryOperands.back().left = accessChainLoad(node->getLeft()->getType());
+
+            // get right operand, next
+            builder.clearAccessChain();
+            return true;
+        }
+
+        const TBinaryOperands operands = binaryOperands.back();
+        binaryOperands.pop_back();
+        spv::Id right = accessChainLoad(node->getRight()->getType());
+
+        // get result
+        OpDecorations decorations = { TranslatePrecisionDecoration(node->getOperationPrecision()),
+                                      TranslateNoContractionDecoration(node->getType().getQualifier()),
+                                      TranslateNonUniformDecoration(node->getType().getQualifier()) };
+        spv::Id result = createBinaryOperation(node->getOp(), decorations,
+                                               convertGlslangToSpvType(node->getType()), operands.left, right,
+                                               node->getLeft()->getType().getBasicType());
+
+        builder.clearAccessChain();
+        if (! result)
+            logger->missingFunctionality("unknown glslang binary operation");
+        else
+            builder.setAccessChainRValue(result);
+
+        operands.specConstantOpMode ? builder.setToSpecConstCodeGenMode()
+                                    : builder.setToNormalCodeGenMode();
+        return true;
+    }
+
     builder.setDebugSourceLocation(node->getLoc().line, node->getLoc().getFilename());
     if (node->getLeft()->getAsSymbolNode() != nullptr && node->getLeft()->getType().isStruct()) {
         glslangTypeToIdMap[node->getLeft()->getType().getStruct()] = node->getLeft()->getAsSymbolNode()->getId();
@@ -2374,32 +2426,13 @@ bool TGlslangToSpvTraverser::visitBinary(glslang::TVisit /* visit */, glslang::T
 
     // Assume generic binary op...
 
-    // get right operand
-    builder.clearAccessChain();
-    node->getLeft()->traverse(this);
-    spv::Id left = accessChainLoad(node->getLeft()->getType());
-
-    // get left operand
-    builder.clearAccessChain();
-    node->getRight()->traverse(this);
-    spv::Id right = accessChainLoad(node->getRight()->getType());
-
-    // get result
-    OpDecorations decorations = { TranslatePrecisionDecoration(node->getOperationPrecision()),
-                                  TranslateNoContractionDecoration(node->getType().getQualifier()),
-                                  TranslateNonUniformDecoration(node->getType().getQualifier()) };
-    spv::Id result = createBinaryOperation(node->getOp(), decorations,
-                                           convertGlslangToSpvType(node->getType()), left, right,
-                                           node->getLeft()->getType().getBasicType());
-
+    // Let the traversal go down to the operands, rather than traversing them
+    // from here, so long chains of operations don't recurse.  The in-visit
+    // loads the left one and the post-visit does the operation, in the
+    // specialization-constant mode set above.
     builder.clearAccessChain();
-    if (! result) {
-        logger->missingFunctionality("unknown glslang binary operation");
-        return true;  // pick up a child as the place-holder result
-    } else {
-        builder.setAccessChainRValue(result);
-        return false;
-    }
+    binaryOperands.push_back({ node, spv::NoResult, spec_constant_op_mode_setter.release() });
+    return true;
 }
 
 spv::Id TGlslangToSpvTraverser::convertLoadedBoolInUniformToUint(const glslang::TType& type,
@@ -2670,12 +2703,12 @@ bool TGlslangToSpvTraverser::visitUnary(glslang::TVisit /* visit */, glslang::TI
         node->getOp() == glslang::EOpRayQueryGetIntersectionCandidateAABBOpaque ||
         node->getOp() == glslang::EOpRayQueryTerminate ||
         node->getOp() == glslang::EOpRayQueryConfirmIntersection ||
-        (node->getOp() == glslang::EOpSpirvInst && operandNode->getAsTyped()->getQualifier().isSpirvByReference()) ||
+        (node->getOp() == glslang::EOpSpirvInst && operandNode->getAsTyped()->getType().getQualifier().isSpirvByReference()) ||
         hitObjectOpsWithLvalue(node->getOp())) {
         operand = builder.accessChainGetLValue(); // Special case l-value operands
         lvalueCoherentFlags = builder.getAccessChain().coherentFlags;
         lvalueCoherentFlags |= TranslateCoherent(operandNode->getAsTyped()->getType());
-    } else if (operandNode->getAsTyped()->getQualifier().isSpirvLiteral()) {
+    } else if (operandNode->getAsTyped()->getType().getQualifier().isSpirvLiteral()) {
         // Will be translated to a literal value, make a placeholder here
         operand = spv::NoResult;
     } else {
@@ -2711,7 +2744,7 @@ bool TGlslangToSpvTraverser::visitUnary(glslang::TVisit /* visit */, glslang::TI
             const auto& spirvInst = node->getSpirvInstruction();
             if (spirvInst.set == "") {
                 spv::IdImmediate idImmOp = {true, operand};
-                if (operandNode->getAsTyped()->getQualifier().isSpirvLiteral()) {
+                if (operandNode->getAsTyped()->getType().getQualifier().isSpirvLiteral()) {
                     // Translate the constant to a literal value
                     std::vector<unsigned> literals;
                     glslang::TVector<const glslang::TIntermConstantUnion*> constants;
@@ -2874,6 +2907,10 @@ spv::Id TGlslangToSpvTraverser::createCompositeConstruct(spv::Id resultTypeId, s
 
 bool TGlslangToSpvTraverser::visitAggregate(glslang::TVisit visit, glslang::TIntermAggregate* node)
 {
+    // In-visits are for generic binary operations.
+    if (visit == glslang::EvInVisit)
+        return true;
+
     SpecConstantOpModeGuard spec_constant_op_mode_setter(&builder);
     if (node->getType().getQualifier().isSpecConstant())
         spec_constant_op_mode_setter.turnOnSpecConstantOpMode();
@@ -3614,7 +3651,7 @@ bool TGlslangToSpvTraverser::visitAggregate(glslang::TVisit visit, glslang::TInt
                 lvalue = true;
             break;
         case glslang::EOpSpirvInst:
-            if (glslangOperands[arg]->getAsTyped()->getQualifier().isSpirvByReference())
+            if (glslangOperands[arg]->getAsTyped()->getType().getQualifier().isSpirvByReference())
                 lvalue = true;
             break;
         case glslang::EOpReorderThreadNV:
@@ -3751,7 +3788,7 @@ bool TGlslangToSpvTraverser::visitAggregate(glslang::TVisit visit, glslang::TInt
                  visitSymbol(itNode->second);
                  spv::Id symId = getSymbolId(itNode->second);
                  operands.push_back(symId);
-             } else if (glslangOperands[arg]->getAsTyped()->getQualifier().isSpirvLiteral()) {
+             } else if (glslangOperands[arg]->getAsTyped()->getType().getQualifier().isSpirvLiteral()) {
                  // Will be translated to a literal value, make a placeholder here
                  operands.push_back(spv::NoResult);
              } else if (glslangOperands[arg]->getAsTyped()->getBasicType() == glslang::EbtFunction) {
@@ -3969,7 +4006,7 @@ bool TGlslangToSpvTraverser::visitAggregate(glslang::TVisit visit, glslang::TInt
         if (spirvInst.set == "") {
             std::vector<spv::IdImmediate> idImmOps;
             for (unsigned int i = 0; i < glslangOperands.size(); ++i) {
-                if (glslangOperands[i]->getAsTyped()->getQualifier().isSpirvLiteral()) {
+                if (glslangOperands[i]->getAsTyped()->getType().getQualifier().isSpirvLiteral()) {
                     // Translate the constant to a literal value
                     std::vector<unsigned> literals;
                     glslang::TVector<const glslang::TIntermConstantUnion*> constants;
@@ -4294,7 +4331,7 @@ bool TGlslangToSpvTraverser::visitSwitch(glslang::TVisit /* visit */, glslang::T
 
 void TGlslangToSpvTraverser::visitConstantUnion(glslang::TIntermConstantUnion* node)
 {
-    if (node->getQualifier().isSpirvLiteral())
+    if (node->getType().getQualifier().isSpirvLiteral())
         return; // Translated to a literal value, skip further processing
 
     int nextConst = 0;
@@ -4451,7 +4488,7 @@ spv::Id TGlslangToSpvTraverser::createSpvVariable(const glslang::TIntermSymbol*
     // First, steer off constants, which are not SPIR-V variables, but
     // can still have a mapping to a SPIR-V Id.
     // This includes specialization constants.
-    if (node->getQualifier().isConstant()) {
+    if (node->getType().getQualifier().isConstant()) {
         spv::Id result = createSpvConstant(*node);
         if (result != spv::NoResult)
             return result;
@@ -4999,7 +5036,7 @@ void TGlslangToSpvTraverser::applySpirvDecorate(const glslang::TType& type, spv:
             std::vector<spv::Id> operandIds;
             assert(!decorateId.second.empty());
             for (auto extraOperand : decorateId.second) {
-                if (extraOperand->getQualifier().isFrontEndConstant())
+                if (extraOperand->getType().getQualifier().isFrontEndConstant())
                     operandIds.push_back(createSpvConstant(*extraOperand));
                 else
                     operandIds.push_back(getSymbolId(extraOperand->getAsSymbolNode()));
@@ -5831,9 +5868,9 @@ void TGlslangToSpvTraverser::collectRayTracingLinkerObjects()
     for (auto& objSeq : linkerObjects->getSequence()) {
         auto objNode = objSeq->getAsSymbolNode();
         if (objNode != nullptr) {
-            if (objNode->getQualifier().hasLocation()) {
-                unsigned int location = objNode->getQualifier().layoutLocation;
-                auto st = objNode->getQualifier().storage;
+            if (objNode->getType().getQualifier().hasLocation()) {
+                unsigned int location = objNode->getType().getQualifier().layoutLocation;
+                auto st = objNode->getType().getQualifier().storage;
                 int set;
                 switch (st)
                 {
@@ -10398,6 +10435,7 @@ void GlslangToSpv(const TIntermediate& intermediate, std::vector<unsigned int>&
         options = &defaultOptions;
 
     GetThreadPoolAllocator().push();
+    TMemoryPhaseMarker memoryPhase(intermediate.getMemoryStats(), EShMemoryPhaseSpirv);
 
     TGlslangToSpvTraverser it(intermediate.getSpv().spv, &intermediate, logger, *options);
     root->traverse(&it);
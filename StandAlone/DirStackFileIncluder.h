@@ -41,15 +41,198 @@
 #include <fstream>
 #include <algorithm>
 #include <set>
+#include <map>
+#include <memory>
+#ifndef DISABLE_THREAD_SUPPORT
+#include <mutex>
+#endif
+
+#include <sys/stat.h>
 
 #include "./../glslang/Public/ShaderLang.h"
 
+// Contents of included files, read once and shared by any number of
+// DirStackFileIncluder objects, on any number of threads.  A file is read again
+// once its modification time, size, or identity no longer match what was read.
+// When the cache holds more than its limit, the least recently used files are
+// dropped from it; contents still held by an include result stay alive until
+// released.
+class IncludeFileCache {
+public:
+    explicit IncludeFileCache(size_t limit = 64 * 1024 * 1024) : limit(limit), bytes(0), uses(0) { }
+
+    // What identifies one version of a file.
+    struct Version {
+        long long seconds;
+        long long nanoseconds;
+        unsigned long long device;
+        unsigned long long inode;
+        size_t size;
+
+        bool operator==(const Version& other) const
+        {
+            return seconds == other.seconds && nanoseconds == other.nanoseconds &&
+                   device == other.device && inode == other.inode && size == other.size;
+        }
+        bool operator!=(const Version& other) const { return ! operator==(other); }
+    };
+
+    // The read-only contents of one file, kept for as long as anything holds them.
+    class Contents {
+    public:
+        ~Contents() { delete [] data; }
+
+        const char* data;
+        size_t size;
+        Version version;
+
+    private:
+        friend class IncludeFileCache;
+        Contents() : data(nullptr), size(0), version() { }
+        Contents(const Contents&);
+        Contents& operator=(const Contents&);
+    };
+
+    // The current contents of the file at 'path', or nullptr if it can't be read.
+    std::shared_ptr<const Contents> get(const std::string& path)
+    {
+        Version version;
+        if (! status(path, version)) {
+#ifndef DISABLE_THREAD_SUPPORT
+            std::lock_guard<std::mutex> guard(lock);
+#endif
+            drop(path);
+            return nullptr;
+        }
+
+        {
+#ifndef DISABLE_THREAD_SUPPORT
+            std::lock_guard<std::mutex> guard(lock);
+#endif
+            auto it = files.find(path);
+            if (it != files.end() && it->second.contents->version == version) {
+                it->second.lastUse = ++uses;
+                return it->second.contents;
+            }
+        }
+
+        // Read outside the lock; if another thread does the same, either result will do.
+        std::shared_ptr<const Contents> contents = read(path, version);
+        if (contents == nullptr)
+            return nullptr;
+
+        // Don't keep what was read if the file changed while it was read.
+        Version after;
+        if (! status(path, after) || after != version || contents->size != version.size)
+            return contents;
+
+#ifndef DISABLE_THREAD_SUPPORT
+        std::lock_guard<std::mutex> guard(lock);
+#endif
+        drop(path);
+        Entry& entry = files[path];
+        entry.contents = contents;
+        entry.lastUse = ++uses;
+        bytes += contents->size;
+        trim(path);
+
+        return contents;
+    }
+
+    // Bytes of file contents the cache holds on to.
+    size_t getBytes()
+    {
+#ifndef DISABLE_THREAD_SUPPORT
+        std::lock_guard<std::mutex> guard(lock);
+#endif
+        return bytes;
+    }
+
+protected:
+    struct Entry {
+        std::shared_ptr<const Contents> contents;
+        unsigned long long lastUse;
+    };
+
+    static bool status(const std::string& path, Version& version)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0 || (info.st_mode & S_IFMT) != S_IFREG)
+            return false;
+        version.seconds = static_cast<long long>(info.st_mtime);
+#if defined(__APPLE__)
+        version.nanoseconds = static_cast<long long>(info.st_mtimespec.tv_nsec);
+#elif defined(__unix__)
+        version.nanoseconds = static_cast<long long>(info.st_mtim.tv_nsec);
+#else
+        version.nanoseconds = 0;
+#endif
+        version.device = static_cast<unsigned long long>(info.st_dev);
+        version.inode = static_cast<unsigned long long>(info.st_ino);
+        version.size = static_cast<size_t>(info.st_size);
+
+        return true;
+    }
+
+    // Reads into a buffer of our own, so a file shrinking later can't affect what was read.
+    static std::shared_ptr<const Contents> read(const std::string& path, const Version& version)
+    {
+        std::ifstream file(path, std::ios_base::binary);
+        if (! file)
+            return nullptr;
+        std::shared_ptr<Contents> contents(new Contents);
+        contents->version = version;
+        char* data = new char[version.size > 0 ? version.size : 1];
+        contents->data = data;
+        file.read(data, version.size);
+        contents->size = static_cast<size_t>(file.gcount());
+
+        return contents;
+    }
+
+    // The following expect the lock to be held.
+
+    void drop(const std::string& path)
+    {
+        auto it = files.find(path);
+        if (it == files.end())
+            return;
+        bytes -= it->second.contents->size;
+        files.erase(it);
+    }
+
+    // Drop the least recently used files, other than 'keep', until within the limit.
+    void trim(const std::string& keep)
+    {
+        while (bytes > limit && files.size() > 1) {
+            auto oldest = files.end();
+            for (auto it = files.begin(); it != files.end(); ++it) {
+                if (it->first != keep && (oldest == files.end() || it->second.lastUse < oldest->second.lastUse))
+                    oldest = it;
+            }
+            bytes -= oldest->second.contents->size;
+            files.erase(oldest);
+        }
+    }
+
+#ifndef DISABLE_THREAD_SUPPORT
+    std::mutex lock;
+#endif
+    std::map<std::string, Entry> files;
+    size_t limit;
+    size_t bytes;
+    unsigned long long uses;
+};
+
 // Default include class for normal include convention of search backward
 // through the stack of active include paths (for nested includes).
 // Can be overridden to customize.
 class DirStackFileIncluder : public glslang::TShader::Includer {
 public:
-    DirStackFileIncluder() : externalLocalDirectoryCount(0) { }
+    DirStackFileIncluder() : externalLocalDirectoryCount(0), fileCache(nullptr) { }
+
+    // Read files through 'cache', which must outlive this and what it returns.
+    explicit DirStackFileIncluder(IncludeFileCache* cache) : externalLocalDirectoryCount(0), fileCache(cache) { }
 
     virtual IncludeResult* includeLocal(const char* headerName,
                                         const char* includerName,
@@ -80,7 +263,10 @@ public:
     virtual void releaseInclude(IncludeResult* result) override
     {
         if (result != nullptr) {
-            delete [] static_cast<tUserDataElement*>(result->userData);
+            if (fileCache != nullptr)
+                delete static_cast<std::shared_ptr<const IncludeFileCache::Contents>*>(result->userData);
+            else
+                delete [] static_cast<tUserDataElement*>(result->userData);
             delete result;
         }
     }
@@ -97,6 +283,7 @@ protected:
     std::vector<std::string> directoryStack;
     int externalLocalDirectoryCount;
     std::set<std::string> includedFiles;
+    IncludeFileCache* fileCache;
 
     // Search for a valid "local" path based on combining the stack of include
     // directories and the nominal name of the header.
@@ -112,6 +299,15 @@ protected:
         for (auto it = directoryStack.rbegin(); it != directoryStack.rend(); ++it) {
             std::string path = *it + '/' + headerName;
             std::replace(path.begin(), path.end(), '\\', '/');
+            if (fileCache != nullptr) {
+                std::shared_ptr<const IncludeFileCache::Contents> contents = fileCache->get(path);
+                if (contents != nullptr) {
+                    directoryStack.push_back(getDirectory(path));
+                    includedFiles.insert(path);
+                    return newIncludeResult(path, contents);
+                }
+                continue;
+            }
             std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
             if (file) {
                 directoryStack.push_back(getDirectory(path));
@@ -139,6 +335,14 @@ protected:
         return new IncludeResult(path, content, length, content);
     }
 
+    // Make an include result that refers to cached contents, without copying them.
+    virtual IncludeResult* newIncludeResult(const std::string& path,
+                                            const std::shared_ptr<const IncludeFileCache::Contents>& contents) const
+    {
+        return new IncludeResult(path, contents->data, contents->size,
+                                 new std::shared_ptr<const IncludeFileCache::Contents>(contents));
+    }
+
     // If no path markers, return current working directory.
     // Otherwise, strip file name and return path leading up to it.
     virtual std::string getDirectory(const std::string path) const
@@ -110,6 +110,7 @@ enum TOptions : uint64_t {
     EOptionCompileOnly = (1ull << 32),
     EOptionDisplayErrorColumn = (1ull << 33),
     EOptionLinkTimeOptimization = (1ull << 34),
+    EOptionScanDependencies = (1ull << 35),
 };
 bool targetHlslFunctionality1 = false;
 bool SpvToolsDisassembler = false;
@@ -184,7 +185,13 @@ bool HlslDxPositionW = false;
 bool EnhancedMsgs = false;
 bool AbsolutePath = false;
 bool DumpBuiltinSymbols = false;
+const char* SaveBuiltinSymbolsFileName = nullptr;
+std::vector<std::string> LoadBuiltinSymbolsFileNames;
+bool LazyBuiltins = false;
+bool MemoryStats = false;
+size_t IncludeTokenCacheLimit = 0;
 std::vector<std::string> IncludeDirectoryList;
+IncludeFileCache IncludeFiles;  // headers read once, shared by every includer
 
 // Source environment
 // (source 'Client' is currently the same as target 'Client')
@@ -663,6 +670,16 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
                         bumpArg();
                     } else if (lowerword == "dump-builtin-symbols") {
                         DumpBuiltinSymbols = true;
+                    } else if (lowerword == "load-builtin-symbols") {
+                        if (argc <= 1)
+                            Error("no <file> provided", lowerword.c_str());
+                        LoadBuiltinSymbolsFileNames.push_back(argv[1]);
+                        bumpArg();
+                    } else if (lowerword == "save-builtin-symbols") {
+                        if (argc <= 1)
+                            Error("no <file> provided", lowerword.c_str());
+                        SaveBuiltinSymbolsFileName = argv[1];
+                        bumpArg();
                     } else if (lowerword == "entry-point") {
                         entryPointName = argv[1];
                         if (argc <= 1)
@@ -732,12 +749,26 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
                         AbsolutePath = true;
                     } else if (lowerword == "auto-sampled-textures") {
                         autoSampledTextures = true;
+                    } else if (lowerword == "include-token-cache") {
+                        if (argc > 1) {
+                            char* end = nullptr;
+                            const unsigned long megabytes = strtoul(argv[1], &end, 10);
+                            if (end == argv[1] || *end != '\0')
+                                Error("--include-token-cache expects a size in megabytes");
+                            IncludeTokenCacheLimit = static_cast<size_t>(megabytes) * 1024 * 1024;
+                        } else
+                            Error("expects <megabytes>", argv[0]);
+                        bumpArg();
                     } else if (lowerword == "invert-y" ||  // synonyms
                                lowerword == "iy") {
                         Options |= EOptionInvertY;
                     } else if (lowerword == "keep-uncalled" || // synonyms
                                lowerword == "ku") {
                         Options |= EOptionKeepUncalled;
+                    } else if (lowerword == "lazy-builtins") {
+                        LazyBuiltins = true;
+                    } else if (lowerword == "memory-stats") {
+                        MemoryStats = true;
                     } else if (lowerword == "nan-clamp") {
                         NaNClamp = true;
                     } else if (lowerword == "no-storage-format" || // synonyms
@@ -897,6 +928,8 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
                             Error("no <depfile-name> provided", lowerword.c_str());
                         depencyFileName = argv[1];
                         bumpArg();
+                    } else if (lowerword == "scan-dependencies") {
+                        Options |= EOptionScanDependencies;
                     } else if (lowerword == "version") {
                         Options |= EOptionDumpVersions;
                     } else if (lowerword == "no-link") {
@@ -1085,6 +1118,16 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
             Error("reflection requires linking, which can't be used when -E when is selected");
     }
 
+    // --scan-dependencies only produces the depfile
+    if (Options & EOptionScanDependencies) {
+        if (depencyFileName == nullptr)
+            Error("--scan-dependencies requires --depfile");
+        if (Options & EOptionOutputPreprocessed)
+            Error("can't use -E when --scan-dependencies is selected");
+        if (Options & EOptionDumpReflection)
+            Error("reflection requires linking, which can't be used when --scan-dependencies is selected");
+    }
+
     // reflection requires linking
     if ((Options & EOptionDumpReflection) && !(Options & EOptionLinkProgram))
         Error("reflection requires -l for linking");
@@ -1155,7 +1198,7 @@ void SetMessageOptions(EShMessages& messages)
         messages = (EShMessages)(messages | EShMsgSpvRules);
     if (Options & EOptionVulkanRules)
         messages = (EShMessages)(messages | EShMsgVulkanRules);
-    if (Options & EOptionOutputPreprocessed)
+    if (Options & (EOptionOutputPreprocessed | EOptionScanDependencies))
         messages = (EShMessages)(messages | EShMsgOnlyPreprocessor);
     if (Options & EOptionReadHlsl)
         messages = (EShMessages)(messages | EShMsgReadHlsl);
@@ -1242,6 +1285,33 @@ void StderrIfNonEmpty(const char* str)
         fprintf(stderr, "%s\n", str);
 }
 
+// Outputs the pool memory use recorded in 'stats', for --memory-stats.
+void PrintMemoryStats(const char* name, const glslang::TMemoryStats& stats)
+{
+    static const char* const phaseNames[glslang::EShMemoryPhaseCount] = {
+        "built-ins", "preprocess", "parse", "link", "map-io", "spir-v" };
+
+    printf("%s memory:\n", name);
+    for (int p = 0; p < glslang::EShMemoryPhaseCount; ++p) {
+        const glslang::TMemoryPhaseStats& phase = stats.phases[p];
+        if (phase.allocations == 0 && phase.pagesUsed == 0)
+            continue;
+        printf("  %-10s %9zu allocations %11zu bytes %7zu pages %11zu peak bytes\n", phaseNames[p],
+               phase.allocations, phase.bytesAllocated, phase.pagesUsed, phase.peakBytes);
+    }
+    printf("  peak %zu bytes\n", stats.peakBytes);
+}
+
+// Outputs the size of the AST in 'stats', for --memory-stats.
+void PrintTreeStats(const glslang::TTreeStats& stats)
+{
+    if (stats.nodes == 0)
+        return;
+
+    printf("  ast %zu nodes %zu node bytes %zu type bytes, %.1f bytes per node\n", stats.nodes,
+           stats.nodeBytes, stats.typeBytes, double(stats.nodeBytes + stats.typeBytes) / double(stats.nodes));
+}
+
 // Simple bundling of what makes a compilation unit for ease in passing around,
 // and separation of handling file IO versus API (programmatic) compilation.
 struct ShaderCompUnit {
@@ -1331,11 +1401,13 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
     EShMessages messages = EShMsgDefault;
     SetMessageOptions(messages);
 
-    DirStackFileIncluder includer;
+    DirStackFileIncluder includer(&IncludeFiles);
     std::for_each(IncludeDirectoryList.rbegin(), IncludeDirectoryList.rend(), [&includer](const std::string& dir) {
         includer.pushExternalLocalDirectory(dir); });
 
     std::vector<std::string> sources;
+    std::vector<std::string> outputFiles;
+    std::set<std::string> scannedFiles;
 
     //
     // Per-shader processing...
@@ -1478,6 +1550,24 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
             continue;
         }
 
+        if (Options & EOptionScanDependencies) {
+            std::vector<std::string> headers;
+            if (shader->scanDependencies(GetResources(), defaultVersion, ENoProfile, false, false, messages, &headers,
+                                         includer)) {
+                scannedFiles.insert(headers.begin(), headers.end());
+            } else {
+                CompileFailed = 1;
+            }
+            StderrIfNonEmpty(shader->getInfoLog());
+            StderrIfNonEmpty(shader->getInfoDebugLog());
+
+            // the depfile names what compiling would write
+            const std::string binaryName = GetBinaryName(compUnit.stage);
+            if (std::find(outputFiles.begin(), outputFiles.end(), binaryName) == outputFiles.end())
+                outputFiles.push_back(binaryName);
+            continue;
+        }
+
         if (! shader->parse(GetResources(), defaultVersion, false, messages, includer))
             CompileFailed = 1;
 
@@ -1497,7 +1587,7 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
     // Program-level processing...
     //
 
-    if (!compileOnly) {
+    if (!compileOnly && !(Options & EOptionScanDependencies)) {
         // Link
         if (!(Options & EOptionOutputPreprocessed) && !program.link(messages))
             LinkFailed = true;
@@ -1521,10 +1611,8 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
         }
     }
 
-    std::vector<std::string> outputFiles;
-
     // Dump SPIR-V
-    if (Options & EOptionSpv) {
+    if ((Options & EOptionSpv) && !(Options & EOptionScanDependencies)) {
 #ifdef ENABLE_SPIRV
         CompileOrLinkFailed.fetch_or(CompileFailed);
         CompileOrLinkFailed.fetch_or(LinkFailed);
@@ -1593,12 +1681,24 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
     CompileOrLinkFailed.fetch_or(CompileFailed);
     CompileOrLinkFailed.fetch_or(LinkFailed);
     if (depencyFileName && !static_cast<bool>(CompileOrLinkFailed.load())) {
-        std::set<std::string> includedFiles = includer.getIncludedFiles();
+        std::set<std::string> includedFiles = (Options & EOptionScanDependencies) ? scannedFiles
+                                                                                 : includer.getIncludedFiles();
         sources.insert(sources.end(), includedFiles.begin(), includedFiles.end());
 
         writeDepFile(depencyFileName, outputFiles, sources);
     }
 
+    if (MemoryStats) {
+        auto shader = shaders.cbegin();
+        for (auto it = compUnits.cbegin(); it != compUnits.cend() && shader != shaders.cend(); ++it, ++shader)
+        {
+            PrintMemoryStats(it->fileName[0].c_str(), (*shader)->getMemoryStats());
+            PrintTreeStats((*shader)->getTreeStats());
+        }
+        if (!compileOnly && !(Options & (EOptionOutputPreprocessed | EOptionScanDependencies)))
+            PrintMemoryStats("program", program.getMemoryStats());
+    }
+
     // Free everything up, program has to go before the shaders
     // because it might have merged stuff from the shaders, and
     // the stuff from the shaders has to have its destructors called
@@ -1672,6 +1772,52 @@ void CompileAndLinkShaderFiles(glslang::TWorklist& Worklist)
         FreeFileData(const_cast<char*>(it->text[0]));
 }
 
+//
+// Write the built-in symbol tables selected by --glsl-version, the client options,
+// -R and -D to the file named by --save-builtin-symbols.
+//
+bool SaveBuiltinSymbols()
+{
+    glslang::TargetTuple target;
+    target.version = GlslVersion != 0 ? GlslVersion : (Options & EOptionDefaultDesktop ? 110 : 100);
+    switch (target.version) {
+    case 100:
+    case 300:
+    case 310:
+    case 320:
+        target.profile = EEsProfile;
+        break;
+    default:
+        target.profile = target.version >= 150 ? ECoreProfile : ENoProfile;
+        break;
+    }
+    target.client = Client;
+    target.vulkanRulesRelaxed = VulkanRulesRelaxed;
+    target.source = (Options & EOptionReadHlsl) ? glslang::EShSourceHlsl : glslang::EShSourceGlsl;
+
+    std::vector<unsigned char> image;
+    if (! glslang::SaveBuiltInSymbolTables(target, image))
+        return false;
+
+    std::ofstream file(SaveBuiltinSymbolsFileName, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(image.data()), image.size());
+
+    return ! file.fail();
+}
+
+//
+// Install the built-in symbol tables from the files named by --load-builtin-symbols.
+//
+void LoadBuiltinSymbols()
+{
+    for (const std::string& fileName : LoadBuiltinSymbolsFileNames) {
+        std::ifstream file(fileName, std::ios::binary);
+        std::vector<char> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (file.bad() || ! glslang::LoadBuiltInSymbolTables(image.data(), image.size()))
+            Error("unable to load built-in symbol tables", fileName.c_str());
+    }
+}
+
 int singleMain()
 {
     glslang::TWorklist workList;
@@ -1718,6 +1864,17 @@ int singleMain()
             return ESuccess;
     }
 
+    if (SaveBuiltinSymbolsFileName != nullptr) {
+        glslang::InitializeProcess();
+        LoadBuiltinSymbols();
+        const bool saved = SaveBuiltinSymbols();
+        glslang::FinalizeProcess();
+        if (! saved)
+            Error("unable to save built-in symbol tables", SaveBuiltinSymbolsFileName);
+        if (workList.empty() && ((Options & EOptionStdin) == 0))
+            return ESuccess;
+    }
+
     if (workList.empty() && ((Options & EOptionStdin) == 0)) {
         usage();
     }
@@ -1729,26 +1886,33 @@ int singleMain()
 
     ProcessConfigFile();
 
-    if ((Options & EOptionReadHlsl) && !((Options & EOptionOutputPreprocessed) || (Options & EOptionSpv)))
+    if ((Options & EOptionReadHlsl) &&
+        !((Options & EOptionOutputPreprocessed) || (Options & EOptionScanDependencies) || (Options & EOptionSpv)))
         Error("HLSL requires SPIR-V code generation (or preprocessing only)");
 
+    glslang::SetLazyBuiltIns(LazyBuiltins);
+
+    glslang::SetIncludeTokenCacheLimit(IncludeTokenCacheLimit);
+
     //
     // Two modes:
     // 1) linking all arguments together, single-threaded, new C++ interface
     // 2) independent arguments, can be tackled by multiple asynchronous threads, for testing thread safety, using the old handle interface
     //
-    if (Options & (EOptionLinkProgram | EOptionOutputPreprocessed)) {
+    if (Options & (EOptionLinkProgram | EOptionOutputPreprocessed | EOptionScanDependencies)) {
         glslang::InitializeProcess();
         glslang::InitializeProcess();  // also test reference counting of users
         glslang::InitializeProcess();  // also test reference counting of users
         glslang::FinalizeProcess();    // also test reference counting of users
         glslang::FinalizeProcess();    // also test reference counting of users
+        LoadBuiltinSymbols();
         CompileAndLinkShaderFiles(workList);
         glslang::FinalizeProcess();
     } else {
         ShInitialize();
         ShInitialize();  // also test reference counting of users
         ShFinalize();    // also test reference counting of users
+        LoadBuiltinSymbols();
 
         bool printShaderNames = workList.size() > 1;
 
@@ -2038,6 +2202,13 @@ void usage()
            "  --client {vulkan<ver>|opengl<ver>} see -V and -G\n"
            "  --depfile <file>                  writes depfile for build systems\n"
            "  --dump-builtin-symbols            prints builtin symbol table prior each compile\n"
+           "  --load-builtin-symbols <file>     use built-in symbol tables saved by\n"
+           "                                    --save-builtin-symbols instead of generating\n"
+           "                                    them; can be given multiple times\n"
+           "  --save-builtin-symbols <file>     save the built-in symbol tables for the\n"
+           "                                    --glsl-version, client, -R and -D given\n"
+           "                                    (for build-time generation); shader files\n"
+           "                                    are optional\n"
            "  -dumpfullversion | -dumpversion   print bare major.minor.patchlevel\n"
            "  --flatten-uniform-arrays | --fua  flatten uniform texture/sampler arrays to\n"
            "                                    scalars\n"
@@ -2055,10 +2226,18 @@ void usage()
            "                                    and recognizes DirectX9-specific semantics\n"
            "  --hlsl-dx-position-w              W component of SV_Position in HLSL fragment\n"
            "                                    shaders compatible with DirectX\n"
+           "  --include-token-cache <megabytes> keep up to <megabytes> of the tokens\n"
+           "                                    scanned from #include'd headers, so headers\n"
+           "                                    included again are not scanned again\n"
            "  --invert-y | --iy                 invert position.Y output in vertex shader\n"
            "  --enhanced-msgs                   print more readable error messages (GLSL only)\n"
            "  --error-column                    display the column of the error along the line\n"
            "  --keep-uncalled | --ku            don't eliminate uncalled functions\n"
+           "  --lazy-builtins                   only parse the built-in functions each\n"
+           "                                    shader uses, when it first uses them\n"
+           "  --memory-stats                    print the memory each shader and the\n"
+           "                                    program allocate, by phase of work,\n"
+           "                                    and the size of each shader's AST\n"
            "  --nan-clamp                       favor non-NaN operand in min, max, and clamp\n"
            "  --no-storage-format | --nsf       use Unknown image format\n"
            "  --quiet                           do not print anything to stdout, unless\n"
@@ -2080,6 +2259,9 @@ void usage()
            "  --resource-set-binding [stage] set\n"
            "                                    set descriptor set for all resources\n"
            "  --rsb                             synonym for --resource-set-binding\n"
+           "  --scan-dependencies               only write the --depfile: run just the\n"
+           "                                    preprocessor directives that decide which\n"
+           "                                    headers are included, without compiling\n"
            "  --set-block-backing name {uniform|buffer|push_constant}\n"
            "                                    changes the backing type of a uniform, buffer,\n"
            "                                    or push_constant block declared in\n"
@@ -0,0 +1,7 @@
+#ifndef GUARDED_H
+#define GUARDED_H
+
+// all of this is inside the guard
+uniform vec4 guarded;
+
+#endif
@@ -0,0 +1,3 @@
+#pragma once
+
+uniform vec4 once;
@@ -0,0 +1,5 @@
+#ifndef UNGUARDED_H
+#define UNGUARDED_H
+#endif
+
+#define UNGUARDED_COUNT (UNGUARDED_COUNT_PREV + 1)
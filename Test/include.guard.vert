@@ -0,0 +1,25 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "incGuard/guarded.h"
+#include "incGuard/once.h"
+#include "incGuard/guarded.h"
+#include "incGuard/once.h"
+
+#define UNGUARDED_COUNT_PREV 0
+#include "incGuard/unguarded.h"
+#undef UNGUARDED_COUNT_PREV
+#define UNGUARDED_COUNT_PREV 1
+#include "incGuard/unguarded.h"
+
+#undef GUARDED_H
+#define guarded guarded2
+#include "incGuard/guarded.h"
+
+out vec4 color;
+
+void main()
+{
+    color = guarded2 + once * float(UNGUARDED_COUNT);
+}
@@ -0,0 +1,25 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "incGuard/guarded.h"
+
+// only the branch taken is a dependency
+#if defined(GUARDED_H) && __VERSION__ >= 450
+#include "incGuard/once.h"
+#else
+#include "incGuard/missing.h"
+#endif
+
+/* none of this is a directive
+#include "incGuard/missing.h"
+*/ const float quote = 1.0; // #include "incGuard/missing.h"
+
+out vec4 color;
+
+void main()
+{
+    color = guarded + once * quote; /* a comment running on
+#include "incGuard/missing.h"
+    */
+}
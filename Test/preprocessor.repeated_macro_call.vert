@@ -0,0 +1,39 @@
+#version 310 es
+
+// Calls repeating earlier ones, with the same arguments and no macro
+// (re)defined in between, must expand as those did.
+
+#define F(x) (x + 1)
+#define G(a, b) a * b + F(a)
+#define L(x) x __LINE__
+#define P(a, b) a ## b ## 0
+#define SELF(x) SELF
+#define TAIL(x) x F
+#define H(x) H2(x)
+#define H2(x) x
+#define E()
+#define OBJ F(9)
+
+int a = F(1) + F(1) + F(1);
+int b = G(2, 3) + G(2, 3) + G(2,3) + G(2, 3);
+int c = L(1) +
+        L(1) +
+        L(1);
+int d = P(x, y) + P(x, y) + P(x, y);
+int e = SELF(1) (2) + SELF(1) (2) + SELF(1) (2);
+int f = TAIL(1) (3) + TAIL(1) (3) + TAIL(1) (3);
+int g = H(4) + H(4) + H(4) + OBJ + OBJ + OBJ;
+int h = E() 1 + E() 1 + E() 1;
+
+#undef F
+#define F(x) (x - 1)
+
+int i = F(1) + F(1) + F(1) + G(2, 3) + G(2, 3);
+int j = F(
+1) + F(1
+) + F(1);
+
+#define LP (
+#define MID(x) H LP x )
+
+int k = MID(5) + MID(5) + MID(5);
@@ -0,0 +1,17 @@
+#version 310 es
+
+// Calls repeating earlier ones must report what those reported, too.
+
+#define BAD(a, b) (a ## b + 1)
+#define BAD2(x) BAD(x, x)
+#define OK(x) (x + 1)
+
+int a = OK(1) + OK(1) + OK(1);
+int b = BAD(;, ;) + BAD(;, ;) + BAD(;, ;);
+int c = BAD(-, ;) + BAD(-, ;) + BAD(-, ;);
+int e = BAD2(~) + BAD2(~) + BAD2(~);
+int d = OK(1) + OK(1);
+
+void main()
+{
+}
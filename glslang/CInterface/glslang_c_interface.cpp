@@ -44,6 +44,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "glslang/MachineIndependent/Versions.h"
 #include "glslang/MachineIndependent/localintermediate.h"
 
+#include <atomic>
+#ifndef DISABLE_THREAD_SUPPORT
+#include <mutex>
+#endif
+
 static_assert(int(GLSLANG_STAGE_COUNT) == EShLangCount, "");
 static_assert(int(GLSLANG_STAGE_MASK_COUNT) == EShLanguageMaskCount, "");
 static_assert(int(GLSLANG_SOURCE_COUNT) == glslang::EShSourceCount, "");
@@ -60,16 +65,20 @@ static_assert(sizeof(glslang_limits_t) == sizeof(TLimits), "");
 static_assert(sizeof(glslang_resource_t) == sizeof(TBuiltInResource), "");
 static_assert(sizeof(glslang_version_t) == sizeof(glslang::Version), "");
 
+class CallbackPageAllocator;
+
 typedef struct glslang_shader_s {
     glslang::TShader* shader;
     std::string preprocessedGLSL;
     std::vector<std::string> baseResourceSetBinding;
+    CallbackPageAllocator* pageAllocator;
 } glslang_shader_t;
 
 typedef struct glslang_program_s {
     glslang::TProgram* program;
     std::vector<unsigned int> spirv;
     std::string loggerMessages;
+    CallbackPageAllocator* pageAllocator;
 } glslang_program_t;
 
 /* Wrapper/Adapter for C glsl_include_callbacks_t functions
@@ -147,6 +156,60 @@ private:
     void* context;
 };
 
+/* Wrapper/Adapter for C glslang_page_allocator_t callbacks
+
+   Each is counted as used by the memory it handed out, by the glslang_shader_t and
+   glslang_program_t objects created while it was installed, and by being installed,
+   and deletes itself when none of those is left.
+*/
+class CallbackPageAllocator : public glslang::TPageAllocator {
+public:
+    CallbackPageAllocator(const glslang_page_allocator_t& _callbacks) : callbacks(_callbacks), uses(1) {}
+
+    virtual void* allocate(size_t bytes) override
+    {
+        ++uses;
+        void* memory = callbacks.allocate(callbacks.ctx, bytes);
+        if (memory == nullptr)
+            release();
+        return memory;
+    }
+    virtual void deallocate(void* memory, size_t bytes) override
+    {
+        callbacks.deallocate(callbacks.ctx, memory, bytes);
+        release();
+    }
+
+    void acquire() { ++uses; }
+    void release()
+    {
+        if (--uses == 0)
+            delete this;
+    }
+
+private:
+    glslang_page_allocator_t callbacks;
+    std::atomic<size_t> uses;
+};
+
+/* The installed adapter, if any */
+static CallbackPageAllocator* InstalledPageAllocator = nullptr;
+#ifndef DISABLE_THREAD_SUPPORT
+static std::mutex InstalledPageAllocatorLock;
+#endif
+
+/* Take a use of the installed adapter, for a new glslang_shader_t or glslang_program_t */
+static CallbackPageAllocator* acquire_page_allocator()
+{
+#ifndef DISABLE_THREAD_SUPPORT
+    std::lock_guard<std::mutex> guard(InstalledPageAllocatorLock);
+#endif
+    if (InstalledPageAllocator != nullptr)
+        InstalledPageAllocator->acquire();
+
+    return InstalledPageAllocator;
+}
+
 GLSLANG_EXPORT void glslang_get_version(glslang_version_t* version)
 {
     *reinterpret_cast<glslang::Version*>(version) = glslang::GetVersion();
@@ -323,6 +386,32 @@ static EProfile c_shader_profile(glslang_profile_t profile)
     return EProfile();
 }
 
+GLSLANG_EXPORT int glslang_prewarm_builtins(const glslang_target_tuple_t* targets, size_t count, int threads)
+{
+    std::vector<glslang::TargetTuple> tuples(count);
+    for (size_t t = 0; t < count; ++t) {
+        tuples[t].version = targets[t].version;
+        tuples[t].profile = c_shader_profile(targets[t].profile);
+        tuples[t].client = c_shader_client(targets[t].client);
+        tuples[t].vulkanRulesRelaxed = targets[t].vulkan_rules_relaxed;
+        tuples[t].source = c_shader_source(targets[t].source);
+    }
+
+    return static_cast<int>(glslang::PrewarmBuiltins(tuples, threads));
+}
+
+GLSLANG_EXPORT void glslang_set_page_allocator(const glslang_page_allocator_t* allocator)
+{
+#ifndef DISABLE_THREAD_SUPPORT
+    std::lock_guard<std::mutex> guard(InstalledPageAllocatorLock);
+#endif
+    CallbackPageAllocator* previous = InstalledPageAllocator;
+    InstalledPageAllocator = allocator != nullptr ? new CallbackPageAllocator(*allocator) : nullptr;
+    glslang::SetPageAllocator(InstalledPageAllocator);
+    if (previous != nullptr)
+        previous->release();
+}
+
 GLSLANG_EXPORT glslang_shader_t* glslang_shader_create(const glslang_input_t* input)
 {
     if (!input || !input->code) {
@@ -336,6 +425,7 @@ GLSLANG_EXPORT glslang_shader_t* glslang_shader_create(const glslang_input_t* in
 
     glslang_shader_t* shader = new glslang_shader_t();
 
+    shader->pageAllocator = acquire_page_allocator();
     shader->shader = new glslang::TShader(c_shader_stage(input->stage));
     shader->shader->setStrings(&input->code, 1);
     shader->shader->setEnvInput(c_shader_source(input->language), c_shader_stage(input->stage),
@@ -383,6 +473,11 @@ GLSLANG_EXPORT void glslang_shader_set_glsl_version(glslang_shader_t* shader, in
     shader->shader->setOverrideVersion(version);
 }
 
+GLSLANG_EXPORT void glslang_shader_set_memory_limit(glslang_shader_t* shader, size_t bytes)
+{
+    shader->shader->setMemoryLimit(bytes);
+}
+
 GLSLANG_EXPORT void glslang_shader_set_default_uniform_block_set_and_binding(glslang_shader_t* shader, unsigned int set, unsigned int binding) {
     shader->shader->setGlobalUniformSet(set);
     shader->shader->setGlobalUniformBinding(binding);
@@ -454,12 +549,15 @@ GLSLANG_EXPORT void glslang_shader_delete(glslang_shader_t* shader)
         return;
 
     delete (shader->shader);
+    if (shader->pageAllocator)
+        shader->pageAllocator->release();
     delete (shader);
 }
 
 GLSLANG_EXPORT glslang_program_t* glslang_program_create()
 {
     glslang_program_t* p = new glslang_program_t();
+    p->pageAllocator = acquire_page_allocator();
     p->program = new glslang::TProgram();
     return p;
 }
@@ -470,6 +568,8 @@ GLSLANG_EXPORT void glslang_program_delete(glslang_program_t* program)
         return;
 
     delete (program->program);
+    if (program->pageAllocator)
+        program->pageAllocator->release();
     delete (program);
 }
 
@@ -552,7 +552,9 @@ void HlslParseContext::handlePragma(const TSourceLoc& loc, const TVector<TString
 
     // Handle once
     if (lowerTokens[0] == "once") {
-        warn(loc, "not implemented", "#pragma once", "");
+        // the preprocessor handles this in headers
+        if (ppContext == nullptr || ! ppContext->inInclude())
+            warn(loc, "not implemented", "#pragma once", "");
         return;
     }
 }
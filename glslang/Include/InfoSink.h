@@ -68,7 +68,7 @@ enum TOutputStream {
 //
 class TInfoSinkBase {
 public:
-    TInfoSinkBase() : outputStream(4), shaderFileName(nullptr) {}
+    TInfoSinkBase() : outputStream(4), shaderFileName(nullptr), numMessages(0) {}
     void erase() { sink.erase(); }
     TInfoSinkBase& operator<<(const TPersistString& t) { append(t); return *this; }
     TInfoSinkBase& operator<<(char c)                  { append(1, c); return *this; }
@@ -84,7 +84,10 @@ public:
     TInfoSinkBase& operator<<(const TString& t)        { append(t); return *this; }
     TInfoSinkBase& operator+(const char* s)            { append(s); return *this; }
     const char* c_str() const { return sink.c_str(); }
+    // How many messages (of any kind) have been started, whether or not they went to the string.
+    size_t getNumMessages() const { return numMessages; }
     void prefix(TPrefixType message) {
+        ++numMessages;
         switch(message) {
         case EPrefixNone:                                      break;
         case EPrefixWarning:       append("WARNING: ");        break;
@@ -155,6 +158,7 @@ protected:
     TPersistString sink;
     int outputStream;
     const char* shaderFileName;
+    size_t numMessages;
 };
 
 } // end namespace glslang
@@ -67,6 +67,8 @@
 
 namespace glslang {
 
+class TPageAllocator;
+
 // If we are using guard blocks, we must track each individual
 // allocation.  If we aren't using guard blocks, these
 // never get instantiated, so won't have any impact.
@@ -181,6 +183,60 @@ public:
     //
     void* allocate(size_t numBytes);
 
+    //
+    // Call getBytesInUse() for the memory held by pages currently in use,
+    // including what is not yet handed out from the current page.
+    //
+    size_t getBytesInUse() const;
+
+    //
+    // Running totals kept by the pool.  What a stretch of work allocates is the
+    // difference between getStats() before and after it.  peakBytesInUse is the
+    // most getBytesInUse() has been since the last call to resetPeak().
+    //
+    struct TStats {
+        size_t allocations;
+        size_t bytesAllocated;      // as asked for by allocate() callers
+        size_t pagesUsed;           // pages put in use, whether new or reused
+        size_t bytesInUse;
+        size_t peakBytesInUse;
+    };
+    TStats getStats() const;
+    void resetPeak();
+
+    //
+    // Call setLimit() to have isOverLimit() report once the pages in use have held
+    // more than 'bytes' (0 for no limit).  Pages are counted as they are taken, and
+    // isOverLimit() stays true after that, even if pop() gives pages back, until the
+    // limit is set again.  Allocation itself goes on regardless; it is up to users of
+    // the pool to check at points where they can stop their work cleanly.
+    //
+    void setLimit(size_t bytes)
+    {
+        limit = bytes;
+        overLimit = limit != 0 && pagesInUse * pageSize > limit;
+    }
+    bool isOverLimit() const { return overLimit; }
+
+    //
+    // Call setPageCacheLimit() to have each thread keep up to 'bytes' of the
+    // pages pools destroyed on it give up, for new pools to reuse rather than
+    // allocating afresh.  The default is 0, which keeps none.  The limit is for
+    // all threads, but only the calling thread's cache is trimmed to a lower one
+    // right away; any other thread's is the next time a pool gives up a page
+    // on it.  A thread's cache is freed when the thread exits.
+    //
+    static void setPageCacheLimit(size_t bytes);
+
+    // The bytes of pages the calling thread's cache holds.
+    static size_t getPageCacheBytes();
+
+    //
+    // Call setPageAllocator() to have all pools get new memory from 'allocator',
+    // or from the heap for nullptr.  See SetPageAllocator() in ShaderLang.h.
+    //
+    static void setPageAllocator(TPageAllocator* allocator);
+
     //
     // There is no deallocate.  The point of this class is that
     // deallocation can be skipped by the user of it, as the model
@@ -192,11 +248,11 @@ protected:
     friend struct tHeader;
 
     struct tHeader {
-        tHeader(tHeader* nextPage, size_t pageCount) :
+        tHeader(tHeader* nextPage, size_t pageCount, size_t size, TPageAllocator* source) :
 #ifdef GUARD_BLOCKS
         lastAllocation(nullptr),
 #endif
-        nextPage(nextPage), pageCount(pageCount) { }
+        nextPage(nextPage), pageCount(pageCount), size(size), source(source) { }
 
         ~tHeader() {
 #ifdef GUARD_BLOCKS
@@ -210,6 +266,8 @@ protected:
 #endif
         tHeader* nextPage;
         size_t pageCount;
+        size_t size;            // of the memory, for giving it back
+        TPageAllocator* source; // where the memory came from, nullptr for the heap
     };
 
     struct tAllocState {
@@ -231,6 +289,8 @@ protected:
         return TAllocation::offsetAllocation(memory);
     }
 
+    void addPagesInUse(size_t count);
+
     size_t pageSize;        // granularity of allocation from the OS
     size_t alignment;       // all returned allocations will be aligned at
                             //      this granularity, which will be a power of 2
@@ -243,8 +303,13 @@ protected:
     tHeader* inUseList;     // list of all memory currently being used
     tAllocStack stack;      // stack of where to allocate from, to partition pool
 
-    int numCalls;           // just an interesting statistic
-    size_t totalBytes;      // just an interesting statistic
+    size_t numCalls;        // statistics, see getStats()
+    size_t totalBytes;
+    size_t pagesUsed;
+    size_t pagesInUse;
+    size_t peakPagesInUse;
+    size_t limit;
+    bool overLimit;
 private:
     TPoolAllocator& operator=(const TPoolAllocator&);  // don't allow assignment operator
     TPoolAllocator(const TPoolAllocator&);  // don't allow default copy constructor
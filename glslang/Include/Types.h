@@ -47,6 +47,7 @@
 #include "SpirvIntrinsics.h"
 
 #include <algorithm>
+#include <cstring>
 
 namespace glslang {
 
@@ -129,6 +130,8 @@ struct TSampler {   // misnomer now; includes images, textures without sampler,
 
     void clear()
     {
+        // Also zeroes padding, so equal samplers have equal bytes.
+        memset(this, 0, sizeof(*this));
         type = EbtVoid;
         dim = EsdNone;
         arrayed = false;
@@ -491,6 +494,8 @@ public:
 
     void clear()
     {
+        // Also zeroes padding and unused bits, so equal qualifiers have equal bytes.
+        memset(this, 0, sizeof(*this));
         precision = EpqNone;
         invariant = false;
         makeTemporary();
@@ -1747,6 +1752,57 @@ public:
         coopmatKHRUseValid = copyOf.coopmatKHRUseValid;
     }
 
+    // Whether this can't be told apart from a shallowCopy() of 'right': the same values, and
+    // the same shared parts (array sizes, structure, names, ...).  Qualifiers and samplers
+    // are compared bytewise, which relies on their clear() zeroing padding.
+    bool isShallowCopyOf(const TType& right) const
+    {
+        return basicType == right.basicType &&
+               vectorSize == right.vectorSize &&
+               matrixCols == right.matrixCols &&
+               matrixRows == right.matrixRows &&
+               vector1 == right.vector1 &&
+               coopmatNV == right.coopmatNV &&
+               coopmatKHR == right.coopmatKHR &&
+               coopmatKHRuse == right.coopmatKHRuse &&
+               coopmatKHRUseValid == right.coopmatKHRUseValid &&
+               arraySizes == right.arraySizes &&
+               (isStruct() ? structure == right.structure : referentType == right.referentType) &&
+               fieldName == right.fieldName &&
+               typeName == right.typeName &&
+               typeParameters == right.typeParameters &&
+               spirvType == right.spirvType &&
+               memcmp(&sampler, &right.sampler, sizeof(sampler)) == 0 &&
+               memcmp(&qualifier, &right.qualifier, sizeof(qualifier)) == 0;
+    }
+
+    // Consistent with isShallowCopyOf().
+    size_t getShallowHash() const
+    {
+        // FNV-1a, a word at a time
+        const uint64_t prime = 1099511628211ull;
+        uint64_t hash = 14695981039346656037ull;
+        const auto mix = [&hash, prime](const void* bytes, size_t size) {
+            const unsigned char* b = static_cast<const unsigned char*>(bytes);
+            for (; size >= sizeof(uint64_t); b += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, b, sizeof(word));
+                hash = (hash ^ word) * prime;
+            }
+            for (; size > 0; ++b, --size)
+                hash = (hash ^ *b) * prime;
+        };
+        const unsigned int shape = basicType | (vectorSize << 8) | (matrixCols << 12) | (matrixRows << 16);
+        const void* shared[] = { arraySizes, isStruct() ? static_cast<const void*>(structure) : referentType,
+                                 fieldName, typeName };
+        mix(&shape, sizeof(shape));
+        mix(shared, sizeof(shared));
+        mix(&sampler, sizeof(sampler));
+        mix(&qualifier, sizeof(qualifier));
+
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+
     // Make complete copy of the whole type graph rooted at 'copyOf'.
     void deepCopy(const TType& copyOf)
     {
@@ -2805,8 +2861,12 @@ public:
     }
 
     // See if two types match in all ways (just the actual type, not qualification)
+    // Nodes sharing a type (see TNodeTypes) compare without recursing.
     bool operator==(const TType& right) const
     {
+        if (this == &right)
+            return true;
+
         return sameElementType(right) && sameArrayness(right) && sameTypeParameters(right) && sameCoopMatUse(right) && sameSpirvType(right);
     }
 
@@ -2827,6 +2887,10 @@ public:
     const TSpirvType& getSpirvType() const { assert(spirvType); return *spirvType; }
 
 protected:
+    // Built-in symbol table images are written and read member by member.
+    friend class TSymbolTableWriter;
+    friend class TSymbolTableReader;
+
     // Require consumer to pick between deep copy and shallow copy.
     TType(const TType& type);
     TType& operator=(const TType& type);
@@ -344,6 +344,9 @@ struct TArraySizes {
     bool operator!=(const TArraySizes& rhs) const { return sizes != rhs.sizes; }
 
 protected:
+    friend class TSymbolTableWriter;
+    friend class TSymbolTableReader;
+
     TSmallArrayVector sizes;
 
     TArraySizes(const TArraySizes&);
@@ -241,6 +241,28 @@ typedef struct glslang_spv_options_s {
     bool optimize_allow_expanded_id_bound;
 } glslang_spv_options_t;
 
+/* Callback supplying memory for glslang's pools */
+typedef void* (*glslang_allocate_func)(void* ctx, size_t size);
+
+/* Callback taking back memory given out by glslang_allocate_func */
+typedef void (*glslang_deallocate_func)(void* ctx, void* memory, size_t size);
+
+/* TPageAllocator counterpart */
+typedef struct glslang_page_allocator_s {
+    glslang_allocate_func allocate;
+    glslang_deallocate_func deallocate;
+    void* ctx;
+} glslang_page_allocator_t;
+
+/* TargetTuple counterpart */
+typedef struct glslang_target_tuple_s {
+    int version;
+    glslang_profile_t profile;
+    glslang_client_t client;
+    bool vulkan_rules_relaxed;
+    glslang_source_t source;
+} glslang_target_tuple_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -249,6 +271,12 @@ GLSLANG_EXPORT void glslang_get_version(glslang_version_t* version);
 
 GLSLANG_EXPORT int glslang_initialize_process(void);
 GLSLANG_EXPORT void glslang_finalize_process(void);
+GLSLANG_EXPORT int glslang_prewarm_builtins(const glslang_target_tuple_t* targets, size_t count, int threads);
+/* NULL to go back to the heap; see glslang::SetPageAllocator() for how long the callbacks
+   must stay valid.  The copy of 'allocator' is freed once it is no longer installed and all
+   it supplied, and all shaders and programs created while it was installed, are gone.  Not
+   to be called while other threads are in glslang calls. */
+GLSLANG_EXPORT void glslang_set_page_allocator(const glslang_page_allocator_t* allocator);
 
 GLSLANG_EXPORT glslang_shader_t* glslang_shader_create(const glslang_input_t* input);
 GLSLANG_EXPORT void glslang_shader_delete(glslang_shader_t* shader);
@@ -257,6 +285,7 @@ GLSLANG_EXPORT void glslang_shader_shift_binding(glslang_shader_t* shader, glsla
 GLSLANG_EXPORT void glslang_shader_shift_binding_for_set(glslang_shader_t* shader, glslang_resource_type_t res, unsigned int base, unsigned int set);
 GLSLANG_EXPORT void glslang_shader_set_options(glslang_shader_t* shader, int options); // glslang_shader_options_t
 GLSLANG_EXPORT void glslang_shader_set_glsl_version(glslang_shader_t* shader, int version);
+GLSLANG_EXPORT void glslang_shader_set_memory_limit(glslang_shader_t* shader, size_t bytes);
 GLSLANG_EXPORT void glslang_shader_set_default_uniform_block_set_and_binding(glslang_shader_t* shader, unsigned int set, unsigned int binding);
 GLSLANG_EXPORT void glslang_shader_set_default_uniform_block_name(glslang_shader_t* shader, const char *name);
 GLSLANG_EXPORT void glslang_shader_set_resource_set_binding(glslang_shader_t* shader, const char *const *bindings, unsigned int num_bindings);
@@ -1040,39 +1040,52 @@ struct TIntermNodePair {
 //
 // Intermediate class for nodes that have a type.
 //
+// The type is shared with other nodes of the same type when a TNodeTypes table
+// is in effect (see NodeTypes.h), until written to through getWritableType()
+// or the non-const getQualifier().  Those first give the node a copy of its own,
+// so a reference taken from getType() before the write no longer refers to the
+// node's type after it.  Read through getType() where possible.
+//
+// Nodes are not copyable: a copy would alias the original's unshared type.
+//
 class TIntermTyped : public TIntermNode {
 public:
-    TIntermTyped(const TType& t) { type.shallowCopy(t); }
-    TIntermTyped(TBasicType basicType) { TType bt(basicType); type.shallowCopy(bt); }
+    TIntermTyped(const TType& t) { initType(t); }
+    TIntermTyped(TBasicType basicType) { TType bt(basicType); initType(bt); }
     virtual       TIntermTyped* getAsTyped()       { return this; }
     virtual const TIntermTyped* getAsTyped() const { return this; }
-    virtual void setType(const TType& t) { type.shallowCopy(t); }
-    virtual const TType& getType() const { return type; }
-    virtual TType& getWritableType() { return type; }
-
-    virtual TBasicType getBasicType() const { return type.getBasicType(); }
-    virtual TQualifier& getQualifier() { return type.getQualifier(); }
-    virtual const TQualifier& getQualifier() const { return type.getQualifier(); }
-    virtual TArraySizes* getArraySizes() { return type.getArraySizes(); }
-    virtual const TArraySizes* getArraySizes() const { return type.getArraySizes(); }
+    virtual void setType(const TType& t);
+    virtual const TType& getType() const { return *type; }
+    virtual TType& getWritableType();
+
+    virtual TBasicType getBasicType() const { return type->getBasicType(); }
+    virtual TQualifier& getQualifier() { return getWritableType().getQualifier(); }
+    virtual const TQualifier& getQualifier() const { return type->getQualifier(); }
+    virtual TArraySizes* getArraySizes() { return type->getArraySizes(); }
+    virtual const TArraySizes* getArraySizes() const { return type->getArraySizes(); }
     virtual void propagatePrecision(TPrecisionQualifier);
-    virtual int getVectorSize() const { return type.getVectorSize(); }
-    virtual int getMatrixCols() const { return type.getMatrixCols(); }
-    virtual int getMatrixRows() const { return type.getMatrixRows(); }
-    virtual bool isMatrix() const { return type.isMatrix(); }
-    virtual bool isArray()  const { return type.isArray(); }
-    virtual bool isVector() const { return type.isVector(); }
-    virtual bool isScalar() const { return type.isScalar(); }
-    virtual bool isStruct() const { return type.isStruct(); }
-    virtual bool isFloatingDomain() const { return type.isFloatingDomain(); }
-    virtual bool isIntegerDomain() const { return type.isIntegerDomain(); }
-    bool isAtomic() const { return type.isAtomic(); }
-    bool isReference() const { return type.isReference(); }
-    TString getCompleteString(bool enhanced = false) const { return type.getCompleteString(enhanced); }
+    void setPrecision(TPrecisionQualifier);
+    virtual int getVectorSize() const { return type->getVectorSize(); }
+    virtual int getMatrixCols() const { return type->getMatrixCols(); }
+    virtual int getMatrixRows() const { return type->getMatrixRows(); }
+    virtual bool isMatrix() const { return type->isMatrix(); }
+    virtual bool isArray()  const { return type->isArray(); }
+    virtual bool isVector() const { return type->isVector(); }
+    virtual bool isScalar() const { return type->isScalar(); }
+    virtual bool isStruct() const { return type->isStruct(); }
+    virtual bool isFloatingDomain() const { return type->isFloatingDomain(); }
+    virtual bool isIntegerDomain() const { return type->isIntegerDomain(); }
+    bool isAtomic() const { return type->isAtomic(); }
+    bool isReference() const { return type->isReference(); }
+    TString getCompleteString(bool enhanced = false) const { return type->getCompleteString(enhanced); }
 
 protected:
+    TIntermTyped(const TIntermTyped&);
     TIntermTyped& operator=(const TIntermTyped&);
-    TType type;
+    void initType(const TType&);
+
+    TType* type;
+    TPoolAllocator* sharedPool;  // where 'type' is, if shared with other nodes; else nullptr
 };
 
 //
@@ -1295,11 +1308,11 @@ public:
     void setOperationPrecision(TPrecisionQualifier p) { operationPrecision = p; }
     TPrecisionQualifier getOperationPrecision() const { return operationPrecision != EpqNone ?
                                                                                      operationPrecision :
-                                                                                     type.getQualifier().precision; }
+                                                                                     type->getQualifier().precision; }
     TString getCompleteString() const
     {
-        TString cs = type.getCompleteString();
-        if (getOperationPrecision() != type.getQualifier().precision) {
+        TString cs = type->getCompleteString();
+        if (getOperationPrecision() != type->getQualifier().precision) {
             cs += ", operation at ";
             cs += GetPrecisionQualifierString(getOperationPrecision());
         }
@@ -1694,6 +1707,12 @@ enum TVisit
 //
 // If you process children yourself, or don't want them processed, return false.
 //
+// The traversal recurses down the tree only so far, and below that keeps its
+// own stack of the nodes it is in the middle of, so deep trees don't exhaust
+// the native stack.  Calling traverse() on a node from within a visit*()
+// method starts a nested traversal of that subtree, which completes before the
+// call returns.
+//
 class TIntermTraverser {
 public:
     POOL_ALLOCATOR_NEW_DELETE(glslang::GetThreadPoolAllocator())
@@ -1703,7 +1722,9 @@ public:
             postVisit(postVisit),
             rightToLeft(rightToLeft),
             depth(0),
-            maxDepth(0) { }
+            maxDepth(0),
+            recursion(0),
+            entry(EntryRoot) { }
     virtual ~TIntermTraverser() { }
 
     virtual void visitSymbol(TIntermSymbol*)               { }
@@ -1736,6 +1757,49 @@ public:
         return path.size() == 0 ? nullptr : path.back();
     }
 
+    // The traversal engine, for the TIntermNode::traverse() overrides.  Down to
+    // a depth of maxRecursion, a node's traverse() traverses its children by
+    // recursing.  Below that, it is called on entering the node, and again each
+    // time the engine gets back to it, to take the next step through them.
+    static const int maxRecursion = 128;
+    enum TEntry {
+        EntryRoot,          // traverse() was called from outside the engine
+        EntryChild,         // the engine is entering the node as a child
+        EntryResume         // the engine is getting back to the node
+    };
+    struct TFrame {
+        TIntermNode* node;
+        int next;           // the next child (or child slot) to go to
+        bool visit;         // result of the last visit; false cancels later visits
+    };
+    TEntry takeEntry()
+    {
+        const TEntry taken = entry;
+        entry = EntryRoot;
+        return taken;
+    }
+    // Start on the children of a node, returning false if the caller is to
+    // traverse them itself and then call leaveChildren(), or true if they are
+    // left to the engine.
+    bool enterChildren(TIntermNode* node, TEntry nodeEntry)
+    {
+        incrementDepth(node);
+        if (recursion < maxRecursion) {
+            ++recursion;
+            return false;
+        }
+        pushFrame(node, nodeEntry);
+        return true;
+    }
+    void leaveChildren()
+    {
+        --recursion;
+        decrementDepth();
+    }
+    bool descend(TIntermNode* child);
+    TFrame& topFrame() { return frames.back(); }
+    bool exitChildren();
+
     const bool preVisit;
     const bool inVisit;
     const bool postVisit;
@@ -1749,6 +1813,14 @@ protected:
 
     // All the nodes from root to the current node's parent during traversing.
     TVector<TIntermNode *> path;
+
+private:
+    void pushFrame(TIntermNode*, TEntry);
+    void run(size_t base);
+
+    int recursion;          // how many traverse() calls are recursing on their children
+    TVector<TFrame> frames; // the nodes with children the engine is in the middle of
+    TEntry entry;           // how the next traverse() call is being made
 };
 
 // KHR_vulkan_glsl says "Two arrays sized with specialization constants are the same type only if
@@ -48,6 +48,13 @@ using namespace glslang;
 
 const double pi = 3.1415926535897932384626433832795;
 
+// Folding allocates without reading tokens, where the memory limit is checked,
+// so it stops itself, leaving operations unfolded, once the limit is exceeded.
+bool OverMemoryLimit()
+{
+    return GetThreadPoolAllocator().isOverLimit();
+}
+
 } // end anonymous namespace
 
 
@@ -71,6 +78,9 @@ namespace glslang {
 //
 TIntermTyped* TIntermConstantUnion::fold(TOperator op, const TIntermTyped* rightConstantNode) const
 {
+    if (OverMemoryLimit())
+        return nullptr;
+
     // For most cases, the return type matches the argument type, so set that
     // up and just code to exceptions below.
     TType returnType;
@@ -366,6 +376,9 @@ TIntermTyped* TIntermConstantUnion::fold(TOperator op, const TIntermTyped* right
 //
 TIntermTyped* TIntermConstantUnion::fold(TOperator op, const TType& returnType) const
 {
+    if (OverMemoryLimit())
+        return nullptr;
+
     // First, size the result, which is mostly the same as the argument's size,
     // but not always, and classify what is componentwise.
     // Also, eliminate cases that can't be compile-time constant.
@@ -845,7 +858,7 @@ TIntermTyped* TIntermediate::fold(TIntermAggregate* aggrNode)
     if (aggrNode == nullptr)
         return aggrNode;
 
-    if (! areAllChildConst(aggrNode))
+    if (! areAllChildConst(aggrNode) || OverMemoryLimit())
         return aggrNode;
 
     if (aggrNode->isConstructor())
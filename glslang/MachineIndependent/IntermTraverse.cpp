@@ -42,7 +42,6 @@ namespace glslang {
 //
 // Traverse the intermediate representation tree, and
 // call a node type specific function for each node.
-// Done recursively through the member function Traverse().
 // Node types can be skipped if their function to call is 0,
 // but their subtree will still be traversed.
 // Nodes with children can have their whole subtree skipped
@@ -52,22 +51,34 @@ namespace glslang {
 // preVisit, postVisit, and rightToLeft control what order
 // nodes are visited in.
 //
+// This is done recursively through the member function traverse(), but only
+// down to a depth of TIntermTraverser::maxRecursion, which ordinary trees
+// don't reach.  Below that, the traverser keeps a stack of frames for the
+// nodes with children it is in the middle of, and loops over it: each time
+// round, the node on top takes its next step, by calling its own traverse()
+// again.  A step enters children until one pushes a frame of its own
+// (terminals and skipped subtrees don't), or finishes the node.  So the native
+// stack stays within a fixed depth however deep the tree is.
+//
 
 //
 // Traversal functions for terminals are straightforward....
 //
-void TIntermMethod::traverse(TIntermTraverser*)
+void TIntermMethod::traverse(TIntermTraverser* it)
 {
     // Tree should always resolve all methods as a non-method.
+    it->takeEntry();
 }
 
 void TIntermSymbol::traverse(TIntermTraverser *it)
 {
+    it->takeEntry();
     it->visitSymbol(this);
 }
 
 void TIntermConstantUnion::traverse(TIntermTraverser *it)
 {
+    it->takeEntry();
     it->visitConstantUnion(this);
 }
 
@@ -83,20 +94,22 @@ const TString& TIntermSymbol::getAccessName() const {
 //
 void TIntermBinary::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
-
-    //
-    // visit the node before children if pre-visiting.
-    //
-    if (it->preVisit)
-        visit = it->visitBinary(EvPreVisit, this);
-
-    //
-    // Visit the children, in the right order.
-    //
-    if (visit) {
-        it->incrementDepth(this);
-
+    const TIntermTraverser::TEntry entry = it->takeEntry();
+
+    if (entry != TIntermTraverser::EntryResume) {
+        //
+        // visit the node before children if pre-visiting.
+        //
+        if (it->preVisit && ! it->visitBinary(EvPreVisit, this))
+            return;
+
+        if (it->enterChildren(this, entry))
+            return;
+
+        //
+        // Visit the children, in the right order.
+        //
+        bool visit = true;
         if (it->rightToLeft) {
             if (right)
                 right->traverse(it);
@@ -117,14 +130,42 @@ void TIntermBinary::traverse(TIntermTraverser *it)
                 right->traverse(it);
         }
 
-        it->decrementDepth();
+        it->leaveChildren();
+
+        //
+        // Visit the node after the children, if requested and the traversal
+        // hasn't been canceled yet.
+        //
+        if (visit && it->postVisit)
+            it->visitBinary(EvPostVisit, this);
+        return;
     }
 
     //
-    // Visit the node after the children, if requested and the traversal
-    // hasn't been canceled yet.
+    // Or take the next step through the children, for the engine.
     //
-    if (visit && it->postVisit)
+    switch (it->topFrame().next) {
+    case 0:
+        it->topFrame().next = 1;
+        if (it->descend(it->rightToLeft ? right : left))
+            return;
+        [[fallthrough]];
+    case 1:
+        if (it->inVisit) {
+            const bool visit = it->visitBinary(EvInVisit, this);
+            it->topFrame().visit = visit;
+            if (! visit)
+                break;
+        }
+        it->topFrame().next = 2;
+        if (it->descend(it->rightToLeft ? left : right))
+            return;
+        [[fallthrough]];
+    default:
+        break;
+    }
+
+    if (it->exitChildren() && it->postVisit)
         it->visitBinary(EvPostVisit, this);
 }
 
@@ -133,18 +174,27 @@ void TIntermBinary::traverse(TIntermTraverser *it)
 //
 void TIntermUnary::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
+    const TIntermTraverser::TEntry entry = it->takeEntry();
 
-    if (it->preVisit)
-        visit = it->visitUnary(EvPreVisit, this);
+    if (entry != TIntermTraverser::EntryResume) {
+        if (it->preVisit && ! it->visitUnary(EvPreVisit, this))
+            return;
+
+        if (it->enterChildren(this, entry))
+            return;
 
-    if (visit) {
-        it->incrementDepth(this);
         operand->traverse(it);
-        it->decrementDepth();
+        it->leaveChildren();
+
+        if (it->postVisit)
+            it->visitUnary(EvPostVisit, this);
+        return;
     }
 
-    if (visit && it->postVisit)
+    if (it->topFrame().next++ == 0 && it->descend(operand))
+        return;
+
+    if (it->exitChildren() && it->postVisit)
         it->visitUnary(EvPostVisit, this);
 }
 
@@ -153,14 +203,16 @@ void TIntermUnary::traverse(TIntermTraverser *it)
 //
 void TIntermAggregate::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
+    const TIntermTraverser::TEntry entry = it->takeEntry();
 
-    if (it->preVisit)
-        visit = it->visitAggregate(EvPreVisit, this);
+    if (entry != TIntermTraverser::EntryResume) {
+        if (it->preVisit && ! it->visitAggregate(EvPreVisit, this))
+            return;
 
-    if (visit) {
-        it->incrementDepth(this);
+        if (it->enterChildren(this, entry))
+            return;
 
+        bool visit = true;
         if (it->rightToLeft) {
             for (TIntermSequence::reverse_iterator sit = sequence.rbegin(); sit != sequence.rend(); sit++) {
                 (*sit)->traverse(it);
@@ -181,10 +233,35 @@ void TIntermAggregate::traverse(TIntermTraverser *it)
             }
         }
 
-        it->decrementDepth();
+        it->leaveChildren();
+
+        if (visit && it->postVisit)
+            it->visitAggregate(EvPostVisit, this);
+        return;
+    }
+
+    for (;;) {
+        TIntermTraverser::TFrame* frame = &it->topFrame();
+        const int size = (int)sequence.size();
+
+        // In-visit between children, i.e., after each one but the last.
+        if (frame->next > 0 && frame->visit && it->inVisit) {
+            const int done = it->rightToLeft ? size - frame->next : frame->next - 1;
+            if (sequence[done] != (it->rightToLeft ? sequence.front() : sequence.back())) {
+                const bool visit = it->visitAggregate(EvInVisit, this);
+                frame = &it->topFrame();
+                frame->visit = visit;
+            }
+        }
+
+        if (frame->next == size)
+            break;
+        const int child = frame->next++;
+        if (it->descend(sequence[it->rightToLeft ? size - 1 - child : child]))
+            return;
     }
 
-    if (visit && it->postVisit)
+    if (it->exitChildren() && it->postVisit)
         it->visitAggregate(EvPostVisit, this);
 }
 
@@ -193,13 +270,15 @@ void TIntermAggregate::traverse(TIntermTraverser *it)
 //
 void TIntermSelection::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
+    const TIntermTraverser::TEntry entry = it->takeEntry();
 
-    if (it->preVisit)
-        visit = it->visitSelection(EvPreVisit, this);
+    if (entry != TIntermTraverser::EntryResume) {
+        if (it->preVisit && ! it->visitSelection(EvPreVisit, this))
+            return;
+
+        if (it->enterChildren(this, entry))
+            return;
 
-    if (visit) {
-        it->incrementDepth(this);
         if (it->rightToLeft) {
             if (falseBlock)
                 falseBlock->traverse(it);
@@ -213,10 +292,34 @@ void TIntermSelection::traverse(TIntermTraverser *it)
             if (falseBlock)
                 falseBlock->traverse(it);
         }
-        it->decrementDepth();
+        it->leaveChildren();
+
+        if (it->postVisit)
+            it->visitSelection(EvPostVisit, this);
+        return;
     }
 
-    if (visit && it->postVisit)
+    switch (it->topFrame().next) {
+    case 0:
+        it->topFrame().next = 1;
+        if (it->descend(it->rightToLeft ? falseBlock : condition))
+            return;
+        [[fallthrough]];
+    case 1:
+        it->topFrame().next = 2;
+        if (it->descend(trueBlock))
+            return;
+        [[fallthrough]];
+    case 2:
+        it->topFrame().next = 3;
+        if (it->descend(it->rightToLeft ? condition : falseBlock))
+            return;
+        [[fallthrough]];
+    default:
+        break;
+    }
+
+    if (it->exitChildren() && it->postVisit)
         it->visitSelection(EvPostVisit, this);
 }
 
@@ -225,13 +328,14 @@ void TIntermSelection::traverse(TIntermTraverser *it)
 //
 void TIntermLoop::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
+    const TIntermTraverser::TEntry entry = it->takeEntry();
 
-    if (it->preVisit)
-        visit = it->visitLoop(EvPreVisit, this);
+    if (entry != TIntermTraverser::EntryResume) {
+        if (it->preVisit && ! it->visitLoop(EvPreVisit, this))
+            return;
 
-    if (visit) {
-        it->incrementDepth(this);
+        if (it->enterChildren(this, entry))
+            return;
 
         if (it->rightToLeft) {
             if (terminal)
@@ -253,10 +357,34 @@ void TIntermLoop::traverse(TIntermTraverser *it)
                 terminal->traverse(it);
         }
 
-        it->decrementDepth();
+        it->leaveChildren();
+
+        if (it->postVisit)
+            it->visitLoop(EvPostVisit, this);
+        return;
     }
 
-    if (visit && it->postVisit)
+    switch (it->topFrame().next) {
+    case 0:
+        it->topFrame().next = 1;
+        if (it->descend(it->rightToLeft ? terminal : test))
+            return;
+        [[fallthrough]];
+    case 1:
+        it->topFrame().next = 2;
+        if (it->descend(body))
+            return;
+        [[fallthrough]];
+    case 2:
+        it->topFrame().next = 3;
+        if (it->descend(it->rightToLeft ? test : terminal))
+            return;
+        [[fallthrough]];
+    default:
+        break;
+    }
+
+    if (it->exitChildren() && it->postVisit)
         it->visitLoop(EvPostVisit, this);
 }
 
@@ -265,18 +393,29 @@ void TIntermLoop::traverse(TIntermTraverser *it)
 //
 void TIntermBranch::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
+    const TIntermTraverser::TEntry entry = it->takeEntry();
+
+    if (entry != TIntermTraverser::EntryResume) {
+        if (it->preVisit && ! it->visitBranch(EvPreVisit, this))
+            return;
+
+        if (expression != nullptr) {
+            if (it->enterChildren(this, entry))
+                return;
 
-    if (it->preVisit)
-        visit = it->visitBranch(EvPreVisit, this);
+            expression->traverse(it);
+            it->leaveChildren();
+        }
 
-    if (visit && expression) {
-        it->incrementDepth(this);
-        expression->traverse(it);
-        it->decrementDepth();
+        if (it->postVisit)
+            it->visitBranch(EvPostVisit, this);
+        return;
     }
 
-    if (visit && it->postVisit)
+    if (it->topFrame().next++ == 0 && it->descend(expression))
+        return;
+
+    if (it->exitChildren() && it->postVisit)
         it->visitBranch(EvPostVisit, this);
 }
 
@@ -285,13 +424,15 @@ void TIntermBranch::traverse(TIntermTraverser *it)
 //
 void TIntermSwitch::traverse(TIntermTraverser* it)
 {
-    bool visit = true;
+    const TIntermTraverser::TEntry entry = it->takeEntry();
 
-    if (it->preVisit)
-        visit = it->visitSwitch(EvPreVisit, this);
+    if (entry != TIntermTraverser::EntryResume) {
+        if (it->preVisit && ! it->visitSwitch(EvPreVisit, this))
+            return;
+
+        if (it->enterChildren(this, entry))
+            return;
 
-    if (visit) {
-        it->incrementDepth(this);
         if (it->rightToLeft) {
             body->traverse(it);
             condition->traverse(it);
@@ -299,11 +440,85 @@ void TIntermSwitch::traverse(TIntermTraverser* it)
             condition->traverse(it);
             body->traverse(it);
         }
-        it->decrementDepth();
+        it->leaveChildren();
+
+        if (it->postVisit)
+            it->visitSwitch(EvPostVisit, this);
+        return;
     }
 
-    if (visit && it->postVisit)
+    switch (it->topFrame().next) {
+    case 0:
+        it->topFrame().next = 1;
+        if (it->descend(it->rightToLeft ? body : condition))
+            return;
+        [[fallthrough]];
+    case 1:
+        it->topFrame().next = 2;
+        if (it->descend(it->rightToLeft ? condition : body))
+            return;
+        [[fallthrough]];
+    default:
+        break;
+    }
+
+    if (it->exitChildren() && it->postVisit)
         it->visitSwitch(EvPostVisit, this);
 }
 
+//
+// Push a frame for a node whose children are left to the engine.  If the
+// node is a root, rather than a child the engine is entering, loop until
+// its frame is done; this is where the engine starts, including for
+// traversals that visit functions start themselves.
+//
+void TIntermTraverser::pushFrame(TIntermNode* node, TEntry nodeEntry)
+{
+    frames.push_back({ node, 0, true });
+    if (nodeEntry == EntryRoot)
+        run(frames.size() - 1);
+}
+
+//
+// Enter a child of the node on top of the stack, if it has that child.
+// Returns whether the child pushed a frame of its own, and so is still to be
+// traversed; otherwise the node can go straight on to its next step.
+//
+bool TIntermTraverser::descend(TIntermNode* child)
+{
+    if (child == nullptr)
+        return false;
+
+    const size_t depth = frames.size();
+    entry = EntryChild;
+    child->traverse(this);
+    entry = EntryRoot;
+
+    return frames.size() != depth;
+}
+
+//
+// Pop the frame of a node whose children are done, returning whether the
+// node is still to be visited.
+//
+bool TIntermTraverser::exitChildren()
+{
+    decrementDepth();
+    const bool visit = frames.back().visit;
+    frames.pop_back();
+
+    return visit;
+}
+
+//
+// Step the nodes on the stack above 'base' until the one at 'base' is done.
+//
+void TIntermTraverser::run(size_t base)
+{
+    while (frames.size() > base) {
+        entry = EntryResume;
+        frames.back().node->traverse(this);
+    }
+}
+
 } // end namespace glslang
@@ -43,11 +43,13 @@
 #include "localintermediate.h"
 #include "RemoveTree.h"
 #include "SymbolTable.h"
+#include "NodeTypes.h"
 #include "propagateNoContraction.h"
 
 #include <cfloat>
 #include <utility>
 #include <tuple>
+#include <unordered_set>
 
 namespace glslang {
 
@@ -218,7 +220,7 @@ TIntermTyped* TIntermediate::addBinaryMath(TOperator op, TIntermTyped* left, TIn
         node->getWritableType().getQualifier().makeSpecConstant();
 
     // If must propagate nonuniform, make a nonuniform.
-    if ((node->getLeft()->getQualifier().isNonUniform() || node->getRight()->getQualifier().isNonUniform()) &&
+    if ((node->getLeft()->getType().getQualifier().isNonUniform() || node->getRight()->getType().getQualifier().isNonUniform()) &&
             isNonuniformPropagating(node->getOp()))
         node->getWritableType().getQualifier().nonUniform = true;
 
@@ -456,7 +458,7 @@ TIntermTyped* TIntermediate::addUnaryMath(TOperator op, TIntermTyped* child,
         node->getWritableType().getQualifier().makeSpecConstant();
 
     // If must propagate nonuniform, make a nonuniform.
-    if (node->getOperand()->getQualifier().isNonUniform() && isNonuniformPropagating(node->getOp()))
+    if (node->getOperand()->getType().getQualifier().isNonUniform() && isNonuniformPropagating(node->getOp()))
         node->getWritableType().getQualifier().nonUniform = true;
 
     return node;
@@ -2314,7 +2316,7 @@ TIntermTyped* TIntermediate::addSelection(TIntermTyped* cond, TIntermTyped* true
     //
     TIntermSelection* node = new TIntermSelection(cond, trueBlock, falseBlock, trueBlock->getType());
     node->setLoc(loc);
-    node->getQualifier().precision = std::max(trueBlock->getQualifier().precision, falseBlock->getQualifier().precision);
+    node->setPrecision(std::max(trueBlock->getType().getQualifier().precision, falseBlock->getType().getQualifier().precision));
 
     if ((cond->getQualifier().isConstant() && specConstantPropagates(*trueBlock, *falseBlock)) ||
         (cond->getQualifier().isSpecConstant() && trueBlock->getQualifier().isConstant() &&
@@ -2337,8 +2339,10 @@ TIntermTyped* TIntermediate::addSelection(TIntermTyped* cond, TIntermTyped* true
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(const TConstUnionArray& unionArray, const TType& t, const TSourceLoc& loc, bool literal) const
 {
-    TIntermConstantUnion* node = new TIntermConstantUnion(unionArray, t);
-    node->getQualifier().storage = EvqConst;
+    TType type;
+    type.shallowCopy(t);
+    type.getQualifier().storage = EvqConst;
+    TIntermConstantUnion* node = new TIntermConstantUnion(unionArray, type);
     node->setLoc(loc);
     if (literal)
         node->setLiteral();
@@ -2591,7 +2595,7 @@ void TIntermBranch::updatePrecision(TPrecisionQualifier parentPrecision)
 
     if (exp->getBasicType() == EbtInt || exp->getBasicType() == EbtUint ||
         exp->getBasicType() == EbtFloat) {
-        if (parentPrecision != EpqNone && exp->getQualifier().precision == EpqNone) {
+        if (parentPrecision != EpqNone && exp->getType().getQualifier().precision == EpqNone) {
             exp->propagatePrecision(parentPrecision);
         }
     }
@@ -3011,8 +3015,10 @@ bool TIntermediate::promoteUnary(TIntermUnary& node)
             return false;
     }
 
-    node.setType(operand->getType());
-    node.getWritableType().getQualifier().makeTemporary();
+    TType type;
+    type.shallowCopy(operand->getType());
+    type.getQualifier().makeTemporary();
+    node.setType(type);
 
     return true;
 }
@@ -3022,8 +3028,8 @@ void TIntermUnary::updatePrecision()
 {
     if (getBasicType() == EbtInt || getBasicType() == EbtUint ||
         getBasicType() == EbtFloat) {
-        if (operand->getQualifier().precision > getQualifier().precision)
-            getQualifier().precision = operand->getQualifier().precision;
+        if (operand->getType().getQualifier().precision > getType().getQualifier().precision)
+            setPrecision(operand->getType().getQualifier().precision);
     }
 }
 
@@ -3043,8 +3049,10 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
 
     // Base assumption:  just make the type the same as the left
     // operand.  Only deviations from this will be coded.
-    node.setType(left->getType());
-    node.getWritableType().getQualifier().clear();
+    TType type;
+    type.shallowCopy(left->getType());
+    type.getQualifier().clear();
+    node.setType(type);
 
     // Composite and opaque types don't having pending operator changes, e.g.,
     // array, structure, and samplers.  Just establish final type and correctness.
@@ -3109,8 +3117,9 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
             node.setRight(right);
 
             // Update the original base assumption on result type..
-            node.setType(left->getType());
-            node.getWritableType().getQualifier().clear();
+            type.shallowCopy(left->getType());
+            type.getQualifier().clear();
+            node.setType(type);
 
             break;
 
@@ -3422,8 +3431,9 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
         if (left->isVector() && right->isVector() && left->getVectorSize() != right->getVectorSize())
             return false;
         if (right->isVector() || right->isMatrix()) {
-            node.getWritableType().shallowCopy(right->getType());
-            node.getWritableType().getQualifier().makeTemporary();
+            type.shallowCopy(right->getType());
+            type.getQualifier().makeTemporary();
+            node.setType(type);
         }
         break;
 
@@ -3538,9 +3548,9 @@ void TIntermAggregate::updatePrecision()
         for (unsigned int i = 0; i < operands.size(); ++i) {
             TIntermTyped* typedNode = operands[i]->getAsTyped();
             assert(typedNode);
-            maxPrecision = std::max(maxPrecision, typedNode->getQualifier().precision);
+            maxPrecision = std::max(maxPrecision, typedNode->getType().getQualifier().precision);
         }
-        getQualifier().precision = maxPrecision;
+        setPrecision(maxPrecision);
         for (unsigned int i = 0; i < operands.size(); ++i) {
           TIntermTyped* typedNode = operands[i]->getAsTyped();
           assert(typedNode);
@@ -3557,28 +3567,81 @@ void TIntermBinary::updatePrecision()
          getBasicType() == EbtFloat) {
        if (op == EOpRightShift || op == EOpLeftShift) {
          // For shifts get precision from left side only and thus no need to propagate
-         getQualifier().precision = left->getQualifier().precision;
+         setPrecision(left->getType().getQualifier().precision);
        } else {
-         getQualifier().precision = std::max(right->getQualifier().precision, left->getQualifier().precision);
-         if (getQualifier().precision != EpqNone) {
-           left->propagatePrecision(getQualifier().precision);
-           right->propagatePrecision(getQualifier().precision);
+         setPrecision(std::max(right->getType().getQualifier().precision, left->getType().getQualifier().precision));
+         if (getType().getQualifier().precision != EpqNone) {
+           left->propagatePrecision(getType().getQualifier().precision);
+           right->propagatePrecision(getType().getQualifier().precision);
          }
        }
     }
 }
 
+void TIntermTyped::initType(const TType& t)
+{
+    const TType* shared = TNodeTypes::share(t);
+    if (shared != nullptr) {
+        type = const_cast<TType*>(shared);
+        sharedPool = &GetThreadPoolAllocator();
+    } else {
+        type = new TType;
+        type->shallowCopy(t);
+        sharedPool = nullptr;
+    }
+}
+
+void TIntermTyped::setType(const TType& t)
+{
+    if (sharedPool == &GetThreadPoolAllocator())
+        initType(t);
+    else
+        getWritableType().shallowCopy(t);
+}
+
+// Copy a shared type before it is written to, so other nodes sharing it are
+// not changed.  The copy goes in the pool the node came from, which may not be
+// the current one, e.g., when linking.
+TType& TIntermTyped::getWritableType()
+{
+    if (sharedPool != nullptr) {
+        TType* copy = new (sharedPool->allocate(sizeof(TType))) TType;
+        copy->shallowCopy(*type);
+        type = copy;
+        sharedPool = nullptr;
+    }
+
+    return *type;
+}
+
+// Like getQualifier().precision = p, but keeping the type shared if there is
+// one for the result.
+void TIntermTyped::setPrecision(TPrecisionQualifier p)
+{
+    if (type->getQualifier().precision == p)
+        return;
+
+    if (sharedPool == nullptr)
+        type->getQualifier().precision = p;
+    else {
+        TType newType;
+        newType.shallowCopy(*type);
+        newType.getQualifier().precision = p;
+        setType(newType);
+    }
+}
+
 // Recursively propagate precision qualifiers *down* the subtree of the current node,
 // until reaching a node that already has a precision qualifier or otherwise does
 // not participate in precision propagation.
 void TIntermTyped::propagatePrecision(TPrecisionQualifier newPrecision)
 {
-    if (getQualifier().precision != EpqNone ||
+    if (getType().getQualifier().precision != EpqNone ||
         (getBasicType() != EbtInt && getBasicType() != EbtUint &&
          getBasicType() != EbtFloat && getBasicType() != EbtFloat16))
         return;
 
-    getQualifier().precision = newPrecision;
+    setPrecision(newPrecision);
 
     TIntermBinary* binaryNode = getAsBinaryNode();
     if (binaryNode) {
@@ -3757,5 +3820,83 @@ const char* TIntermediate::getResourceName(TResourceType res)
     }
 }
 
+namespace {
+
+// Counts the nodes of a tree, and the memory they and their types take.
+class TTreeMeasurer : public TIntermTraverser {
+public:
+    explicit TTreeMeasurer(TTreeStats& stats) : stats(stats) { }
+
+    void visitSymbol(TIntermSymbol* node) override { add(node, sizeof(*node)); }
+    void visitConstantUnion(TIntermConstantUnion* node) override { add(node, sizeof(*node)); }
+    bool visitBinary(TVisit, TIntermBinary* node) override { add(node, sizeof(*node)); return true; }
+    bool visitUnary(TVisit, TIntermUnary* node) override { add(node, sizeof(*node)); return true; }
+    bool visitAggregate(TVisit, TIntermAggregate* node) override { add(node, sizeof(*node)); return true; }
+    bool visitSelection(TVisit, TIntermSelection* node) override { add(node, sizeof(*node)); return true; }
+    bool visitSwitch(TVisit, TIntermSwitch* node) override { add(node, sizeof(*node)); return true; }
+    bool visitLoop(TVisit, TIntermLoop* node) override { add(node, sizeof(*node)); return true; }
+    bool visitBranch(TVisit, TIntermBranch* node) override { add(node, sizeof(*node)); return true; }
+
+protected:
+    void add(TIntermNode* node, size_t bytes)
+    {
+        ++stats.nodes;
+        stats.nodeBytes += bytes;
+        const TIntermTyped* typed = node->getAsTyped();
+        if (typed != nullptr && types.insert(&typed->getType()).second)
+            stats.typeBytes += sizeof(TType);
+    }
+
+    TTreeStats& stats;
+    std::unordered_set<const TType*> types;
+};
+
+} // end anonymous namespace
+
+void TIntermediate::getTreeStats(TTreeStats& stats) const
+{
+    if (treeRoot == nullptr)
+        return;
+
+    TTreeMeasurer measurer(stats);
+    treeRoot->traverse(&measurer);
+}
+
+TMemoryPhaseMarker::TMemoryPhaseMarker(TMemoryStats* stats, EShMemoryPhase phase) :
+    stats(stats), pool(GetThreadPoolAllocator())
+{
+    begin(phase);
+}
+
+void TMemoryPhaseMarker::switchTo(EShMemoryPhase newPhase)
+{
+    end();
+    begin(newPhase);
+}
+
+void TMemoryPhaseMarker::begin(EShMemoryPhase newPhase)
+{
+    phase = newPhase;
+    if (stats == nullptr)
+        return;
+
+    pool.resetPeak();
+    start = pool.getStats();
+}
+
+void TMemoryPhaseMarker::end()
+{
+    if (stats == nullptr)
+        return;
+
+    const TPoolAllocator::TStats current = pool.getStats();
+    TMemoryPhaseStats& phaseStats = stats->phases[phase];
+    phaseStats.allocations += current.allocations - start.allocations;
+    phaseStats.bytesAllocated += current.bytesAllocated - start.bytesAllocated;
+    phaseStats.pagesUsed += current.pagesUsed - start.pagesUsed;
+    phaseStats.peakBytes = std::max(phaseStats.peakBytes, current.peakBytesInUse);
+    stats->peakBytes = std::max(stats->peakBytes, current.peakBytesInUse);
+}
+
 
 } // end namespace glslang
@@ -0,0 +1,88 @@
+//
+// Copyright (C) 2026 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include "NodeTypes.h"
+
+// Mostly here for targets that do not support threads such as WASI.
+#ifdef DISABLE_THREAD_SUPPORT
+#define THREAD_LOCAL
+#else
+#define THREAD_LOCAL thread_local
+#endif
+
+namespace glslang {
+
+namespace {
+
+THREAD_LOCAL TNodeTypes* threadNodeTypes = nullptr;
+
+} // end anonymous namespace
+
+const TType* TNodeTypes::share(const TType& type)
+{
+    if (threadNodeTypes == nullptr || &threadNodeTypes->pool != &GetThreadPoolAllocator())
+        return nullptr;
+
+    return &threadNodeTypes->find(type);
+}
+
+const TType& TNodeTypes::find(const TType& type)
+{
+    TVector<const TType*>& bucket = buckets[type.getShallowHash()];
+    for (const TType* shared : bucket) {
+        if (shared == &type || shared->isShallowCopyOf(type))
+            return *shared;
+    }
+
+    TType* shared = new TType;
+    shared->shallowCopy(type);
+    bucket.push_back(shared);
+    ++count;
+
+    return *shared;
+}
+
+TNodeTypeScope::TNodeTypeScope(TNodeTypes& nodeTypes) : previous(threadNodeTypes)
+{
+    threadNodeTypes = &nodeTypes;
+}
+
+TNodeTypeScope::~TNodeTypeScope()
+{
+    threadNodeTypes = previous;
+}
+
+} // end namespace glslang
@@ -0,0 +1,95 @@
+//
+// Copyright (C) 2026 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#ifndef _NODE_TYPES_INCLUDED_
+#define _NODE_TYPES_INCLUDED_
+
+#include "../Include/Types.h"
+
+namespace glslang {
+
+//
+// Types shared by AST nodes.
+//
+// Most nodes have one of few distinct types (a float temporary, a vec4
+// temporary, ...), so rather than each embedding a copy, typed nodes point at
+// an instance from the table in effect, and get a copy of their own only once
+// written to (see TIntermTyped::getWritableType()).
+//
+// share() looks types up by TType::isShallowCopyOf(), so a node sharing a type
+// can't be told apart from one holding a shallow copy of it.  Shared types live
+// in the pool current when the table was made; nodes made while a different pool
+// is current get no shared type.
+//
+// A table is in effect for the current thread while a TNodeTypeScope for it is.
+//
+class TNodeTypes {
+public:
+    TNodeTypes() : pool(GetThreadPoolAllocator()), count(0) { }
+
+    // nullptr if there is no table in effect, or it can't be used from the current pool
+    static const TType* share(const TType&);
+
+    size_t size() const { return count; }
+
+protected:
+    friend class TNodeTypeScope;
+
+    TNodeTypes(const TNodeTypes&);
+    TNodeTypes& operator=(const TNodeTypes&);
+
+    const TType& find(const TType&);
+
+    TPoolAllocator& pool;
+    TUnorderedMap<size_t, TVector<const TType*>> buckets;
+    size_t count;
+};
+
+class TNodeTypeScope {
+public:
+    explicit TNodeTypeScope(TNodeTypes&);
+    ~TNodeTypeScope();
+
+protected:
+    TNodeTypeScope(const TNodeTypeScope&);
+    TNodeTypeScope& operator=(const TNodeTypeScope&);
+
+    TNodeTypes* previous;
+};
+
+} // end namespace glslang
+
+#endif // _NODE_TYPES_INCLUDED_
@@ -132,14 +132,14 @@ bool TParseContextBase::lValueErrorCheck(const TSourceLoc& loc, const char* op,
         symbol = symNode->getName().c_str();
 
     const char* message = nullptr;
-    switch (node->getQualifier().storage) {
+    switch (node->getType().getQualifier().storage) {
     case EvqConst:          message = "can't modify a const";        break;
     case EvqConstReadOnly:  message = "can't modify a const";        break;
     case EvqUniform:        message = "can't modify a uniform";      break;
     case EvqBuffer:
-        if (node->getQualifier().isReadOnly())
+        if (node->getType().getQualifier().isReadOnly())
             message = "can't modify a readonly buffer";
-        if (node->getQualifier().isShaderRecord())
+        if (node->getType().getQualifier().isShaderRecord())
             message = "can't modify a shaderrecordnv qualified buffer";
         break;
     case EvqHitAttr:
@@ -233,7 +233,7 @@ void TParseContextBase::rValueErrorCheck(const TSourceLoc& loc, const char* op,
     TIntermBinary* binaryNode = node->getAsBinaryNode();
     const TIntermSymbol* symNode = node->getAsSymbolNode();
 
-    if (node->getQualifier().isWriteOnly()) {
+    if (node->getType().getQualifier().isWriteOnly()) {
         const TIntermTyped* leftMostTypeNode = TIntermediate::traverseLValueBase(node, true);
 
         if (symNode != nullptr)
@@ -213,6 +213,14 @@ void TParseContext::parserError(const char* s)
         error(getCurrentLoc(), "compilation terminated", "", "");
 }
 
+// Extensions change which implicit conversions there are, so overloads selected
+// before may no longer be the ones to select.
+void TParseContext::updateExtensionBehavior(const char* const extension, TExtensionBehavior behavior)
+{
+    symbolTable.forgetSelectedOverloads();
+    TParseContextBase::updateExtensionBehavior(extension, behavior);
+}
+
 void TParseContext::growGlobalUniformBlock(const TSourceLoc& loc, TType& memberType, const TString& memberName, TTypeList* typeList)
 {
     bool createBlock = globalUniformBlock == nullptr;
@@ -404,7 +412,9 @@ void TParseContext::handlePragma(const TSourceLoc& loc, const TVector<TString>&
             error(loc, "extra tokens", "#pragma", "");
         intermediate.setReplicatedComposites();
     } else if (tokens[0].compare("once") == 0) {
-        warn(loc, "not implemented", "#pragma once", "");
+        // the preprocessor handles this in headers
+        if (ppContext == nullptr || ! ppContext->inInclude())
+            warn(loc, "not implemented", "#pragma once", "");
     } else if (tokens[0].compare("glslang_binary_double_output") == 0) {
         intermediate.setBinaryDoubleOutput();
     } else if (spvVersion.spv > 0 && tokens[0].compare("STDGL") == 0 &&
@@ -542,7 +552,7 @@ TIntermTyped* TParseContext::handleVariable(const TSourceLoc& loc, TSymbol* symb
 TIntermTyped* TParseContext::handleBracketDereference(const TSourceLoc& loc, TIntermTyped* base, TIntermTyped* index)
 {
     int indexValue = 0;
-    if (index->getQualifier().isFrontEndConstant())
+    if (index->getType().getQualifier().isFrontEndConstant())
         indexValue = index->getAsConstantUnion()->getConstArray()[0].getIConst();
 
     // basic type checks...
@@ -597,10 +607,10 @@ TIntermTyped* TParseContext::handleBracketDereference(const TSourceLoc& loc, TIn
     if (base->getAsSymbolNode() && isIoResizeArray(base->getType()))
         handleIoResizeArrayAccess(loc, base);
 
-    if (index->getQualifier().isFrontEndConstant())
+    if (index->getType().getQualifier().isFrontEndConstant())
         checkIndex(loc, base->getType(), indexValue);
 
-    if (index->getQualifier().isFrontEndConstant()) {
+    if (index->getType().getQualifier().isFrontEndConstant()) {
         if (base->getType().isUnsizedArray()) {
             base->getWritableType().updateImplicitArraySize(indexValue + 1);
             base->getWritableType().setImplicitlySized(true);
@@ -642,15 +652,16 @@ TIntermTyped* TParseContext::handleBracketDereference(const TSourceLoc& loc, TIn
             base->getWritableType().setArrayVariablyIndexed();
         }
         if (base->getBasicType() == EbtBlock) {
-            if (base->getQualifier().storage == EvqBuffer)
+            if (base->getType().getQualifier().storage == EvqBuffer)
                 requireProfile(base->getLoc(), ~EEsProfile, "variable indexing buffer block array");
-            else if (base->getQualifier().storage == EvqUniform)
+            else if (base->getType().getQualifier().storage == EvqUniform)
                 profileRequires(base->getLoc(), EEsProfile, 320, Num_AEP_gpu_shader5, AEP_gpu_shader5,
                                 "variable indexing uniform block array");
             else {
                 // input/output blocks either don't exist or can't be variably indexed
             }
-        } else if (language == EShLangFragment && base->getQualifier().isPipeOutput() && base->getQualifier().builtIn != EbvSampleMask)
+        } else if (language == EShLangFragment && base->getType().getQualifier().isPipeOutput() &&
+                   base->getType().getQualifier().builtIn != EbvSampleMask)
             requireProfile(base->getLoc(), ~EEsProfile, "variable indexing fragment shader output array");
         else if (base->getBasicType() == EbtSampler && version >= 130) {
             const char* explanation = "variable indexing sampler array";
@@ -664,22 +675,21 @@ TIntermTyped* TParseContext::handleBracketDereference(const TSourceLoc& loc, TIn
 
     // Insert valid dereferenced result type
     TType newType(base->getType(), 0);
-    if (base->getType().getQualifier().isConstant() && index->getQualifier().isConstant()) {
+    if (base->getType().getQualifier().isConstant() && index->getType().getQualifier().isConstant()) {
         newType.getQualifier().storage = EvqConst;
         // If base or index is a specialization constant, the result should also be a specialization constant.
-        if (base->getType().getQualifier().isSpecConstant() || index->getQualifier().isSpecConstant()) {
+        if (base->getType().getQualifier().isSpecConstant() || index->getType().getQualifier().isSpecConstant()) {
             newType.getQualifier().makeSpecConstant();
         }
     } else {
         newType.getQualifier().storage = EvqTemporary;
         newType.getQualifier().specConstant = false;
     }
+    inheritMemoryQualifiers(base->getType().getQualifier(), newType.getQualifier());
     result->setType(newType);
 
-    inheritMemoryQualifiers(base->getQualifier(), result->getWritableType().getQualifier());
-
     // Propagate nonuniform
-    if (base->getQualifier().isNonUniform() || index->getQualifier().isNonUniform())
+    if (base->getType().getQualifier().isNonUniform() || index->getType().getQualifier().isNonUniform())
         result->getWritableType().getQualifier().nonUniform = true;
 
     if (anyIndexLimits)
@@ -1030,7 +1040,8 @@ TIntermTyped* TParseContext::handleDotDereference(const TSourceLoc& loc, TInterm
                 }
             }
 
-            inheritMemoryQualifiers(base->getQualifier(), result->getWritableType().getQualifier());
+            if (base->getType().getQualifier().isMemory())
+                inheritMemoryQualifiers(base->getType().getQualifier(), result->getWritableType().getQualifier());
         } else {
             auto baseSymbol = base;
             while (baseSymbol->getAsSymbolNode() == nullptr) {
@@ -1051,11 +1062,11 @@ TIntermTyped* TParseContext::handleDotDereference(const TSourceLoc& loc, TInterm
           base->getType().getCompleteString(intermediate.getEnhancedMsgs()).c_str());
 
     // Propagate noContraction up the dereference chain
-    if (base->getQualifier().isNoContraction())
+    if (base->getType().getQualifier().isNoContraction())
         result->getWritableType().getQualifier().setNoContraction();
 
     // Propagate nonuniform
-    if (base->getQualifier().isNonUniform())
+    if (base->getType().getQualifier().isNonUniform())
         result->getWritableType().getQualifier().nonUniform = true;
 
     return result;
@@ -1089,7 +1100,7 @@ TIntermTyped* TParseContext::handleDotSwizzle(const TSourceLoc& loc, TIntermType
         else {
             TType type(base->getBasicType(), EvqTemporary, selectors.size());
             // Swizzle operations propagate specialization-constantness
-            if (base->getQualifier().isSpecConstant())
+            if (base->getType().getQualifier().isSpecConstant())
                 type.getQualifier().makeSpecConstant();
             return addConstructor(loc, base, type);
         }
@@ -1853,14 +1864,14 @@ void TParseContext::computeBuiltinPrecisions(TIntermTyped& node, const TFunction
         }
         // find the maximum precision from the arguments and parameters
         for (unsigned int arg = 0; arg < numArgs; ++arg) {
-            operationPrecision = std::max(operationPrecision, sequence[arg]->getAsTyped()->getQualifier().precision);
+            operationPrecision = std::max(operationPrecision, sequence[arg]->getAsTyped()->getType().getQualifier().precision);
             operationPrecision = std::max(operationPrecision, function[arg].type->getQualifier().precision);
         }
         // compute the result precision
         if (agg->isSampling() ||
             agg->getOp() == EOpImageLoad || agg->getOp() == EOpImageStore ||
             agg->getOp() == EOpImageLoadLod || agg->getOp() == EOpImageStoreLod)
-            resultPrecision = sequence[0]->getAsTyped()->getQualifier().precision;
+            resultPrecision = sequence[0]->getAsTyped()->getType().getQualifier().precision;
         else if (function.getType().getBasicType() != EbtBool)
             resultPrecision = function.getType().getQualifier().precision == EpqNone ?
                                         operationPrecision :
@@ -1869,13 +1880,13 @@ void TParseContext::computeBuiltinPrecisions(TIntermTyped& node, const TFunction
 
     // Propagate precision through this node and its children. That algorithm stops
     // when a precision is found, so start by clearing this subroot precision
-    opNode->getQualifier().precision = EpqNone;
+    opNode->setPrecision(EpqNone);
     if (operationPrecision != EpqNone) {
         opNode->propagatePrecision(operationPrecision);
         opNode->setOperationPrecision(operationPrecision);
     }
     // Now, set the result precision, which might not match
-    opNode->getQualifier().precision = resultPrecision;
+    opNode->setPrecision(resultPrecision);
 }
 
 TIntermNode* TParseContext::handleReturnValue(const TSourceLoc& loc, TIntermTyped* value)
@@ -2563,7 +2574,7 @@ void TParseContext::builtInOpCheck(const TSourceLoc& loc, const TFunction& fnCan
                                     arg0->getType().getSampler().shadow;
             if (f16ShadowCompare)
                 ++arg;
-            if (! (*argp)[arg]->getAsTyped()->getQualifier().isConstant())
+            if (! (*argp)[arg]->getAsTyped()->getType().getQualifier().isConstant())
                 error(loc, "argument must be compile-time constant", "texel offset", "");
             else if ((*argp)[arg]->getAsConstantUnion()) {
                 const TType& type = (*argp)[arg]->getAsTyped()->getType();
@@ -3087,7 +3098,7 @@ void TParseContext::nonOpBuiltInCheck(const TSourceLoc& loc, const TFunction& fn
     // built-in texturing functions get their return value precision from the precision of the sampler
     if (fnCandidate.getType().getQualifier().precision == EpqNone &&
         fnCandidate.getParamCount() > 0 && fnCandidate[0].type->getBasicType() == EbtSampler)
-        callNode.getQualifier().precision = callNode.getSequence()[0]->getAsTyped()->getQualifier().precision;
+        callNode.setPrecision(callNode.getSequence()[0]->getAsTyped()->getType().getQualifier().precision);
 
     if (fnCandidate.getName().compare(0, 7, "texture") == 0) {
         if (fnCandidate.getName().compare(0, 13, "textureGather") == 0) {
@@ -3325,7 +3336,7 @@ void TParseContext::variableCheck(TIntermTyped*& nodePtr)
             nodePtr = intermediate.addSymbol(*fakeVariable, symbol->getLoc());
         }
     } else {
-        switch (symbol->getQualifier().storage) {
+        switch (symbol->getType().getQualifier().storage) {
         case EvqPointCoord:
             profileRequires(symbol->getLoc(), ENoProfile, 120, nullptr, "gl_PointCoord");
             break;
@@ -3408,7 +3419,7 @@ bool TParseContext::lValueErrorCheck(const TSourceLoc& loc, const char* op, TInt
         symbol = symNode->getName().c_str();
 
     const char* message = nullptr;
-    switch (node->getQualifier().storage) {
+    switch (node->getType().getQualifier().storage) {
     case EvqVaryingIn:      message = "can't modify shader input";   break;
     case EvqInstanceId:     message = "can't modify gl_InstanceID";  break;
     case EvqVertexId:       message = "can't modify gl_VertexID";    break;
@@ -3466,12 +3477,12 @@ void TParseContext::rValueErrorCheck(const TSourceLoc& loc, const char* op, TInt
     TParseContextBase::rValueErrorCheck(loc, op, node);
 
     TIntermSymbol* symNode = node->getAsSymbolNode();
-    if (!(symNode && symNode->getQualifier().isWriteOnly())) // base class checks
-        if (symNode && symNode->getQualifier().isExplicitInterpolation())
+    if (!(symNode && symNode->getType().getQualifier().isWriteOnly())) // base class checks
+        if (symNode && symNode->getType().getQualifier().isExplicitInterpolation())
             error(loc, "can't read from explicitly-interpolated object: ", op, symNode->getName().c_str());
 
     // local_size_{xyz} must be assigned or specialized before gl_WorkGroupSize can be assigned.
-    if(node->getQualifier().builtIn == EbvWorkGroupSize &&
+    if(node->getType().getQualifier().builtIn == EbvWorkGroupSize &&
        !(intermediate.isLocalSizeSet() || intermediate.isLocalSizeSpecialized()))
         error(loc, "can't read from gl_WorkGroupSize before a fixed workgroup size has been declared", op, "");
 }
@@ -3482,7 +3493,7 @@ void TParseContext::rValueErrorCheck(const TSourceLoc& loc, const char* op, TInt
 //
 void TParseContext::constantValueCheck(TIntermTyped* node, const char* token)
 {
-    if (! node->getQualifier().isConstant())
+    if (! node->getType().getQualifier().isConstant())
         error(node->getLoc(), "constant expression required", token, "");
 }
 
@@ -7347,7 +7358,7 @@ const TFunction* TParseContext::findFunction120(const TSourceLoc& loc, const TFu
 
     const TFunction* candidate = nullptr;
     TVector<const TFunction*> candidateList;
-    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn);
+    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn, call.getParamCount());
 
     for (auto it = candidateList.begin(); it != candidateList.end(); ++it) {
         const TFunction& function = *(*it);
@@ -7396,6 +7407,22 @@ const TFunction* TParseContext::findFunction120(const TSourceLoc& loc, const TFu
     return candidate;
 }
 
+// Whether the overload selected for 'call' depends only on its mangled name, which
+// leaves out array storage, and the type parameters of cooperative matrices and
+// tensors, all of which the selection rules look at.
+static bool canRememberSelectedOverload(const TFunction& call)
+{
+    for (int i = 0; i < call.getParamCount(); ++i) {
+        const TType& type = *call[i].type;
+        if (type.isArray() || type.isCoopMat() || type.getTypeParameters() != nullptr)
+            return false;
+        if (type.getBasicType() > EbtBool && type.getBasicType() != EbtSampler)
+            return false;
+    }
+
+    return true;
+}
+
 // Function finding algorithm for desktop version 400 and above.
 //
 // "When function calls are resolved, an exact type match for all the arguments
@@ -7444,11 +7471,21 @@ const TFunction* TParseContext::findFunction400(const TSourceLoc& loc, const TFu
     if (symbol)
         return symbol->getAsFunction();
 
+    // next, for a built-in already selected for a call with the same argument types
+    const bool memoizable = canRememberSelectedOverload(call);
+    if (memoizable) {
+        const TFunction* selected = symbolTable.findSelectedOverload(call.getMangledName());
+        if (selected != nullptr) {
+            builtIn = true;
+            return selected;
+        }
+    }
+
     // no exact match, use the generic selector, parameterized by the GLSL rules
 
     // create list of candidates to send
     TVector<const TFunction*> candidateList;
-    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn);
+    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn, call.getParamCount());
 
     // can 'from' convert to 'to'?
     const auto convertible = [this,builtIn](const TType& from, const TType& to, TOperator op, int param) -> bool {
@@ -7510,6 +7547,8 @@ const TFunction* TParseContext::findFunction400(const TSourceLoc& loc, const TFu
         error(loc, "no matching overloaded function found", call.getName().c_str(), "");
     else if (tie)
         error(loc, "ambiguous best function under implicit type conversion", call.getName().c_str(), "");
+    else if (builtIn && memoizable)
+        symbolTable.rememberSelectedOverload(call.getMangledName(), bestMatch);
 
     return bestMatch;
 }
@@ -7530,11 +7569,21 @@ const TFunction* TParseContext::findFunctionExplicitTypes(const TSourceLoc& loc,
     if (symbol)
         return symbol->getAsFunction();
 
+    // next, for a built-in already selected for a call with the same argument types
+    const bool memoizable = canRememberSelectedOverload(call);
+    if (memoizable) {
+        const TFunction* selected = symbolTable.findSelectedOverload(call.getMangledName());
+        if (selected != nullptr) {
+            builtIn = true;
+            return selected;
+        }
+    }
+
     // no exact match, use the generic selector, parameterized by the GLSL rules
 
     // create list of candidates to send
     TVector<const TFunction*> candidateList;
-    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn);
+    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn, call.getParamCount());
 
     // can 'from' convert to 'to'?
     const auto convertible = [this,builtIn](const TType& from, const TType& to, TOperator op, int param) -> bool {
@@ -7610,6 +7659,8 @@ const TFunction* TParseContext::findFunctionExplicitTypes(const TSourceLoc& loc,
         error(loc, "no matching overloaded function found", call.getName().c_str(), "");
     else if (tie)
         error(loc, "ambiguous best function under implicit type conversion", call.getName().c_str(), "");
+    else if (builtIn && memoizable)
+        symbolTable.rememberSelectedOverload(call.getMangledName(), bestMatch);
 
     return bestMatch;
 }
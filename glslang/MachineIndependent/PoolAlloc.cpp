@@ -34,6 +34,9 @@
 
 #include "../Include/Common.h"
 #include "../Include/PoolAlloc.h"
+#include "../Public/ShaderLang.h"
+
+#include <atomic>
 
 // Mostly here for target that do not support threads such as WASI.
 #ifdef DISABLE_THREAD_SUPPORT
@@ -52,6 +55,148 @@ TPoolAllocator* GetDefaultThreadPoolAllocator()
     THREAD_LOCAL TPoolAllocator defaultAllocator;
     return &defaultAllocator;
 }
+
+// Bytes of pages each thread may keep for reuse; see TPoolAllocator::setPageCacheLimit().
+std::atomic<size_t> PageCacheLimit(0);
+
+// Where new memory comes from, nullptr for the heap; see TPoolAllocator::setPageAllocator().
+std::atomic<TPageAllocator*> PageSource(nullptr);
+
+void ClosePageCacheAtExit();
+
+//
+// Single pages given up by pools on this thread, kept for the next pool to take
+// instead of going back to the heap.  Pages go back to the heap when the cache
+// would exceed the limit, and when the thread exits.
+//
+// Pools can outlive any thread_local with a destructor (the thread's default pool
+// may be destroyed after it), so the cache has none, and stays usable throughout
+// thread exit.  Instead, the first page kept has a separate object drain and close
+// the cache at thread exit, after which it sends pages straight back to the heap.
+//
+class TPageCache {
+public:
+    // Return a cached page of 'size' bytes, or nullptr if there is none.
+    unsigned char* take(size_t size)
+    {
+        if (pages == nullptr || pages->size != size)
+            return nullptr;
+
+        TCachedPage* page = pages;
+        pages = page->next;
+        bytes -= size;
+
+        return reinterpret_cast<unsigned char*>(page);
+    }
+
+    // Keep 'memory', a page of 'size' bytes from new[], or delete it if there is no room.
+    // This is also where a limit lowered on another thread takes effect on this one.
+    void give(unsigned char* memory, size_t size)
+    {
+        const size_t limit = closed ? 0 : PageCacheLimit.load(std::memory_order_relaxed);
+        if (bytes + size > limit) {
+            delete [] memory;
+            trim(limit);
+            return;
+        }
+
+        if (! closing) {
+            closing = true;
+            ClosePageCacheAtExit();
+        }
+
+        TCachedPage* page = reinterpret_cast<TCachedPage*>(memory);
+        page->next = pages;
+        page->size = size;
+        pages = page;
+        bytes += size;
+    }
+
+    // Delete pages until at most 'limit' bytes are kept.
+    void trim(size_t limit)
+    {
+        while (pages != nullptr && bytes > limit) {
+            TCachedPage* page = pages;
+            pages = page->next;
+            bytes -= page->size;
+            delete [] reinterpret_cast<unsigned char*>(page);
+        }
+    }
+
+    void close()
+    {
+        trim(0);
+        closed = true;
+    }
+
+    size_t getBytes() const { return bytes; }
+
+    struct TCachedPage {
+        TCachedPage* next;
+        size_t size;
+    };
+
+    // Plain data, zero-initialized, so that there is nothing to construct or destroy.
+    TCachedPage* pages;
+    size_t bytes;
+    bool closing;  // ClosePageCacheAtExit() was called
+    bool closed;
+};
+
+THREAD_LOCAL TPageCache PageCache;
+
+// Close this thread's page cache when the thread exits.
+void ClosePageCacheAtExit()
+{
+    struct TPageCacheCloser {
+        ~TPageCacheCloser() { PageCache.close(); }
+    };
+    static THREAD_LOCAL TPageCacheCloser closer;
+    (void)closer;
+}
+
+//
+// Memory for pages and multi-page allocations.  'source' is set to, or says, where it
+// comes from.  Only heap pages are cached; other sources do their own recycling.
+//
+unsigned char* NewBlock(size_t size, TPageAllocator*& source)
+{
+    source = PageSource.load(std::memory_order_acquire);
+    if (source != nullptr)
+        return reinterpret_cast<unsigned char*>(source->allocate(size));
+
+    return new unsigned char[size];
+}
+
+void DeleteBlock(void* memory, size_t size, TPageAllocator* source)
+{
+    if (source != nullptr)
+        source->deallocate(memory, size);
+    else
+        delete [] reinterpret_cast<unsigned char*>(memory);
+}
+
+unsigned char* NewPage(size_t size, TPageAllocator*& source)
+{
+    source = PageSource.load(std::memory_order_acquire);
+    if (source != nullptr)
+        return reinterpret_cast<unsigned char*>(source->allocate(size));
+
+    unsigned char* memory = PageCache.take(size);
+    if (memory == nullptr)
+        memory = new unsigned char[size];
+
+    return memory;
+}
+
+void DeletePage(void* memory, size_t size, TPageAllocator* source)
+{
+    if (source != nullptr)
+        source->deallocate(memory, size);
+    else
+        PageCache.give(reinterpret_cast<unsigned char*>(memory), size);
+}
+
 } // anonymous namespace
 
 // Return the thread-specific current pool.
@@ -75,7 +220,13 @@ TPoolAllocator::TPoolAllocator(int growthIncrement, int allocationAlignment) :
     alignment(allocationAlignment),
     freeList(nullptr),
     inUseList(nullptr),
-    numCalls(0)
+    numCalls(0),
+    totalBytes(0),
+    pagesUsed(0),
+    pagesInUse(0),
+    peakPagesInUse(0),
+    limit(0),
+    overLimit(false)
 {
     //
     // Don't allow page sizes we know are smaller than all common
@@ -119,8 +270,14 @@ TPoolAllocator::~TPoolAllocator()
 {
     while (inUseList) {
         tHeader* next = inUseList->nextPage;
+        size_t pageCount = inUseList->pageCount;
+        size_t size = inUseList->size;
+        TPageAllocator* source = inUseList->source;
         inUseList->~tHeader();
-        delete [] reinterpret_cast<char*>(inUseList);
+        if (pageCount > 1)
+            DeleteBlock(inUseList, size, source);
+        else
+            DeletePage(inUseList, pageSize, source);
         inUseList = next;
     }
 
@@ -133,11 +290,27 @@ TPoolAllocator::~TPoolAllocator()
     //
     while (freeList) {
         tHeader* next = freeList->nextPage;
-        delete [] reinterpret_cast<char*>(freeList);
+        DeletePage(freeList, pageSize, freeList->source);
         freeList = next;
     }
 }
 
+void TPoolAllocator::setPageCacheLimit(size_t bytes)
+{
+    PageCacheLimit = bytes;
+    PageCache.trim(bytes);
+}
+
+size_t TPoolAllocator::getPageCacheBytes()
+{
+    return PageCache.getBytes();
+}
+
+void TPoolAllocator::setPageAllocator(TPageAllocator* allocator)
+{
+    PageSource.store(allocator, std::memory_order_release);
+}
+
 //
 // Check a single guard block for damage
 //
@@ -194,13 +367,16 @@ void TPoolAllocator::pop()
     while (inUseList != page) {
         tHeader* nextInUse = inUseList->nextPage;
         size_t pageCount = inUseList->pageCount;
+        size_t size = inUseList->size;
+        TPageAllocator* source = inUseList->source;
 
         // This technically ends the lifetime of the header as C++ object,
         // but we will still control the memory and reuse it.
         inUseList->~tHeader(); // currently, just a debug allocation checker
+        pagesInUse -= pageCount;
 
         if (pageCount > 1) {
-            delete [] reinterpret_cast<char*>(inUseList);
+            DeleteBlock(inUseList, size, source);
         } else {
             inUseList->nextPage = freeList;
             freeList = inUseList;
@@ -257,13 +433,15 @@ void* TPoolAllocator::allocate(size_t numBytes)
         // The OS is efficient and allocating and free-ing multiple pages.
         //
         size_t numBytesToAlloc = allocationSize + headerSkip;
-        tHeader* memory = reinterpret_cast<tHeader*>(::new char[numBytesToAlloc]);
+        TPageAllocator* source;
+        tHeader* memory = reinterpret_cast<tHeader*>(NewBlock(numBytesToAlloc, source));
         if (memory == nullptr)
             return nullptr;
 
         // Use placement-new to initialize header
-        new(memory) tHeader(inUseList, (numBytesToAlloc + pageSize - 1) / pageSize);
+        new(memory) tHeader(inUseList, (numBytesToAlloc + pageSize - 1) / pageSize, numBytesToAlloc, source);
         inUseList = memory;
+        addPagesInUse(memory->pageCount);
 
         currentPageOffset = pageSize;  // make next allocation come from a new page
 
@@ -275,18 +453,21 @@ void* TPoolAllocator::allocate(size_t numBytes)
     // Need a simple page to allocate from.
     //
     tHeader* memory;
+    TPageAllocator* source;
     if (freeList) {
         memory = freeList;
+        source = freeList->source;
         freeList = freeList->nextPage;
     } else {
-        memory = reinterpret_cast<tHeader*>(::new char[pageSize]);
+        memory = reinterpret_cast<tHeader*>(NewPage(pageSize, source));
         if (memory == nullptr)
             return nullptr;
     }
 
     // Use placement-new to initialize header
-    new(memory) tHeader(inUseList, 1);
+    new(memory) tHeader(inUseList, 1, pageSize, source);
     inUseList = memory;
+    addPagesInUse(1);
 
     unsigned char* ret = reinterpret_cast<unsigned char*>(inUseList) + headerSkip;
     currentPageOffset = (headerSkip + allocationSize + alignmentMask) & ~alignmentMask;
@@ -294,6 +475,38 @@ void* TPoolAllocator::allocate(size_t numBytes)
     return initializeAllocation(inUseList, ret, numBytes);
 }
 
+size_t TPoolAllocator::getBytesInUse() const
+{
+    return pagesInUse * pageSize;
+}
+
+TPoolAllocator::TStats TPoolAllocator::getStats() const
+{
+    TStats stats;
+    stats.allocations = numCalls;
+    stats.bytesAllocated = totalBytes;
+    stats.pagesUsed = pagesUsed;
+    stats.bytesInUse = pagesInUse * pageSize;
+    stats.peakBytesInUse = peakPagesInUse * pageSize;
+
+    return stats;
+}
+
+void TPoolAllocator::resetPeak()
+{
+    peakPagesInUse = pagesInUse;
+}
+
+void TPoolAllocator::addPagesInUse(size_t count)
+{
+    pagesUsed += count;
+    pagesInUse += count;
+    if (pagesInUse > peakPagesInUse)
+        peakPagesInUse = pagesInUse;
+    if (limit != 0 && pagesInUse * pageSize > limit)
+        overLimit = true;
+}
+
 //
 // Check all allocations in a list for damage by calling check on each.
 //
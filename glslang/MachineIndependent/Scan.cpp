@@ -41,9 +41,20 @@
 // GLSL scanning, leveraging the scanning done by the preprocessor.
 //
 
+#include <algorithm>
+#include <cassert>
 #include <cstring>
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
+#include <vector>
+
+// Vector instructions for TInputScanner::skipRun(), where available
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SCAN_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define SCAN_NEON
+#endif
 
 #include "../Include/Types.h"
 #include "SymbolTable.h"
@@ -62,6 +73,167 @@ int yylex(YYSTYPE*, glslang::TParseContext&);
 
 namespace glslang {
 
+namespace {
+
+// Whether 'c' belongs to 'runClass'
+inline bool InRunClass(TInputScanner::TRunClass runClass, unsigned char c)
+{
+    switch (runClass) {
+    case TInputScanner::ERunBlanks:       return c == ' ' || c == '\t';
+    case TInputScanner::ERunLineComment:  return c != '\n' && c != '\r' && c != '\\';
+    case TInputScanner::ERunBlockComment: return c != '*' && c != '\n' && c != '\r' && c != '\\';
+    case TInputScanner::ERunIdentifier:   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                                                 (c >= '0' && c <= '9') || c == '_';
+    case TInputScanner::ERunDigits:       return c >= '0' && c <= '9';
+    case TInputScanner::ERunLineText:     return c != '\n' && c != '\r' && c != '\\' && c != '/' && c != '"';
+    default:                              return false;
+    }
+}
+
+#if defined(SCAN_SSE2) || defined(SCAN_NEON)
+
+inline int CountTrailingZeros(unsigned long long bits)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int count = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        ++count;
+    }
+    return count;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+#endif
+
+#if defined(SCAN_SSE2)
+
+// How many of the 16 characters at 's' belong to 'runClass' before one that doesn't
+inline size_t RunLength16(TInputScanner::TRunClass runClass, const unsigned char* s)
+{
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    const auto is = [&c](char value) { return _mm_cmpeq_epi8(c, _mm_set1_epi8(value)); };
+    const auto within = [](__m128i v, char low, char high) {
+        // signed compares, but characters 128 and up are in no class that has ranges
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(high + 1)));
+    };
+
+    int in;
+    switch (runClass) {
+    case TInputScanner::ERunBlanks:
+        in = _mm_movemask_epi8(_mm_or_si128(is(' '), is('\t')));
+        break;
+    case TInputScanner::ERunLineComment:
+        in = ~_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(is('\n'), is('\r')), is('\\')));
+        break;
+    case TInputScanner::ERunBlockComment:
+        in = ~_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(is('\n'), is('\r')), _mm_or_si128(is('\\'), is('*'))));
+        break;
+    case TInputScanner::ERunIdentifier: {
+        // setting bit 5 lower-cases letters, without making anything else a letter
+        const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+        in = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(within(lower, 'a', 'z'), within(c, '0', '9')), is('_')));
+        break;
+    }
+    case TInputScanner::ERunDigits:
+        in = _mm_movemask_epi8(within(c, '0', '9'));
+        break;
+    case TInputScanner::ERunLineText:
+        in = ~_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_or_si128(is('\n'), is('\r')), is('\\')),
+                                             _mm_or_si128(is('/'), is('"'))));
+        break;
+    default:
+        in = 0;
+        break;
+    }
+
+    const unsigned out = ~static_cast<unsigned>(in) & 0xffff;
+    return out != 0 ? CountTrailingZeros(out) : 16;
+}
+
+#elif defined(SCAN_NEON)
+
+// How many of the 16 characters at 's' belong to 'runClass' before one that doesn't
+inline size_t RunLength16(TInputScanner::TRunClass runClass, const unsigned char* s)
+{
+    const uint8x16_t c = vld1q_u8(s);
+    const auto is = [&c](unsigned char value) { return vceqq_u8(c, vdupq_n_u8(value)); };
+    const auto within = [](uint8x16_t v, unsigned char low, unsigned char high) {
+        return vandq_u8(vcgeq_u8(v, vdupq_n_u8(low)), vcleq_u8(v, vdupq_n_u8(high)));
+    };
+
+    uint8x16_t in;
+    switch (runClass) {
+    case TInputScanner::ERunBlanks:
+        in = vorrq_u8(is(' '), is('\t'));
+        break;
+    case TInputScanner::ERunLineComment:
+        in = vmvnq_u8(vorrq_u8(vorrq_u8(is('\n'), is('\r')), is('\\')));
+        break;
+    case TInputScanner::ERunBlockComment:
+        in = vmvnq_u8(vorrq_u8(vorrq_u8(is('\n'), is('\r')), vorrq_u8(is('\\'), is('*'))));
+        break;
+    case TInputScanner::ERunIdentifier: {
+        // setting bit 5 lower-cases letters, without making anything else a letter
+        const uint8x16_t lower = vorrq_u8(c, vdupq_n_u8(0x20));
+        in = vorrq_u8(vorrq_u8(within(lower, 'a', 'z'), within(c, '0', '9')), is('_'));
+        break;
+    }
+    case TInputScanner::ERunDigits:
+        in = within(c, '0', '9');
+        break;
+    case TInputScanner::ERunLineText:
+        in = vmvnq_u8(vorrq_u8(vorrq_u8(vorrq_u8(is('\n'), is('\r')), is('\\')), vorrq_u8(is('/'), is('"'))));
+        break;
+    default:
+        in = vdupq_n_u8(0);
+        break;
+    }
+
+    // narrow to 4 bits per character
+    const unsigned long long out =
+        ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(in), 4)), 0);
+    return out != 0 ? CountTrailingZeros(out) / 4 : 16;
+}
+
+#endif
+
+} // anonymous namespace
+
+size_t TInputScanner::skipRun(TRunClass runClass, char* copy, size_t room)
+{
+    // Staying short of the end of the string means never moving on to the next one,
+    // which get() has to handle.
+    if (currentSource >= numSources || currentChar + 1 >= lengths[currentSource])
+        return 0;
+    const unsigned char* start = sources[currentSource] + currentChar;
+    const size_t available = lengths[currentSource] - currentChar - 1;
+
+    size_t length = 0;
+#if defined(SCAN_SSE2) || defined(SCAN_NEON)
+    while (length + 16 <= available) {
+        const size_t run = RunLength16(runClass, start + length);
+        length += run;
+        if (run < 16)
+            break;
+    }
+#endif
+    while (length < available && InRunClass(runClass, start[length]))
+        ++length;
+
+    if (copy != nullptr)
+        memcpy(copy, start, std::min(length, room));
+
+    // None of the classes include a newline, so only the column moves.
+    currentChar += length;
+    loc[currentSource].column += static_cast<int>(length);
+    logicalSourceLoc.column += static_cast<int>(length);
+
+    return length;
+}
+
 // read past any white space
 void TInputScanner::consumeWhiteSpace(bool& foundNonSpaceTab)
 {
@@ -298,31 +470,13 @@ int yylex(YYSTYPE* glslangTokenDesc, glslang::TParseContext& parseContext)
 
 namespace {
 
-struct str_eq
-{
-    bool operator()(const char* lhs, const char* rhs) const
-    {
-        return strcmp(lhs, rhs) == 0;
-    }
-};
-
-struct str_hash
-{
-    size_t operator()(const char* str) const
-    {
-        // djb2
-        unsigned long hash = 5381;
-        int c;
-
-        while ((c = *str++) != 0)
-            hash = ((hash << 5) + hash) + c;
-
-        return hash;
-    }
+struct TKeyword {
+    const char* name;
+    int token;
 };
 
-// A single global usable by all threads, by all versions, by all languages.
-const std::unordered_map<const char*, int, str_hash, str_eq> KeywordMap {
+// Every keyword and the token it scans to; looked up through TKeywordTable.
+const TKeyword KeywordList[] = {
     {"const",CONST},
     {"uniform",UNIFORM},
     {"tileImageEXT",TILEIMAGEEXT},
@@ -757,7 +911,7 @@ const std::unordered_map<const char*, int, str_hash, str_eq> KeywordMap {
     {"tensorLayoutNV",TENSORLAYOUTNV},
     {"tensorViewNV",TENSORVIEWNV},
 };
-const std::unordered_set<const char*, str_hash, str_eq> ReservedSet {
+const char* const ReservedList[] = {
     "common",
     "partition",
     "active",
@@ -797,6 +951,134 @@ const std::unordered_set<const char*, str_hash, str_eq> ReservedSet {
     "using",
 };
 
+// Minimal-probe perfect hash over KeywordList and ReservedList (hash-and-displace).
+// Every word is placed so that one hash of the identifier, a displacement lookup by
+// bucket, and one string compare decide whether it is a keyword or reserved word.
+// The table is built at run time, once, on first use, rather than generated at
+// build time: the tree has no code-generation step for C++ tables, and building it
+// takes microseconds.
+class TKeywordTable {
+public:
+    // Marks reserved words, which never collide with bison token values.
+    static const int reservedToken = -1;
+
+    TKeywordTable()
+    {
+        // Reserved words are checked before keywords, so they win any overlap.
+        for (const char* name : ReservedList)
+            add(name, reservedToken);
+        for (const TKeyword& keyword : KeywordList)
+            add(keyword.name, keyword.token);
+
+        // Place the biggest buckets first, while most slots are still free.
+        std::vector<std::vector<int>> buckets(numBuckets);
+        for (int w = 0; w < (int)words.size(); ++w)
+            buckets[words[w].hash & (numBuckets - 1)].push_back(w);
+        std::vector<int> order(numBuckets);
+        for (int b = 0; b < numBuckets; ++b)
+            order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&buckets](int l, int r) {
+            return buckets[l].size() > buckets[r].size();
+        });
+
+        slots.resize(numSlots, -1);
+        displacements.resize(numBuckets, 0);
+        for (int b : order) {
+            const std::vector<int>& bucket = buckets[b];
+            if (bucket.empty())
+                break;
+            // With an odd step, the first word alone visits every slot within
+            // numSlots displacements; the table is kept sparse enough that some
+            // displacement places the whole bucket well before that.
+            bool bucketPlaced = false;
+            for (unsigned int d = 0; d < numSlots; ++d) {
+                size_t placed = 0;
+                for (; placed < bucket.size(); ++placed) {
+                    int& slot = slots[slotOf(words[bucket[placed]].hash, d)];
+                    if (slot >= 0)
+                        break;
+                    slot = bucket[placed];
+                }
+                if (placed == bucket.size()) {
+                    displacements[b] = d;
+                    bucketPlaced = true;
+                    break;
+                }
+                // collided; take this attempt back out and try the next displacement
+                for (size_t i = 0; i < placed; ++i)
+                    slots[slotOf(words[bucket[i]].hash, d)] = -1;
+            }
+            assert(bucketPlaced);
+            (void)bucketPlaced;
+        }
+    }
+
+    // Returns the token for 'name', reservedToken for a reserved word, or 0 if
+    // it is neither.
+    int find(const char* name) const
+    {
+        size_t length;
+        const uint64_t hash = hashOf(name, length);
+        if (length > maxLength)
+            return 0;
+        const int w = slots[slotOf(hash, displacements[hash & (numBuckets - 1)])];
+        if (w < 0 || words[w].length != length || memcmp(words[w].name, name, length) != 0)
+            return 0;
+        return words[w].token;
+    }
+
+protected:
+    struct TWord {
+        const char* name;
+        size_t length;
+        uint64_t hash;
+        int token;
+    };
+
+    static const int numBuckets = 256;
+    static const unsigned int numSlots = 1024;
+
+    // FNV-1a; also measures the string so no separate strlen is needed.
+    static uint64_t hashOf(const char* name, size_t& length)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        const char* c = name;
+        for (; *c != 0; ++c)
+            hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+        length = c - name;
+        return hash;
+    }
+
+    static unsigned int slotOf(uint64_t hash, unsigned int displacement)
+    {
+        return (unsigned int)((hash >> 32) + displacement * ((hash >> 8) | 1)) & (numSlots - 1);
+    }
+
+    void add(const char* name, int token)
+    {
+        size_t length;
+        const uint64_t hash = hashOf(name, length);
+        for (const TWord& word : words) {
+            if (word.hash == hash && strcmp(word.name, name) == 0)
+                return;
+        }
+        words.push_back(TWord{ name, length, hash, token });
+        maxLength = std::max(maxLength, length);
+    }
+
+    std::vector<TWord> words;
+    std::vector<int> slots;
+    std::vector<unsigned int> displacements;
+    size_t maxLength = 0;
+};
+
+// A single global usable by all threads, by all versions, by all languages.
+const TKeywordTable& GetKeywordTable()
+{
+    static const TKeywordTable keywordTable;
+    return keywordTable;
+}
+
 }
 
 namespace glslang {
@@ -904,17 +1186,20 @@ int TScanContext::tokenize(TPpContext* pp, TParserToken& token)
     } while (true);
 }
 
+int TScanContext::findKeyword(const char* name)
+{
+    return GetKeywordTable().find(name);
+}
+
 int TScanContext::tokenizeIdentifier()
 {
-    if (ReservedSet.find(tokenText) != ReservedSet.end())
+    keyword = findKeyword(tokenText);
+    if (keyword == TKeywordTable::reservedToken)
         return reservedWord();
-
-    auto it = KeywordMap.find(tokenText);
-    if (it == KeywordMap.end()) {
+    if (keyword == 0) {
         // Should have an identifier of some sort
         return identifierOrType();
     }
-    keyword = it->second;
 
     switch (keyword) {
     case CONST:
@@ -218,6 +218,47 @@ public:
     // Returns the index (starting from 0) of the most recent valid source string we are reading from.
     int getLastValidSourceIndex() const { return std::min(currentSource, numSources - 1); }
 
+    // Where the next character comes from: a string, and an offset into it.
+    int getCurrentSource() const { return currentSource; }
+    size_t getCurrentChar() const { return currentChar; }
+
+    // The text of string 's', and whether it is one of the user's (rather than one
+    // added before or after them).
+    const char* getString(int s) const { return reinterpret_cast<const char*>(sources[s]); }
+    size_t getStringLength(int s) const { return lengths[s]; }
+    bool isUserString(int s) const { return s >= stringBias && s < numSources - finale; }
+
+    // Move ahead to 'offset' in the current string, as get() would, given how many
+    // lines that moves past and the column it ends on.  For replaying tokens scanned
+    // from the same text before.
+    void skipTo(size_t offset, int lines, int column)
+    {
+        loc[currentSource].line += lines;
+        loc[currentSource].column = column;
+        logicalSourceLoc.line += lines;
+        logicalSourceLoc.column = column;
+        if (offset > currentChar) {
+            currentChar = offset - 1;
+            advance();
+        }
+    }
+
+    // Classes of characters that skipRun() can move past in bulk
+    enum TRunClass {
+        ERunBlanks,         // ' ' and '\t'
+        ERunLineComment,    // all but '\n', '\r' and '\\'
+        ERunBlockComment,   // all but '*', '\n', '\r' and '\\'
+        ERunIdentifier,     // letters, digits and '_'
+        ERunDigits,
+        ERunLineText,       // all but '\n', '\r', '\\', '/' and '"'
+    };
+
+    // Move past the characters of 'runClass' next in the input, as get() would, but
+    // many at a time, copying up to 'room' of them to 'copy'.  Returns how many were
+    // moved past.  This is only a fast path: it stops short of the last character of
+    // each string, leaving it (and anything after) to get().
+    size_t skipRun(TRunClass runClass, char* copy = nullptr, size_t room = 0);
+
     void consumeWhiteSpace(bool& foundNonSpaceTab);
     bool consumeComment();
     void consumeWhitespaceComment(bool& foundNonSpaceTab);
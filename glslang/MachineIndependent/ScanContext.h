@@ -59,6 +59,9 @@ public:
     static void fillInKeywordMap();
     static void deleteKeywordMap();
 
+    // The token of the keyword 'name', -1 if it's a reserved word, or 0 if neither
+    static int findKeyword(const char* name);
+
     int tokenize(TPpContext*, TParserToken&);
 
 protected:
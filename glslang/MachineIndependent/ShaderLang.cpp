@@ -41,11 +41,21 @@
 // This is the platform independent interface between an OGL driver
 // and the shading language compiler/linker.
 //
+#include <atomic>
+#include <cctype>
+#include <cstddef>
 #include <cstring>
 #include <iostream>
 #include <sstream>
 #include <memory>
 #include <mutex>
+#ifndef DISABLE_THREAD_SUPPORT
+#include <thread>
+#endif
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "SymbolTable.h"
 #include "ParseHelper.h"
 #include "Scan.h"
@@ -66,6 +76,8 @@
 #include "reflection.h"
 #include "iomapper.h"
 #include "Initialize.h"
+#include "SymbolTableImage.h"
+#include "NodeTypes.h"
 
 // TODO: this really shouldn't be here, it is only because of the trial addition
 // of printing pre-processed tokens, which requires knowing the string literal
@@ -81,11 +93,15 @@ namespace { // anonymous namespace for file-local functions and symbols
 // Shared global; access should be protected by a global mutex/critical section.
 int NumberOfClients = 0;
 
-// global initialization lock
+// global initialization lock, for NumberOfClients; built-in tables are guarded per slot
 #ifndef DISABLE_THREAD_SUPPORT
 std::mutex init_lock;
 #endif
 
+// Whether newly built GLSL built-in symbol tables leave out the function prototypes,
+// for compiles to add on demand; see glslang::SetLazyBuiltIns().
+std::atomic<bool> LazyBuiltIns(false);
+
 
 using namespace glslang;
 
@@ -134,9 +150,10 @@ TParseContextBase* CreateParseContext(TSymbolTable& symbolTable, TIntermediate&
 
 const int VersionCount = 17;  // index range in MapVersionToIndex
 
-int MapVersionToIndex(int version)
+// Returns -1 for a version there are no built-in symbol tables for.
+int FindVersionIndex(int version)
 {
-    int index = 0;
+    int index = -1;
 
     switch (version) {
     case 100: index =  0; break;
@@ -157,7 +174,7 @@ int MapVersionToIndex(int version)
     case 500: index =  0; break; // HLSL
     case 320: index = 15; break;
     case 460: index = 16; break;
-    default:  assert(0);  break;
+    default:              break;
     }
 
     assert(index < VersionCount);
@@ -165,6 +182,17 @@ int MapVersionToIndex(int version)
     return index;
 }
 
+int MapVersionToIndex(int version)
+{
+    int index = FindVersionIndex(version);
+    if (index < 0) {
+        assert(0);
+        index = 0;
+    }
+
+    return index;
+}
+
 const int SpvVersionCount = 4;  // index range in MapSpvVersionToIndex
 
 int MapSpvVersionToIndex(const SpvVersion& spvVersion)
@@ -239,13 +267,42 @@ enum EPrecisionClass {
 TSymbolTable* CommonSymbolTable[VersionCount][SpvVersionCount][ProfileCount][SourceCount][EPcCount] = {};
 TSymbolTable* SharedSymbolTables[VersionCount][SpvVersionCount][ProfileCount][SourceCount][EShLangCount] = {};
 
-TPoolAllocator* PerProcessGPA = nullptr;
+// The pool holding the tables of one version/spv-version/profile/source slot, so that
+// different slots can be built at the same time without sharing an allocator.
+TPoolAllocator* BuiltInPools[VersionCount][SpvVersionCount][ProfileCount][SourceCount] = {};
+
+// Each slot is built once, by whichever thread gets its lock first; threads needing
+// other slots are not held up.
+#ifndef DISABLE_THREAD_SUPPORT
+std::mutex BuiltInLocks[VersionCount][SpvVersionCount][ProfileCount][SourceCount];
+#endif
+
+// Set (release) once a slot's tables, pool, and function index are all in place.  They
+// then don't change until the slot is evicted (see EvictBuiltinSymbolTable()), which
+// first clears this, or until ShFinalize().  A compile takes a hold on the slot (see
+// TBuiltInSlotHold) and then seeing this set is all it needs: eviction skips held
+// slots, so the tables stay put until the hold is given back, and lookups of built
+// slots take no lock.  Without a hold, tables can be freed at any time.
+std::atomic<bool> BuiltInsReady[VersionCount][SpvVersionCount][ProfileCount][SourceCount];
+
+// For keeping the built-in tables within glslang::SetBuiltInMemoryBudget(): how many
+// holds (see TBuiltInSlotHold) each slot has, when it was last taken or given back,
+// and roughly how much memory it takes.
+std::atomic<int> BuiltInUsers[VersionCount][SpvVersionCount][ProfileCount][SourceCount];
+std::atomic<unsigned long long> BuiltInLastUse[VersionCount][SpvVersionCount][ProfileCount][SourceCount];
+std::atomic<size_t> BuiltInBytes[VersionCount][SpvVersionCount][ProfileCount][SourceCount];
+std::atomic<size_t> BuiltInBytesTotal(0);
+std::atomic<unsigned long long> BuiltInUseClock(0);
+std::atomic<size_t> BuiltInMemoryBudget(0);  // 0 for no limit
+#ifndef DISABLE_THREAD_SUPPORT
+std::mutex BuiltInEvictionLock;
+#endif
 
 //
 // Parse and add to the given symbol table the content of the given shader string.
 //
 bool InitializeSymbolTable(const TString& builtIns, int version, EProfile profile, const SpvVersion& spvVersion, EShLanguage language,
-                           EShSource source, TInfoSink& infoSink, TSymbolTable& symbolTable)
+                           EShSource source, TInfoSink& infoSink, TSymbolTable& symbolTable, bool quiet = false)
 {
     TIntermediate intermediate(language, version, profile);
 
@@ -280,8 +337,10 @@ bool InitializeSymbolTable(const TString& builtIns, int version, EProfile profil
     TInputScanner input(1, builtInShaders, builtInLengths);
     if (! parseContext->parseShaderStrings(ppContext, input) != 0) {
         infoSink.info.message(EPrefixInternalError, "Unable to parse built-ins");
-        printf("Unable to parse built-ins\n%s\n", infoSink.info.c_str());
-        printf("%s\n", builtInShaders[0]);
+        if (! quiet) {
+            printf("Unable to parse built-ins\n%s\n", infoSink.info.c_str());
+            printf("%s\n", builtInShaders[0]);
+        }
 
         return false;
     }
@@ -294,16 +353,369 @@ int CommonIndex(EProfile profile, EShLanguage language)
     return (profile == EEsProfile && language == EShLangFragment) ? EPcFragment : EPcGeneral;
 }
 
+//
+// The built-in function prototypes of one version/profile/source combination, kept as
+// declaration text grouped by function name, for symbol tables in lazy built-in mode.
+// Each name has the declarations from the common built-in string and from each stage's.
+//
+class TBuiltInFunctionIndex {
+public:
+    static const int CommonSection = EShLangCount;   // sections are stages, or this
+
+    // Move the function prototypes in 'builtIns' to the given section of the index,
+    // and the remaining declarations to 'others'.
+    void split(int section, const TString& builtIns, TString& others);
+
+    // Return the id of the built-in function 'name', or -1 if it's not one.
+    int find(const char* name, size_t length) const
+    {
+        auto it = names.find(std::string(name, length));
+        return it == names.end() ? -1 : it->second;
+    }
+
+    int size() const { return static_cast<int>(descriptors.size()); }
+
+    // Would all the prototypes split() was given parse?  If not, building the shared
+    // tables in full reports why.  Only the first call checks.
+    bool parses(int version, EProfile profile, const SpvVersion& spvVersion, EShSource source);
+
+    // The stages split() was given, in order.
+    const std::vector<EShLanguage>& getStages() const { return stages; }
+
+    // The declarations of function 'id' from the given section, empty if none.
+    TString getDeclarations(int id, int section) const
+    {
+        for (const TDeclarations& declarations : descriptors[id]) {
+            if (declarations.section == section)
+                return TString(text.data() + declarations.offset, declarations.length);
+        }
+        return TString();
+    }
+
+    // Roughly the memory the index takes.
+    size_t getBytes() const
+    {
+        size_t bytes = text.capacity();
+        for (const auto& name : names)
+            bytes += sizeof(name) + name.first.capacity();
+        for (const std::vector<TDeclarations>& declarations : descriptors)
+            bytes += sizeof(declarations) + declarations.capacity() * sizeof(TDeclarations);
+        return bytes;
+    }
+
+protected:
+    static bool isPrototype(const char* statement, size_t length, size_t& nameStart, size_t& nameLength);
+    bool usesStruct(const char* statement, size_t length) const;
+    void addStruct(const char* statement, size_t length);
+    void addCheck(int section, const std::string& returnType, const std::string& parameter);
+    void addChecks(int section, const char* prototype, size_t length, size_t nameStart, size_t nameLength);
+
+    struct TDeclarations {
+        int section;
+        size_t offset;   // into 'text'
+        size_t length;
+    };
+
+    std::string text;
+    std::unordered_map<std::string, int> names;          // function name -> id
+    std::vector<std::vector<TDeclarations>> descriptors; // by id
+    std::vector<EShLanguage> stages;
+    std::vector<std::string> structs;   // declared by the built-ins themselves
+
+    // By section, made-up prototypes for parses(): each distinct return type and
+    // parameter declaration once, as what fails to parse is their types and qualifiers.
+    std::string checks[CommonSection + 1];
+    std::unordered_set<std::string> checked[CommonSection + 1];
+};
+
+inline bool IsIdentifierChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Is the declaration statement 'statement' (ending in ';') a function prototype?
+// If so, find its name.
+bool TBuiltInFunctionIndex::isPrototype(const char* statement, size_t length, size_t& nameStart, size_t& nameLength)
+{
+    // Anything with a body or an initializer is not.
+    for (size_t c = 0; c < length; ++c) {
+        if (statement[c] == '{' || statement[c] == '=')
+            return false;
+    }
+
+    // The name is in front of the parameter list, which ends the statement.
+    size_t c = length - 1;
+    while (c > 0 && isspace(static_cast<unsigned char>(statement[c - 1])))
+        --c;
+    if (c == 0 || statement[c - 1] != ')')
+        return false;
+    int depth = 0;
+    do {
+        --c;
+        if (statement[c] == ')')
+            ++depth;
+        else if (statement[c] == '(')
+            --depth;
+    } while (depth > 0 && c > 0);
+    if (depth > 0)
+        return false;
+    while (c > 0 && isspace(static_cast<unsigned char>(statement[c - 1])))
+        --c;
+    const size_t nameEnd = c;
+    while (c > 0 && IsIdentifierChar(statement[c - 1]))
+        --c;
+    nameStart = c;
+    nameLength = nameEnd - c;
+
+    return nameLength > 0;
+}
+
+// Does the statement mention any of the built-in structure types?  A prototype that
+// does needs their declarations, so it can't be parsed on its own.
+bool TBuiltInFunctionIndex::usesStruct(const char* statement, size_t length) const
+{
+    const std::string text(statement, length);
+    for (const std::string& name : structs) {
+        for (size_t at = text.find(name); at != std::string::npos; at = text.find(name, at + 1)) {
+            const size_t end = at + name.size();
+            if ((at == 0 || ! IsIdentifierChar(text[at - 1])) && (end == text.size() || ! IsIdentifierChar(text[end])))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// Remember the name of a "struct name { ... };" statement.
+void TBuiltInFunctionIndex::addStruct(const char* statement, size_t length)
+{
+    size_t c = 0;
+    while (c < length && isspace(static_cast<unsigned char>(statement[c])))
+        ++c;
+    if (length - c <= 6 || strncmp(statement + c, "struct", 6) != 0 || ! isspace(static_cast<unsigned char>(statement[c + 6])))
+        return;
+    c += 6;
+    while (c < length && isspace(static_cast<unsigned char>(statement[c])))
+        ++c;
+    const size_t nameStart = c;
+    while (c < length && IsIdentifierChar(statement[c]))
+        ++c;
+    if (c > nameStart)
+        structs.push_back(std::string(statement + nameStart, c - nameStart));
+}
+
+void TBuiltInFunctionIndex::addCheck(int section, const std::string& returnType, const std::string& parameter)
+{
+    if (checked[section].insert(returnType + "(" + parameter).second)
+        checks[section] += returnType + " builtInCheck" + std::to_string(section) + "_" +
+                           std::to_string(checked[section].size()) + "(" + parameter + ");\n";
+}
+
+void TBuiltInFunctionIndex::addChecks(int section, const char* prototype, size_t length, size_t nameStart, size_t nameLength)
+{
+    addCheck(section, std::string(prototype, nameStart), "");
+
+    // The parameters are between the '(' after the name and the final ')'.
+    size_t c = nameStart + nameLength;
+    while (c < length && prototype[c] != '(')
+        ++c;
+    size_t end = length;
+    while (end > c && prototype[end - 1] != ')')
+        --end;
+    for (size_t param = c + 1; param < end; ) {
+        size_t next = param;
+        int depth = 0;
+        for (; next < end - 1; ++next) {
+            if (prototype[next] == '(' || prototype[next] == '[')
+                ++depth;
+            else if (prototype[next] == ')' || prototype[next] == ']')
+                --depth;
+            else if (prototype[next] == ',' && depth == 0)
+                break;
+        }
+        std::string parameter(prototype + param, next - param);
+        const size_t first = parameter.find_first_not_of(" \t\n");
+        if (first != std::string::npos) {
+            parameter = parameter.substr(first, parameter.find_last_not_of(" \t\n") + 1 - first);
+            if (parameter != "void")
+                addCheck(section, "void", parameter);
+        }
+        param = next + 1;
+    }
+}
+
+void TBuiltInFunctionIndex::split(int section, const TString& builtIns, TString& others)
+{
+    // Gather the prototypes by name, keeping their order within a name.
+    std::unordered_map<std::string, std::string> prototypes;
+    std::vector<std::string> order;
+
+    const char* source = builtIns.c_str();
+    const size_t length = builtIns.size();
+    size_t start = 0;
+    while (start < length) {
+        // statements end with a ';' outside of any braces
+        size_t end = start;
+        int depth = 0;
+        for (; end < length; ++end) {
+            if (source[end] == '{')
+                ++depth;
+            else if (source[end] == '}')
+                --depth;
+            else if (source[end] == ';' && depth == 0)
+                break;
+        }
+        if (end == length) {
+            others.append(source + start, length - start);
+            break;
+        }
+        ++end;
+
+        size_t nameStart;
+        size_t nameLength;
+        if (isPrototype(source + start, end - start, nameStart, nameLength) && ! usesStruct(source + start, end - start)) {
+            std::string name(source + start + nameStart, nameLength);
+            std::string& declarations = prototypes[name];
+            if (declarations.empty())
+                order.push_back(name);
+            declarations.append(source + start, end - start);
+
+            addChecks(section, source + start, end - start, nameStart, nameLength);
+        } else {
+            addStruct(source + start, end - start);
+            others.append(source + start, end - start);
+        }
+
+        start = end;
+    }
+
+    // The parser doesn't accept an empty translation unit.
+    if (others.find_first_not_of(" \t\n") == TString::npos)
+        others.clear();
+
+    if (section != CommonSection)
+        stages.push_back(static_cast<EShLanguage>(section));
+
+    for (const std::string& name : order) {
+        auto inserted = names.insert(std::make_pair(name, size()));
+        if (inserted.second)
+            descriptors.resize(descriptors.size() + 1);
+        const std::string& declarations = prototypes[name];
+        descriptors[inserted.first->second].push_back({ section, text.size(), declarations.size() });
+        text.append(declarations);
+    }
+}
+
+bool TBuiltInFunctionIndex::parses(int version, EProfile profile, const SpvVersion& spvVersion, EShSource source)
+{
+    // Mirror InitializeSymbolTables(), quietly, in tables that are thrown away.
+    TInfoSink infoSink;
+    TSymbolTable commonTable[EPcCount];
+    const TString common(checks[CommonSection].c_str());
+    bool success = InitializeSymbolTable(common, version, profile, spvVersion, EShLangVertex, source, infoSink,
+                                         commonTable[EPcGeneral], true);
+    if (success && profile == EEsProfile)
+        success = InitializeSymbolTable(common, version, profile, spvVersion, EShLangFragment, source, infoSink,
+                                        commonTable[EPcFragment], true);
+    for (size_t s = 0; s < stages.size() && success; ++s) {
+        TSymbolTable stageTable;
+        stageTable.adoptLevels(commonTable[CommonIndex(profile, stages[s])]);
+        success = InitializeSymbolTable(TString(checks[stages[s]].c_str()), version, profile, spvVersion, stages[s],
+                                        source, infoSink, stageTable, true);
+    }
+
+    for (int section = 0; section <= CommonSection; ++section) {
+        std::string().swap(checks[section]);
+        std::unordered_set<std::string>().swap(checked[section]);
+    }
+
+    return success;
+}
+
+TBuiltInFunctionIndex* BuiltInFunctionIndex[VersionCount][SpvVersionCount][ProfileCount][SourceCount] = {};
+
+//
+// Adds built-in functions from a TBuiltInFunctionIndex to one compile's symbol table,
+// parsing their prototypes the first time their name is looked up, the same as they
+// would have been when building the shared tables.
+//
+class TLazyBuiltInFunctions : public TBuiltInFunctionSource {
+public:
+    TLazyBuiltInFunctions(const TBuiltInFunctionIndex& index, int version, EProfile profile, const SpvVersion& spvVersion,
+                          EShLanguage stage, EShSource source)
+        : index(index), version(version), profile(profile), spvVersion(spvVersion), stage(stage), source(source),
+          materialized(index.size(), false) { }
+
+    void materialize(const char* name, size_t length, TSymbolTable& symbolTable) override;
+
+protected:
+    TLazyBuiltInFunctions(const TLazyBuiltInFunctions&);
+    TLazyBuiltInFunctions& operator=(const TLazyBuiltInFunctions&);
+
+    const TBuiltInFunctionIndex& index;
+    const int version;
+    const EProfile profile;
+    const SpvVersion spvVersion;
+    const EShLanguage stage;
+    const EShSource source;
+    std::vector<bool> materialized;   // by function id
+};
+
+void TLazyBuiltInFunctions::materialize(const char* name, size_t length, TSymbolTable& symbolTable)
+{
+    const int id = index.find(name, length);
+    if (id < 0 || materialized[id])
+        return;
+    materialized[id] = true;
+
+    TInfoSink infoSink;
+    std::unique_ptr<TBuiltInParseables> builtInParseables(CreateBuiltInParseables(infoSink, source));
+    if (builtInParseables == nullptr)
+        return;
+
+    // Mirror building the shared tables: a common level parsed as the stage its
+    // precision class is parsed as, and this stage's level on top of it.
+    const int precClass = CommonIndex(profile, stage);
+    TSymbolTable commonTable;
+    commonTable.overwriteUniqueId(symbolTable.getMaxSymbolId());
+    if (! InitializeSymbolTable(index.getDeclarations(id, TBuiltInFunctionIndex::CommonSection), version, profile,
+                                spvVersion, precClass == EPcFragment ? EShLangFragment : EShLangVertex, source,
+                                infoSink, commonTable))
+        return;
+    TSymbolTable stageTable;
+    stageTable.adoptLevels(commonTable);
+    if (! InitializeSymbolTable(index.getDeclarations(id, stage), version, profile, spvVersion, stage, source,
+                                infoSink, stageTable))
+        return;
+
+    // Every stage sharing the common level identified its built-ins there too, so
+    // this stage's view of a common function can depend on the others.
+    for (EShLanguage identifying : index.getStages()) {
+        if (CommonIndex(profile, identifying) == precClass)
+            builtInParseables->identifyBuiltIns(version, profile, spvVersion, identifying,
+                                                identifying == stage ? stageTable : commonTable);
+    }
+
+    symbolTable.insertBuiltInFunctions(stageTable);
+}
+
 //
 // To initialize per-stage shared tables, with the common table already complete.
 //
 bool InitializeStageSymbolTable(TBuiltInParseables& builtInParseables, int version, EProfile profile, const SpvVersion& spvVersion,
                                 EShLanguage language, EShSource source, TInfoSink& infoSink, TSymbolTable** commonTable,
-                                TSymbolTable** symbolTables)
+                                TSymbolTable** symbolTables, TBuiltInFunctionIndex* functionIndex)
 {
+    const TString* builtIns = &builtInParseables.getStageString(language);
+    TString others;
+    if (functionIndex != nullptr) {
+        functionIndex->split(language, *builtIns, others);
+        builtIns = &others;
+    }
+
     (*symbolTables[language]).adoptLevels(*commonTable[CommonIndex(profile, language)]);
-    if (!InitializeSymbolTable(builtInParseables.getStageString(language), version, profile, spvVersion, language, source,
-                          infoSink, *symbolTables[language]))
+    if (!InitializeSymbolTable(*builtIns, version, profile, spvVersion, language, source,
+                          infoSink, *symbolTables[language], functionIndex != nullptr))
         return false;
     builtInParseables.identifyBuiltIns(version, profile, spvVersion, language, *symbolTables[language]);
     if (profile == EEsProfile && version >= 300)
@@ -318,7 +730,11 @@ bool InitializeStageSymbolTable(TBuiltInParseables& builtInParseables, int versi
 // Initialize the full set of shareable symbol tables;
 // The common (cross-stage) and those shareable per-stage.
 //
-bool InitializeSymbolTables(TInfoSink& infoSink, TSymbolTable** commonTable,  TSymbolTable** symbolTables, int version, EProfile profile, const SpvVersion& spvVersion, EShSource source)
+// With a 'functionIndex', the function prototypes go there instead of in the tables,
+// and failures aren't reported; see SetupBuiltinSymbolTable().
+//
+bool InitializeSymbolTables(TInfoSink& infoSink, TSymbolTable** commonTable,  TSymbolTable** symbolTables, int version, EProfile profile,
+                            const SpvVersion& spvVersion, EShSource source, TBuiltInFunctionIndex* functionIndex)
 {
     bool success = true;
     std::unique_ptr<TBuiltInParseables> builtInParseables(CreateBuiltInParseables(infoSink, source));
@@ -328,69 +744,76 @@ bool InitializeSymbolTables(TInfoSink& infoSink, TSymbolTable** commonTable,  TS
 
     builtInParseables->initialize(version, profile, spvVersion);
 
+    const TString* commonBuiltIns = &builtInParseables->getCommonString();
+    TString commonOthers;
+    if (functionIndex != nullptr) {
+        functionIndex->split(TBuiltInFunctionIndex::CommonSection, *commonBuiltIns, commonOthers);
+        commonBuiltIns = &commonOthers;
+    }
+
     // do the common tables
-    success &= InitializeSymbolTable(builtInParseables->getCommonString(), version, profile, spvVersion, EShLangVertex, source,
-                          infoSink, *commonTable[EPcGeneral]);
+    success &= InitializeSymbolTable(*commonBuiltIns, version, profile, spvVersion, EShLangVertex, source,
+                          infoSink, *commonTable[EPcGeneral], functionIndex != nullptr);
     if (profile == EEsProfile)
-        success &= InitializeSymbolTable(builtInParseables->getCommonString(), version, profile, spvVersion, EShLangFragment, source,
-                              infoSink, *commonTable[EPcFragment]);
+        success &= InitializeSymbolTable(*commonBuiltIns, version, profile, spvVersion, EShLangFragment, source,
+                              infoSink, *commonTable[EPcFragment], functionIndex != nullptr);
 
     // do the per-stage tables
 
     // always have vertex and fragment
     success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangVertex, source,
-                               infoSink, commonTable, symbolTables);
+                               infoSink, commonTable, symbolTables, functionIndex);
     success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangFragment, source,
-                               infoSink, commonTable, symbolTables);
+                               infoSink, commonTable, symbolTables, functionIndex);
 
     // check for tessellation
     if ((profile != EEsProfile && version >= 150) ||
         (profile == EEsProfile && version >= 310)) {
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangTessControl, source,
-                                   infoSink, commonTable, symbolTables);
+                                   infoSink, commonTable, symbolTables, functionIndex);
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangTessEvaluation, source,
-                                   infoSink, commonTable, symbolTables);
+                                   infoSink, commonTable, symbolTables, functionIndex);
     }
 
     // check for geometry
     if ((profile != EEsProfile && version >= 150) ||
         (profile == EEsProfile && version >= 310))
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangGeometry, source,
-                                   infoSink, commonTable, symbolTables);
+                                   infoSink, commonTable, symbolTables, functionIndex);
 
     // check for compute
     if ((profile != EEsProfile && version >= 420) ||
         (profile == EEsProfile && version >= 310))
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangCompute, source,
-                                   infoSink, commonTable, symbolTables);
+                                   infoSink, commonTable, symbolTables, functionIndex);
 
     // check for ray tracing stages
     if (profile != EEsProfile && version >= 450) {
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangRayGen, source,
-            infoSink, commonTable, symbolTables);
+            infoSink, commonTable, symbolTables, functionIndex);
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangIntersect, source,
-            infoSink, commonTable, symbolTables);
+            infoSink, commonTable, symbolTables, functionIndex);
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangAnyHit, source,
-            infoSink, commonTable, symbolTables);
+            infoSink, commonTable, symbolTables, functionIndex);
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangClosestHit, source,
-            infoSink, commonTable, symbolTables);
+            infoSink, commonTable, symbolTables, functionIndex);
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangMiss, source,
-            infoSink, commonTable, symbolTables);
+            infoSink, commonTable, symbolTables, functionIndex);
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangCallable, source,
-            infoSink, commonTable, symbolTables);
+            infoSink, commonTable, symbolTables, functionIndex);
     }
 
     // check for mesh
     if ((profile != EEsProfile && version >= 450) ||
         (profile == EEsProfile && version >= 320))
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangMesh, source,
-                                   infoSink, commonTable, symbolTables);
+                                   infoSink, commonTable, symbolTables, functionIndex);
 
     // check for task
     if ((profile != EEsProfile && version >= 450) ||
         (profile == EEsProfile && version >= 320))
         success &= InitializeStageSymbolTable(*builtInParseables, version, profile, spvVersion, EShLangTask, source,
-                                   infoSink, commonTable, symbolTables);
+                                   infoSink, commonTable, symbolTables, functionIndex);
 
     return success;
 }
@@ -411,34 +834,143 @@ bool AddContextSpecificSymbols(const TBuiltInResource* resources, TInfoSink& inf
     return true;
 }
 
+//
+// The tables AddContextSpecificSymbols() makes for one version/profile combination,
+// kept for reuse by compiles with the same resources, SPIR-V environment and stage.
+// Each adopts the shared levels of its stage and adds the context-specific level,
+// read-only, for compiles to adopt in turn.  Lookups go under a lock, but parsing a
+// new table does not.
+//
+class TContextSymbolTables {
+public:
+    // 'bytes' is what to add the memory taken by the tables to.
+    explicit TContextSymbolTables(std::atomic<size_t>& bytes) : bytes(bytes), pool(new TPoolAllocator) { }
+    ~TContextSymbolTables()
+    {
+        for (auto& table : tables)
+            delete table.second;
+        delete pool;
+    }
+
+    // Find or make the table for a compile that would add the context-specific
+    // symbols to a table adopting 'shared'.  Returns nullptr if they don't parse.
+    TSymbolTable* find(const TBuiltInResource& resources, TInfoSink& infoSink, int version, EProfile profile,
+                       const SpvVersion& spvVersion, EShLanguage language, EShSource source,
+                       TSymbolTable& shared)
+    {
+        // Only the integers in the resources change the built-ins, not the limits.
+        std::string key(reinterpret_cast<const char*>(&resources), offsetof(TBuiltInResource, limits));
+        for (long long field : { (long long)spvVersion.spv, (long long)spvVersion.vulkanGlsl, (long long)spvVersion.vulkan,
+                                 (long long)spvVersion.openGl, (long long)spvVersion.vulkanRelaxed,
+                                 (long long)language })
+            key.append(reinterpret_cast<const char*>(&field), sizeof(field));
+
+        {
+#ifndef DISABLE_THREAD_SUPPORT
+            const std::lock_guard<std::mutex> guard(lock);
+#endif
+            auto it = tables.find(key);
+            if (it != tables.end())
+                return it->second;
+        }
+
+        // Parse in a pool of its own, as SetupBuiltinSymbolTable() does, and keep a copy.
+        TPoolAllocator& previousAllocator = GetThreadPoolAllocator();
+        TPoolAllocator* parsePool = new TPoolAllocator;
+        SetThreadPoolAllocator(parsePool);
+
+        TSymbolTable* parsed = new TSymbolTable;
+        parsed->adoptLevels(shared);
+
+        TSymbolTable* table = nullptr;
+        if (AddContextSpecificSymbols(&resources, infoSink, *parsed, version, profile, spvVersion, language, source)) {
+#ifndef DISABLE_THREAD_SUPPORT
+            const std::lock_guard<std::mutex> guard(lock);
+#endif
+            auto it = tables.find(key);
+            if (it != tables.end())
+                table = it->second;
+            else {
+                const size_t poolBytes = pool->getBytesInUse();
+                SetThreadPoolAllocator(pool);
+                table = new TSymbolTable;
+                table->adoptLevels(shared);
+                table->copyTable(*parsed);
+                table->readOnly();
+                tables[key] = table;
+                bytes += pool->getBytesInUse() - poolBytes;
+                BuiltInBytesTotal += pool->getBytesInUse() - poolBytes;
+            }
+        }
+
+        delete parsed;
+        delete parsePool;
+        SetThreadPoolAllocator(&previousAllocator);
+
+        return table;
+    }
+
+protected:
+    std::atomic<size_t>& bytes;
+    TPoolAllocator* pool;
+    std::unordered_map<std::string, TSymbolTable*> tables;
+#ifndef DISABLE_THREAD_SUPPORT
+    std::mutex lock;
+#endif
+};
+
+// The TContextSymbolTables of each version/profile combination, made with its shared
+// tables, and freed before them.
+TContextSymbolTables* ContextSymbolTables[VersionCount][SpvVersionCount][ProfileCount][SourceCount] = {};
+
 //
 // To do this on the fly, we want to leave the current state of our thread's
 // pool allocator intact, so:
 //  - Switch to a new pool for parsing the built-ins
 //  - Do the parsing, which builds the symbol table, using the new pool
-//  - Switch to the process-global pool to save a copy of the resulting symbol table
+//  - Switch to the slot's own pool to save a copy of the resulting symbol table
 //  - Free up the new pool used to parse the built-ins
 //  - Switch back to the original thread's pool
 //
 // This only gets done the first time any thread needs a particular symbol table
-// (lazy evaluation).
+// (lazy evaluation), or up front through glslang::PrewarmBuiltins().
 //
-bool SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& spvVersion, EShSource source)
+// With 'hold', also count a user of the tables, which the caller must give back (see
+// TBuiltInSlotHold), so they can't be evicted before the caller is done with them.
+//
+bool SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& spvVersion, EShSource source,
+                             bool hold = false)
 {
     TInfoSink infoSink;
     bool success;
 
-    // Make sure only one thread tries to do this at a time
-#ifndef DISABLE_THREAD_SUPPORT
-    const std::lock_guard<std::mutex> lock(init_lock);
-#endif
-
-    // See if it's already been done for this version/profile combination
     int versionIndex = MapVersionToIndex(version);
     int spvVersionIndex = MapSpvVersionToIndex(spvVersion);
     int profileIndex = MapProfileToIndex(profile);
     int sourceIndex = MapSourceToIndex(source);
-    if (CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][EPcGeneral]) {
+    std::atomic<bool>& ready = BuiltInsReady[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    std::atomic<int>& users = BuiltInUsers[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+
+    // See if it's already been done for this version/profile combination.  A hold is
+    // counted before looking, so that an eviction either sees it or is seen by it (see
+    // EvictBuiltinSymbolTable()); if evicted, it is taken again below, under the lock.
+    if (hold) {
+        ++users;
+        if (ready.load())
+            return true;
+        --users;
+    } else if (ready.load(std::memory_order_acquire))
+        return true;
+
+    // Make sure only one thread tries to do this at a time for this combination
+#ifndef DISABLE_THREAD_SUPPORT
+    const std::lock_guard<std::mutex> lock(BuiltInLocks[versionIndex][spvVersionIndex][profileIndex][sourceIndex]);
+#endif
+
+    // Another thread may have done it while this one waited for the lock
+    if (ready.load(std::memory_order_relaxed)) {
+        if (hold)
+            ++users;
         return true;
     }
 
@@ -450,21 +982,45 @@ bool SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& sp
     // Dynamically allocate the local symbol tables so we can control when they are deallocated WRT when the pool is popped.
     TSymbolTable* commonTable[EPcCount];
     TSymbolTable* stageTables[EShLangCount];
+    std::unique_ptr<TBuiltInFunctionIndex> functionIndex;
     for (int precClass = 0; precClass < EPcCount; ++precClass)
         commonTable[precClass] = new TSymbolTable;
     for (int stage = 0; stage < EShLangCount; ++stage)
         stageTables[stage] = new TSymbolTable;
 
-    // Generate the local symbol tables using the new pool
-    if (!InitializeSymbolTables(infoSink, commonTable, stageTables, version, profile, spvVersion, source)) {
+    // In lazy mode, keep the GLSL function prototypes aside for compiles to parse on demand
+    if (LazyBuiltIns && source == EShSourceGlsl)
+        functionIndex.reset(new TBuiltInFunctionIndex);
+
+    // Generate the local symbol tables using the new pool.  In lazy mode, if the built-ins
+    // wouldn't all parse, generate them in full instead, to fail the same way as without it.
+    if (functionIndex != nullptr) {
+        TInfoSink lazyInfoSink;
+        if (! InitializeSymbolTables(lazyInfoSink, commonTable, stageTables, version, profile, spvVersion, source,
+                                     functionIndex.get()) ||
+            ! functionIndex->parses(version, profile, spvVersion, source)) {
+            functionIndex.reset();
+            for (int stage = 0; stage < EShLangCount; ++stage) {
+                delete stageTables[stage];
+                stageTables[stage] = new TSymbolTable;
+            }
+            for (int precClass = 0; precClass < EPcCount; ++precClass) {
+                delete commonTable[precClass];
+                commonTable[precClass] = new TSymbolTable;
+            }
+        }
+    }
+    if (functionIndex == nullptr &&
+        ! InitializeSymbolTables(infoSink, commonTable, stageTables, version, profile, spvVersion, source, nullptr)) {
         success = false;
         goto cleanup;
     }
 
-    // Switch to the process-global pool
-    SetThreadPoolAllocator(PerProcessGPA);
+    // Switch to the slot's pool
+    BuiltInPools[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = new TPoolAllocator;
+    SetThreadPoolAllocator(BuiltInPools[versionIndex][spvVersionIndex][profileIndex][sourceIndex]);
 
-    // Copy the local symbol tables from the new pool to the global tables using the process-global pool
+    // Copy the local symbol tables from the new pool to the global tables using the slot's pool
     for (int precClass = 0; precClass < EPcCount; ++precClass) {
         if (! commonTable[precClass]->isEmpty()) {
             CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass] = new TSymbolTable;
@@ -481,6 +1037,16 @@ bool SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& sp
             SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage]->readOnly();
         }
     }
+    BuiltInBytes[versionIndex][spvVersionIndex][profileIndex][sourceIndex] =
+        BuiltInPools[versionIndex][spvVersionIndex][profileIndex][sourceIndex]->getBytesInUse() +
+        (functionIndex ? functionIndex->getBytes() : 0);
+    BuiltInBytesTotal += BuiltInBytes[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    BuiltInFunctionIndex[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = functionIndex.release();
+    ContextSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex] =
+        new TContextSymbolTables(BuiltInBytes[versionIndex][spvVersionIndex][profileIndex][sourceIndex]);
+    if (hold)
+        ++users;
+    ready.store(true, std::memory_order_release);
     success = true;
 
 cleanup:
@@ -496,6 +1062,333 @@ cleanup:
     return success;
 }
 
+//
+// Delete the tables of one slot, and the pool they are in.  Called with the slot's
+// lock held and the slot not ready, or at ShFinalize().
+//
+void FreeBuiltinSymbolTable(int versionIndex, int spvVersionIndex, int profileIndex, int sourceIndex)
+{
+    delete ContextSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    ContextSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = nullptr;
+
+    // The stage tables adopted levels of the common tables, so go first.
+    for (int stage = 0; stage < EShLangCount; ++stage) {
+        delete SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage];
+        SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage] = nullptr;
+    }
+    for (int precClass = 0; precClass < EPcCount; ++precClass) {
+        delete CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass];
+        CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass] = nullptr;
+    }
+    delete BuiltInFunctionIndex[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    BuiltInFunctionIndex[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = nullptr;
+    delete BuiltInPools[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    BuiltInPools[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = nullptr;
+
+    BuiltInBytesTotal -= BuiltInBytes[versionIndex][spvVersionIndex][profileIndex][sourceIndex].exchange(0);
+}
+
+//
+// Free the tables of one slot, unless something holds them.  Called with the slot's
+// lock held.
+//
+// A hold is counted before its taker checks the slot is ready, and here the slot is
+// marked not ready before checking for holds.  These being sequentially consistent,
+// either this sees the hold, or the taker sees the slot not ready, gives the hold
+// back, and waits on the lock to take it again.
+//
+bool EvictBuiltinSymbolTable(int versionIndex, int spvVersionIndex, int profileIndex, int sourceIndex)
+{
+    std::atomic<bool>& ready = BuiltInsReady[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    std::atomic<int>& users = BuiltInUsers[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    if (! ready.load(std::memory_order_relaxed) || users.load() != 0)
+        return false;
+
+    ready.store(false);
+    if (users.load() != 0) {
+        ready.store(true);
+        return false;
+    }
+
+    FreeBuiltinSymbolTable(versionIndex, spvVersionIndex, profileIndex, sourceIndex);
+
+    return true;
+}
+
+//
+// While the built-in tables take more than the budget set by
+// glslang::SetBuiltInMemoryBudget(), evict the least recently used slot nothing holds.
+//
+void EvictBuiltinSymbolTables()
+{
+    const size_t budget = BuiltInMemoryBudget.load();
+    if (budget == 0 || BuiltInBytesTotal.load() <= budget)
+        return;
+
+#ifndef DISABLE_THREAD_SUPPORT
+    const std::lock_guard<std::mutex> evictionLock(BuiltInEvictionLock);
+#endif
+
+    // Slots that turn out to be held are not tried again this time.
+    bool held[VersionCount][SpvVersionCount][ProfileCount][SourceCount] = {};
+    while (BuiltInBytesTotal.load() > budget) {
+        int v = -1, s = -1, p = -1, src = -1;
+        unsigned long long oldest = 0;
+        for (int version = 0; version < VersionCount; ++version) {
+            for (int spvVersion = 0; spvVersion < SpvVersionCount; ++spvVersion) {
+                for (int profile = 0; profile < ProfileCount; ++profile) {
+                    for (int source = 0; source < SourceCount; ++source) {
+                        if (held[version][spvVersion][profile][source] ||
+                            ! BuiltInsReady[version][spvVersion][profile][source].load(std::memory_order_relaxed) ||
+                            BuiltInUsers[version][spvVersion][profile][source].load(std::memory_order_relaxed) != 0)
+                            continue;
+                        const unsigned long long lastUse = BuiltInLastUse[version][spvVersion][profile][source];
+                        if (v < 0 || lastUse < oldest) {
+                            v = version; s = spvVersion; p = profile; src = source;
+                            oldest = lastUse;
+                        }
+                    }
+                }
+            }
+        }
+        if (v < 0)
+            break;
+
+#ifndef DISABLE_THREAD_SUPPORT
+        const std::lock_guard<std::mutex> lock(BuiltInLocks[v][s][p][src]);
+#endif
+        if (! EvictBuiltinSymbolTable(v, s, p, src))
+            held[v][s][p][src] = true;
+    }
+}
+
+//
+// Keeps the built-in tables of one slot from being evicted while a compile, or the
+// intermediate it made, may still point into them.
+//
+class TBuiltInSlotHold : public TIntermediateHold {
+public:
+    // For a user already counted by SetupBuiltinSymbolTable().
+    TBuiltInSlotHold(int versionIndex, int spvVersionIndex, int profileIndex, int sourceIndex) :
+        users(BuiltInUsers[versionIndex][spvVersionIndex][profileIndex][sourceIndex]),
+        lastUse(BuiltInLastUse[versionIndex][spvVersionIndex][profileIndex][sourceIndex])
+    {
+        lastUse = ++BuiltInUseClock;
+    }
+
+    virtual ~TBuiltInSlotHold() override
+    {
+        lastUse = ++BuiltInUseClock;
+        if (--users == 0)
+            EvictBuiltinSymbolTables();
+    }
+
+protected:
+    std::atomic<int>& users;
+    std::atomic<unsigned long long>& lastUse;
+};
+
+//
+// Set up the built-in tables for a version/profile combination, as for
+// SetupBuiltinSymbolTable(), and hold them until the returned hold is deleted.
+// Returns nullptr if they can't be set up.
+//
+TBuiltInSlotHold* AcquireBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& spvVersion, EShSource source)
+{
+    if (! SetupBuiltinSymbolTable(version, profile, spvVersion, source, true))
+        return nullptr;
+
+    TBuiltInSlotHold* hold = new TBuiltInSlotHold(MapVersionToIndex(version), MapSpvVersionToIndex(spvVersion),
+                                                  MapProfileToIndex(profile), MapSourceToIndex(source));
+
+    // Now that these are held, other tables can make room for them.
+    EvictBuiltinSymbolTables();
+
+    return hold;
+}
+
+// The SpvVersion built-ins are generated for, for a public target tuple; only
+// what selects a symbol table slot (see MapSpvVersionToIndex) matters here.
+SpvVersion MapTargetTupleToSpvVersion(const TargetTuple& target)
+{
+    SpvVersion spvVersion;
+    switch (target.client) {
+    case EShClientOpenGL:
+        spvVersion.spv = EShTargetSpv_1_0;
+        spvVersion.openGl = 100;
+        break;
+    case EShClientVulkan:
+        spvVersion.spv = EShTargetSpv_1_0;
+        spvVersion.vulkan = EShTargetVulkan_1_0;
+        spvVersion.vulkanGlsl = 100;
+        spvVersion.vulkanRelaxed = target.vulkanRulesRelaxed;
+        break;
+    default:
+        break;
+    }
+
+    return spvVersion;
+}
+
+// The version and profile built-ins are generated for, for a public target tuple.
+void MapTargetTupleToVersionProfile(const TargetTuple& target, int& version, EProfile& profile)
+{
+    version = target.version;
+    profile = target.profile;
+    if (target.source == EShSourceHlsl) {
+        version = 500;          // as for DeduceVersionProfile()
+        profile = ECoreProfile;
+    }
+}
+
+//
+// Write the process-global built-in tables for one version/profile/source combination
+// to an image, building them first if needed.
+//
+bool SaveBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& spvVersion, EShSource source,
+                            std::vector<unsigned char>& image)
+{
+    std::unique_ptr<TBuiltInSlotHold> hold(AcquireBuiltinSymbolTable(version, profile, spvVersion, source));
+    if (! hold)
+        return false;
+
+    int versionIndex = MapVersionToIndex(version);
+    int spvVersionIndex = MapSpvVersionToIndex(spvVersion);
+    int profileIndex = MapProfileToIndex(profile);
+    int sourceIndex = MapSourceToIndex(source);
+
+    // Images hold complete tables, not ones waiting for their functions.
+    if (BuiltInFunctionIndex[versionIndex][spvVersionIndex][profileIndex][sourceIndex] != nullptr)
+        return false;
+
+    TSymbolTableWriter writer(image);
+    writer.writeFingerprint();
+    writer.writeInt(versionIndex);
+    writer.writeInt(spvVersionIndex);
+    writer.writeInt(profile);
+    writer.writeInt(source);
+
+    for (int precClass = 0; precClass < EPcCount; ++precClass) {
+        const TSymbolTable* table = CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass];
+        writer.writeInt(table != nullptr);
+        if (table != nullptr)
+            writer.writeTable(*table);
+    }
+    for (int stage = 0; stage < EShLangCount; ++stage) {
+        const TSymbolTable* table = SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage];
+        writer.writeInt(table != nullptr);
+        if (table != nullptr)
+            writer.writeTable(*table);
+    }
+
+    return writer.success();
+}
+
+//
+// Install the built-in tables held in an image written by SaveBuiltinSymbolTable(),
+// so that SetupBuiltinSymbolTable() finds them already done and parses nothing.
+//
+// Tables that are already present are left alone.
+//
+bool LoadBuiltinSymbolTable(const unsigned char* data, size_t size)
+{
+    TSymbolTableReader reader(data, size);
+
+    int versionIndex, spvVersionIndex, profileInt, sourceInt;
+    if (! reader.readFingerprint() ||
+        ! reader.readInt(versionIndex) || ! reader.readInt(spvVersionIndex) ||
+        ! reader.readInt(profileInt) || ! reader.readInt(sourceInt))
+        return false;
+    if (versionIndex < 0 || versionIndex >= VersionCount || spvVersionIndex < 0 || spvVersionIndex >= SpvVersionCount)
+        return false;
+    // The index mappings send unknown values to slot 0, so check them here instead.
+    const EProfile profile = static_cast<EProfile>(profileInt);
+    if (profile != ENoProfile && profile != ECoreProfile && profile != ECompatibilityProfile && profile != EEsProfile)
+        return false;
+    if (sourceInt != EShSourceGlsl && sourceInt != EShSourceHlsl)
+        return false;
+    const int profileIndex = MapProfileToIndex(profile);
+    const int sourceIndex = MapSourceToIndex(static_cast<EShSource>(sourceInt));
+
+    {
+#ifndef DISABLE_THREAD_SUPPORT
+        const std::lock_guard<std::mutex> lock(init_lock);
+#endif
+        if (NumberOfClients == 0)
+            return false;
+    }
+
+#ifndef DISABLE_THREAD_SUPPORT
+    const std::lock_guard<std::mutex> lock(BuiltInLocks[versionIndex][spvVersionIndex][profileIndex][sourceIndex]);
+#endif
+
+    std::atomic<bool>& ready = BuiltInsReady[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    if (ready.load(std::memory_order_relaxed))
+        return true;
+
+    // Build directly in a pool for the slot, as SetupBuiltinSymbolTable() copies to one.
+    TPoolAllocator& previousAllocator = GetThreadPoolAllocator();
+    TPoolAllocator* slotPool = new TPoolAllocator;
+    SetThreadPoolAllocator(slotPool);
+
+    TSymbolTable* commonTable[EPcCount] = {};
+    TSymbolTable* stageTables[EShLangCount] = {};
+    bool success = true;
+    for (int precClass = 0; precClass < EPcCount && success; ++precClass) {
+        int present = 0;
+        success = reader.readInt(present);
+        if (success && present) {
+            commonTable[precClass] = new TSymbolTable;
+            success = reader.readTable(*commonTable[precClass]);
+        }
+    }
+    for (int stage = 0; stage < EShLangCount && success; ++stage) {
+        int present = 0;
+        success = reader.readInt(present);
+        if (success && present) {
+            TSymbolTable* common = commonTable[CommonIndex(profile, (EShLanguage)stage)];
+            if (common == nullptr) {
+                success = false;
+                break;
+            }
+            stageTables[stage] = new TSymbolTable;
+            stageTables[stage]->adoptLevels(*common);
+            success = reader.readTable(*stageTables[stage]);
+        }
+    }
+    success = success && reader.atEnd() && commonTable[EPcGeneral] != nullptr;
+
+    if (success) {
+        for (int precClass = 0; precClass < EPcCount; ++precClass) {
+            if (commonTable[precClass] != nullptr)
+                commonTable[precClass]->readOnly();
+            CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass] = commonTable[precClass];
+        }
+        for (int stage = 0; stage < EShLangCount; ++stage) {
+            if (stageTables[stage] != nullptr)
+                stageTables[stage]->readOnly();
+            SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][stage] = stageTables[stage];
+        }
+        BuiltInPools[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = slotPool;
+        ContextSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex] =
+            new TContextSymbolTables(BuiltInBytes[versionIndex][spvVersionIndex][profileIndex][sourceIndex]);
+        BuiltInBytes[versionIndex][spvVersionIndex][profileIndex][sourceIndex] = slotPool->getBytesInUse();
+        BuiltInBytesTotal += slotPool->getBytesInUse();
+        ready.store(true, std::memory_order_release);
+    } else {
+        // The stage tables adopted levels of the common tables, so go first.
+        for (int stage = 0; stage < EShLangCount; ++stage)
+            delete stageTables[stage];
+        for (int precClass = 0; precClass < EPcCount; ++precClass)
+            delete commonTable[precClass];
+        delete slotPool;
+    }
+
+    SetThreadPoolAllocator(&previousAllocator);
+
+    return success;
+}
+
 // Function to Print all builtins
 void DumpBuiltinSymbolTable(TInfoSink& infoSink, const TSymbolTable& symbolTable)
 {
@@ -824,6 +1717,8 @@ bool ProcessDeferred(
     if (numStrings == 0)
         return true;
 
+    TMemoryPhaseMarker memoryPhase(intermediate.getMemoryStats(), EShMemoryPhaseBuiltIns);
+
     // Move to length-based strings, rather than null-terminated strings.
     // Also, add strings to include the preamble and to ensure the shader is not null,
     // which lets the grammar accept what was a null (post preprocessing) shader.
@@ -929,38 +1824,73 @@ bool ProcessDeferred(
             intermediate.addSourceText(strings[numPre + s], lengths[numPre + s]);
         }
     }
-    if (!SetupBuiltinSymbolTable(version, profile, spvVersion, source)) {
-        return false;
-    }
-
-    TSymbolTable* cachedTable = SharedSymbolTables[MapVersionToIndex(version)]
-                                                  [MapSpvVersionToIndex(spvVersion)]
-                                                  [MapProfileToIndex(profile)]
-                                                  [MapSourceToIndex(source)]
-                                                  [stage];
-
     // Dynamically allocate the symbol table so we can control when it is deallocated WRT the pool.
     std::unique_ptr<TSymbolTable> symbolTable(new TSymbolTable);
-    if (cachedTable)
-        symbolTable->adoptLevels(*cachedTable);
+    std::unique_ptr<TLazyBuiltInFunctions> lazyFunctions;
+
+    // Scanning for dependencies needs none of the built-in symbols.
+    if (ProcessingContext::builtIns) {
+        // The tree may point into the built-in tables, so they are held for as long as it is.
+        TBuiltInSlotHold* builtInHold = AcquireBuiltinSymbolTable(version, profile, spvVersion, source);
+        if (builtInHold == nullptr)
+            return false;
+        intermediate.addHold(builtInHold);
+
+        TSymbolTable* cachedTable = SharedSymbolTables[MapVersionToIndex(version)]
+                                                      [MapSpvVersionToIndex(spvVersion)]
+                                                      [MapProfileToIndex(profile)]
+                                                      [MapSourceToIndex(source)]
+                                                      [stage];
+        const TBuiltInFunctionIndex* functionIndex = BuiltInFunctionIndex[MapVersionToIndex(version)]
+                                                                         [MapSpvVersionToIndex(spvVersion)]
+                                                                         [MapProfileToIndex(profile)]
+                                                                         [MapSourceToIndex(source)];
+
+        if (cachedTable) {
+            // Built-in symbols that are potentially context dependent, shared with other
+            // compiles in the same context
+            TSymbolTable* contextTable = ContextSymbolTables[MapVersionToIndex(version)]
+                                                            [MapSpvVersionToIndex(spvVersion)]
+                                                            [MapProfileToIndex(profile)]
+                                                            [MapSourceToIndex(source)]->
+                find(*resources, compiler->infoSink, version, profile, spvVersion, stage, source, *cachedTable);
+            if (contextTable == nullptr)
+                return false;
 
-    if (intermediate.getUniqueId() != 0)
-        symbolTable->overwriteUniqueId(intermediate.getUniqueId());
+            // The compile edits context-dependent variables in place (e.g., implicit array
+            // sizes of gl_in), and lazy built-in functions get added to their level, so
+            // that level is shared rather than adopted: only what changes gets copied.
+            symbolTable->adoptLevelsSharingTop(*contextTable);
+            if (intermediate.getUniqueId() != 0)
+                symbolTable->overwriteUniqueId(intermediate.getUniqueId());
+        } else {
+            if (intermediate.getUniqueId() != 0)
+                symbolTable->overwriteUniqueId(intermediate.getUniqueId());
 
-    // Add built-in symbols that are potentially context dependent;
-    // they get popped again further down.
-    if (! AddContextSpecificSymbols(resources, compiler->infoSink, *symbolTable, version, profile, spvVersion,
-                                    stage, source)) {
-        return false;
-    }
+            // Add built-in symbols that are potentially context dependent;
+            // they get popped again further down.
+            if (! AddContextSpecificSymbols(resources, compiler->infoSink, *symbolTable, version, profile, spvVersion,
+                                            stage, source)) {
+                return false;
+            }
+        }
+
+        // Built-in functions left out of the shared tables go into the context-specific level, when used.
+        if (functionIndex != nullptr && cachedTable != nullptr) {
+            lazyFunctions.reset(new TLazyBuiltInFunctions(*functionIndex, version, profile, spvVersion, stage, source));
+            symbolTable->setBuiltInFunctionSource(lazyFunctions.get());
+        }
 
-    if (messages & EShMsgBuiltinSymbolTable)
-        DumpBuiltinSymbolTable(compiler->infoSink, *symbolTable);
+        if (messages & EShMsgBuiltinSymbolTable)
+            DumpBuiltinSymbolTable(compiler->infoSink, *symbolTable);
+    }
 
     //
     // Now we can process the full shader under proper symbols and rules.
     //
 
+    memoryPhase.switchTo(ProcessingContext::memoryPhase);
+
     std::unique_ptr<TParseContextBase> parseContext(CreateParseContext(*symbolTable, intermediate, version, profile, source,
                                                     stage, compiler->infoSink,
                                                     spvVersion, forwardCompatible, messages, false, sourceEntryPointName));
@@ -1005,6 +1935,10 @@ bool ProcessDeferred(
     // Push a new symbol allocation scope that will get used for the shader's globals.
     symbolTable->push();
 
+    // Let nodes of the same type share it.
+    TNodeTypes nodeTypes;
+    TNodeTypeScope nodeTypeScope(nodeTypes);
+
     bool success = processingContext(*parseContext, ppContext, fullInput,
                                      versionWillBeError, *symbolTable,
                                      intermediate, optLevel, messages);
@@ -1078,11 +2012,18 @@ private:
 
 // DoPreprocessing is a valid ProcessingContext template argument,
 // which only performs the preprocessing step of compilation.
-// It places the result in the "string" argument to its constructor.
+// It places the result in the "string" argument to its constructor,
+// or hands it to the "sink" argument in pieces of about flushSize
+// as it is produced.
 //
 // This is not an officially supported or fully working path.
 struct DoPreprocessing {
+    static const EShMemoryPhase memoryPhase = EShMemoryPhasePreprocess;
+    static const bool builtIns = true;
+    static const size_t flushSize = 64 * 1024;
+
     explicit DoPreprocessing(std::string* string): outputString(string) {}
+    explicit DoPreprocessing(const TShader::PreprocessSink& sink): outputString(nullptr), outputSink(sink) {}
     bool operator()(TParseContextBase& parseContext, TPpContext& ppContext,
                     TInputScanner& input, bool versionWillBeError,
                     TSymbolTable&, TIntermediate&,
@@ -1096,7 +2037,15 @@ struct DoPreprocessing {
         parseContext.setScanner(&input);
         ppContext.setInput(input, versionWillBeError);
 
-        std::string outputBuffer;
+        // Without a sink, all of the output collects in the string.
+        std::string sinkBuffer;
+        std::string& outputBuffer = outputString != nullptr ? *outputString : sinkBuffer;
+        outputBuffer.clear();
+        const auto flush = [&outputBuffer, this]() {
+            outputSink(outputBuffer.data(), outputBuffer.size());
+            outputBuffer.clear();
+        };
+
         SourceLineSynchronizer lineSync(
             std::bind(&TInputScanner::getLastValidSourceIndex, &input), &outputBuffer);
 
@@ -1165,6 +2114,9 @@ struct DoPreprocessing {
         int lastToken = EndOfInput; // lastToken records the last token processed.
         std::string lastTokenName;
         do {
+            if (outputSink && outputBuffer.size() >= flushSize)
+                flush();
+
             int token = ppContext.tokenize(ppToken);
             if (token == EndOfInput)
                 break;
@@ -1207,7 +2159,8 @@ struct DoPreprocessing {
                 outputBuffer += "\"";
         } while (true);
         outputBuffer += '\n';
-        *outputString = std::move(outputBuffer);
+        if (outputSink)
+            flush();
 
         bool success = true;
         if (parseContext.getNumErrors() > 0) {
@@ -1218,11 +2171,17 @@ struct DoPreprocessing {
         return success;
     }
     std::string* outputString;
+    TShader::PreprocessSink outputSink;
 };
 
 // DoFullParse is a valid ProcessingConext template argument for fully
 // parsing the shader.  It populates the "intermediate" with the AST.
 struct DoFullParse{
+  static const EShMemoryPhase memoryPhase = EShMemoryPhaseParse;
+  static const bool builtIns = true;
+
+  // 'texts' keeps the tokens scanned, for other compiles of the same strings
+  explicit DoFullParse(TPpContext::TokenizedTexts* texts = nullptr) : tokenizedTexts(texts) {}
   bool operator()(TParseContextBase& parseContext, TPpContext& ppContext,
                   TInputScanner& fullInput, bool versionWillBeError,
                   TSymbolTable&, TIntermediate& intermediate,
@@ -1230,14 +2189,23 @@ struct DoFullParse{
     {
         bool success = true;
         // Parse the full shader.
+        ppContext.setTokenizedTexts(tokenizedTexts);
         if (! parseContext.parseShaderStrings(ppContext, fullInput, versionWillBeError))
             success = false;
 
+        // Reducing the last tokens, and post-processing, allocate without reading tokens.
+        if (ppContext.checkMemoryLimit())
+            success = false;
         if (success && intermediate.getTreeRoot()) {
             if (optLevel == EShOptNoGeneration)
                 parseContext.infoSink.info.message(EPrefixNone, "No errors.  No code generation or linking was requested.");
             else
                 success = intermediate.postProcess(intermediate.getTreeRoot(), parseContext.getLanguage());
+            if (success && ppContext.checkMemoryLimit()) {
+                success = false;
+                parseContext.infoSink.info.prefix(EPrefixError);
+                parseContext.infoSink.info << parseContext.getNumErrors() << " compilation errors.  No code generated.\n\n";
+            }
         } else if (! success) {
             parseContext.infoSink.info.prefix(EPrefixError);
             parseContext.infoSink.info << parseContext.getNumErrors() << " compilation errors.  No code generated.\n\n";
@@ -1248,6 +2216,42 @@ struct DoFullParse{
 
         return success;
     }
+    TPpContext::TokenizedTexts* tokenizedTexts;
+};
+
+// DoDependencyScan is a valid ProcessingContext template argument, which only
+// runs the preprocessor directives, to find the headers the shader includes.
+// Other lines are skipped over without being tokenized or macro expanded.
+struct DoDependencyScan {
+    static const EShMemoryPhase memoryPhase = EShMemoryPhasePreprocess;
+    static const bool builtIns = false;
+
+    explicit DoDependencyScan(std::vector<std::string>* headers): includedHeaders(headers) {}
+    bool operator()(TParseContextBase& parseContext, TPpContext& ppContext,
+                    TInputScanner& input, bool versionWillBeError,
+                    TSymbolTable&, TIntermediate&,
+                    EShOptimizationLevel, EShMessages)
+    {
+        glslang::TPpToken ppToken;
+        std::vector<std::string> headers;
+
+        parseContext.setScanner(&input);
+        ppContext.setDependencyScan(&headers);
+        ppContext.setInput(input, versionWillBeError);
+        while (ppContext.tokenize(ppToken) != EndOfInput)
+            ;
+        if (includedHeaders != nullptr)
+            *includedHeaders = std::move(headers);
+
+        bool success = true;
+        if (parseContext.getNumErrors() > 0) {
+            success = false;
+            parseContext.infoSink.info.prefix(EPrefixError);
+            parseContext.infoSink.info << parseContext.getNumErrors() << " compilation errors.\n\n";
+        }
+        return success;
+    }
+    std::vector<std::string>* includedHeaders;
 };
 
 // Take a single compilation unit, and run the preprocessor on it.
@@ -1274,10 +2278,9 @@ bool PreprocessDeferred(
     EShMessages messages,       // warnings/errors/AST; things to print out
     TShader::Includer& includer,
     TIntermediate& intermediate, // returned tree, etc.
-    std::string* outputString,
+    DoPreprocessing& parser,
     TEnvironment* environment = nullptr)
 {
-    DoPreprocessing parser(outputString);
     return ProcessDeferred(compiler, shaderStrings, numStrings, inputLengths, stringNames,
                            preamble, optLevel, resources, defaultVersion,
                            defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
@@ -1285,6 +2288,35 @@ bool PreprocessDeferred(
                            false, includer, "", environment);
 }
 
+// Take a single compilation unit, and find the headers it includes, running only
+// the directives that decide which those are.
+bool ScanDependenciesDeferred(
+    TCompiler* compiler,
+    const char* const shaderStrings[],
+    const int numStrings,
+    const int* inputLengths,
+    const char* const stringNames[],
+    const char* preamble,
+    const TBuiltInResource* resources,
+    int defaultVersion,         // use 100 for ES environment, 110 for desktop
+    EProfile defaultProfile,
+    bool forceDefaultVersionAndProfile,
+    int overrideVersion,        // use 0 if not overriding GLSL version
+    bool forwardCompatible,     // give errors for use of deprecated features
+    EShMessages messages,       // warnings/errors/AST; things to print out
+    TShader::Includer& includer,
+    TIntermediate& intermediate, // returned version, profile, etc.
+    std::vector<std::string>* includedHeaders,
+    TEnvironment* environment = nullptr)
+{
+    DoDependencyScan scanner(includedHeaders);
+    return ProcessDeferred(compiler, shaderStrings, numStrings, inputLengths, stringNames,
+                           preamble, EShOptNone, resources, defaultVersion,
+                           defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
+                           forwardCompatible, messages, intermediate, scanner,
+                           false, includer, "", environment);
+}
+
 //
 // do a partial compile on the given strings for a single compilation unit
 // for a potential deferred link into a single stage (and deferred full compile of that
@@ -1337,9 +2369,6 @@ int ShInitialize()
 #endif
     ++NumberOfClients;
 
-    if (PerProcessGPA == nullptr)
-        PerProcessGPA = new TPoolAllocator();
-
     return 1;
 }
 
@@ -1401,33 +2430,13 @@ int ShFinalize()
         for (int spvVersion = 0; spvVersion < SpvVersionCount; ++spvVersion) {
             for (int p = 0; p < ProfileCount; ++p) {
                 for (int source = 0; source < SourceCount; ++source) {
-                    for (int stage = 0; stage < EShLangCount; ++stage) {
-                        delete SharedSymbolTables[version][spvVersion][p][source][stage];
-                        SharedSymbolTables[version][spvVersion][p][source][stage] = nullptr;
-                    }
+                    BuiltInsReady[version][spvVersion][p][source].store(false, std::memory_order_relaxed);
+                    FreeBuiltinSymbolTable(version, spvVersion, p, source);
                 }
             }
         }
     }
 
-    for (int version = 0; version < VersionCount; ++version) {
-        for (int spvVersion = 0; spvVersion < SpvVersionCount; ++spvVersion) {
-            for (int p = 0; p < ProfileCount; ++p) {
-                for (int source = 0; source < SourceCount; ++source) {
-                    for (int pc = 0; pc < EPcCount; ++pc) {
-                        delete CommonSymbolTable[version][spvVersion][p][source][pc];
-                        CommonSymbolTable[version][spvVersion][p][source][pc] = nullptr;
-                    }
-                }
-            }
-        }
-    }
-
-    if (PerProcessGPA != nullptr) {
-        delete PerProcessGPA;
-        PerProcessGPA = nullptr;
-    }
-
     return 1;
 }
 
@@ -1726,6 +2735,110 @@ void FinalizeProcess()
     ShFinalize();
 }
 
+bool SaveBuiltInSymbolTables(const TargetTuple& target, std::vector<unsigned char>& image)
+{
+    int version;
+    EProfile profile;
+    MapTargetTupleToVersionProfile(target, version, profile);
+
+    image.clear();
+    if (FindVersionIndex(version) < 0)
+        return false;
+    return SaveBuiltinSymbolTable(version, profile, MapTargetTupleToSpvVersion(target), target.source, image);
+}
+
+bool LoadBuiltInSymbolTables(const void* image, size_t size)
+{
+    return LoadBuiltinSymbolTable(static_cast<const unsigned char*>(image), size);
+}
+
+void SetLazyBuiltIns(bool lazy)
+{
+    LazyBuiltIns = lazy;
+}
+
+bool PrewarmBuiltins(const std::vector<TargetTuple>& targets, int threads)
+{
+    // Reject unknown versions before any work starts.
+    for (const TargetTuple& target : targets) {
+        int version;
+        EProfile profile;
+        MapTargetTupleToVersionProfile(target, version, profile);
+        if (FindVersionIndex(version) < 0)
+            return false;
+    }
+
+    // Each worker takes the next target not yet claimed, until there are none left.
+    // Targets sharing a slot just find it done, or wait for it under its own lock.
+    std::atomic<size_t> nextTarget(0);
+    std::atomic<bool> success(true);
+    const auto prewarm = [&]() {
+        for (size_t t = nextTarget++; t < targets.size(); t = nextTarget++) {
+            int version;
+            EProfile profile;
+            MapTargetTupleToVersionProfile(targets[t], version, profile);
+            if (! SetupBuiltinSymbolTable(version, profile, MapTargetTupleToSpvVersion(targets[t]), targets[t].source))
+                success = false;
+        }
+    };
+
+#ifndef DISABLE_THREAD_SUPPORT
+    std::vector<std::thread> workers;
+    for (int w = 1; w < threads && static_cast<size_t>(w) < targets.size(); ++w)
+        workers.emplace_back(prewarm);
+    prewarm();
+    for (std::thread& worker : workers)
+        worker.join();
+#else
+    (void)threads;
+    prewarm();
+#endif
+
+    // Over budget, prewarmed tables are kept over those used longest ago.
+    EvictBuiltinSymbolTables();
+
+    return success;
+}
+
+size_t GetBuiltInMemoryUsage()
+{
+    return BuiltInBytesTotal.load();
+}
+
+size_t GetBuiltInMemoryUsage(const TargetTuple& target)
+{
+    int version;
+    EProfile profile;
+    MapTargetTupleToVersionProfile(target, version, profile);
+    const int versionIndex = FindVersionIndex(version);
+    if (versionIndex < 0)
+        return 0;
+
+    return BuiltInBytes[versionIndex][MapSpvVersionToIndex(MapTargetTupleToSpvVersion(target))]
+                       [MapProfileToIndex(profile)][MapSourceToIndex(target.source)].load();
+}
+
+void SetBuiltInMemoryBudget(size_t bytes)
+{
+    BuiltInMemoryBudget = bytes;
+    EvictBuiltinSymbolTables();
+}
+
+void SetPoolPageCacheLimit(size_t bytes)
+{
+    TPoolAllocator::setPageCacheLimit(bytes);
+}
+
+void SetIncludeTokenCacheLimit(size_t bytes)
+{
+    TPpContext::TokenizedHeader::setLimit(bytes);
+}
+
+void SetPageAllocator(TPageAllocator* allocator)
+{
+    TPoolAllocator::setPageAllocator(allocator);
+}
+
 class TDeferredCompiler : public TCompiler {
 public:
     TDeferredCompiler(EShLanguage s, TInfoSink& i) : TCompiler(s, i) { }
@@ -1743,6 +2856,7 @@ TShader::TShader(EShLanguage s)
     infoSink = new TInfoSink;
     compiler = new TDeferredCompiler(stage, *infoSink);
     intermediate = new TIntermediate(s);
+    intermediate->setMemoryStats(new TMemoryStats());
 
     // clear environment (avoid constructors in them for use in a C interface)
     environment.input.languageFamily = EShSourceNone;
@@ -1757,6 +2871,7 @@ TShader::~TShader()
 {
     delete infoSink;
     delete compiler;
+    delete intermediate->getMemoryStats();
     delete intermediate;
     delete pool;
 }
@@ -1816,6 +2931,7 @@ void TShader::setInvertY(bool invert)                   { intermediate->setInver
 void TShader::setDxPositionW(bool invert)               { intermediate->setDxPositionW(invert); }
 void TShader::setEnhancedMsgs()                         { intermediate->setEnhancedMsgs(); }
 void TShader::setNanMinMaxClamp(bool useNonNan)         { intermediate->setNanMinMaxClamp(useNonNan); }
+void TShader::setMemoryLimit(size_t bytes)              { pool->setLimit(bytes); }
 
 // Set binding base for given resource type
 void TShader::setShiftBinding(TResourceType res, unsigned int base) {
@@ -1914,13 +3030,132 @@ bool TShader::preprocess(const TBuiltInResource* builtInResources,
     if (! preamble)
         preamble = "";
 
+    DoPreprocessing parser(output_string);
     return PreprocessDeferred(compiler, strings, numStrings, lengths, stringNames, preamble,
                               EShOptNone, builtInResources, defaultVersion,
                               defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
-                              forwardCompatible, message, includer, *intermediate, output_string,
+                              forwardCompatible, message, includer, *intermediate, parser,
                               &environment);
 }
 
+// As above, but rather than building a string, hands the output to 'sink' in pieces,
+// as it is produced.  Only a bounded amount is held back between calls.
+bool TShader::preprocessToSink(const TBuiltInResource* builtInResources,
+                               int defaultVersion, EProfile defaultProfile,
+                               bool forceDefaultVersionAndProfile,
+                               bool forwardCompatible, EShMessages message,
+                               const PreprocessSink& sink,
+                               Includer& includer)
+{
+    SetThreadPoolAllocator(pool);
+
+    if (! preamble)
+        preamble = "";
+
+    DoPreprocessing parser(sink);
+    return PreprocessDeferred(compiler, strings, numStrings, lengths, stringNames, preamble,
+                              EShOptNone, builtInResources, defaultVersion,
+                              defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
+                              forwardCompatible, message, includer, *intermediate, parser,
+                              &environment);
+}
+
+// As above, writing the output to 'output' as it is produced.
+bool TShader::preprocess(const TBuiltInResource* builtInResources,
+                         int defaultVersion, EProfile defaultProfile,
+                         bool forceDefaultVersionAndProfile,
+                         bool forwardCompatible, EShMessages message,
+                         std::ostream& output,
+                         Includer& includer)
+{
+    const auto write = [&output](const char* text, size_t length) {
+        output.write(text, static_cast<std::streamsize>(length));
+    };
+    return preprocessToSink(builtInResources, defaultVersion, defaultProfile, forceDefaultVersionAndProfile,
+                            forwardCompatible, message, write, includer);
+}
+
+// Fill in a list with the names of the headers ShaderStrings include, as the includer
+// resolved them, each once and in the order first included.  Only the preprocessor
+// directives are run; other lines are skipped over.
+// Returns true if no errors were found in the directives run.
+bool TShader::scanDependencies(const TBuiltInResource* builtInResources,
+                               int defaultVersion, EProfile defaultProfile,
+                               bool forceDefaultVersionAndProfile,
+                               bool forwardCompatible, EShMessages message,
+                               std::vector<std::string>* includedHeaders,
+                               Includer& includer)
+{
+    SetThreadPoolAllocator(pool);
+
+    if (! preamble)
+        preamble = "";
+
+    return ScanDependenciesDeferred(compiler, strings, numStrings, lengths, stringNames, preamble,
+                                    builtInResources, defaultVersion,
+                                    defaultProfile, forceDefaultVersionAndProfile, overrideVersion,
+                                    forwardCompatible, message, includer, *intermediate, includedHeaders,
+                                    &environment);
+}
+
+// Parse the strings of this shader into each of 'permutations', with the matching one
+// of 'preambles' in place of this shader's preamble, and otherwise as each of them is
+// set up.  The permutations share the tokens scanned from the strings and the headers
+// they include: the first to reach a text keeps its tokens (up to 64MB of them, all
+// freed on return), and the rest replay them.  Returns true if every permutation parsed,
+// and false without parsing any if they don't all match this shader.
+bool TShader::parsePermutations(const TBuiltInResource* builtInResources,
+                                int defaultVersion, EProfile defaultProfile,
+                                bool forceDefaultVersionAndProfile,
+                                bool forwardCompatible, EShMessages messages,
+                                const std::vector<std::string>& preambles,
+                                const std::vector<TShader*>& permutations,
+                                Includer& includer)
+{
+    if (preambles.size() != permutations.size())
+        return false;
+    for (const TShader* permutation : permutations) {
+        if (permutation == nullptr || permutation->stage != stage)
+            return false;
+    }
+
+    TPpContext::TokenizedTexts tokenizedTexts(64 * 1024 * 1024);
+    bool success = true;
+    for (size_t p = 0; p < permutations.size(); ++p) {
+        TShader& permutation = *permutations[p];
+
+        // nothing after the last permutation would replay what it keeps
+        if (p + 1 == permutations.size())
+            tokenizedTexts.stopKeeping();
+
+        SetThreadPoolAllocator(permutation.pool);
+
+        DoFullParse parser(&tokenizedTexts);
+        if (! ProcessDeferred(permutation.compiler, strings, numStrings, lengths, stringNames,
+                              preambles[p].c_str(), EShOptNone, builtInResources, defaultVersion,
+                              defaultProfile, forceDefaultVersionAndProfile, permutation.overrideVersion,
+                              forwardCompatible, messages, *permutation.intermediate, parser,
+                              true, includer, permutation.sourceEntryPointName, &permutation.environment,
+                              permutation.compileOnly))
+            success = false;
+    }
+
+    return success;
+}
+
+const TMemoryStats& TShader::getMemoryStats() const
+{
+    return *intermediate->getMemoryStats();
+}
+
+TTreeStats TShader::getTreeStats() const
+{
+    TTreeStats stats = {};
+    intermediate->getTreeStats(stats);
+
+    return stats;
+}
+
 const char* TShader::getInfoLog()
 {
     return infoSink->info.c_str();
@@ -1931,10 +3166,28 @@ const char* TShader::getInfoDebugLog()
     return infoSink->debug.c_str();
 }
 
+namespace {
+
+// A program's info sink, which also holds the program's memory statistics, to
+// keep them out of TProgram's layout.
+class TProgramInfoSink : public TInfoSink {
+public:
+    TProgramInfoSink() : memoryStats() { }
+
+    TMemoryStats memoryStats;
+};
+
+TMemoryStats& ProgramMemoryStats(TInfoSink* infoSink)
+{
+    return static_cast<TProgramInfoSink*>(infoSink)->memoryStats;
+}
+
+} // end anonymous namespace
+
 TProgram::TProgram() : reflection(nullptr), linked(false)
 {
     pool = new TPoolAllocator;
-    infoSink = new TInfoSink;
+    infoSink = new TProgramInfoSink;
     for (int s = 0; s < EShLangCount; ++s) {
         intermediate[s] = nullptr;
         newedIntermediate[s] = false;
@@ -1943,7 +3196,7 @@ TProgram::TProgram() : reflection(nullptr), linked(false)
 
 TProgram::~TProgram()
 {
-    delete infoSink;
+    delete static_cast<TProgramInfoSink*>(infoSink);
     delete reflection;
 
     for (int s = 0; s < EShLangCount; ++s)
@@ -1968,6 +3221,7 @@ bool TProgram::link(EShMessages messages)
     bool error = false;
 
     SetThreadPoolAllocator(pool);
+    TMemoryPhaseMarker memoryPhase(&ProgramMemoryStats(infoSink), EShMemoryPhaseLink);
 
     for (int s = 0; s < EShLangCount; ++s) {
         if (! linkStage((EShLanguage)s, messages))
@@ -2030,6 +3284,7 @@ bool TProgram::linkStage(EShLanguage stage, EShMessages messages)
             intermediate[stage]->setOriginUpperLeft();
         }
         intermediate[stage]->setSpv(firstIntermediate->getSpv());
+        intermediate[stage]->setMemoryStats(&ProgramMemoryStats(infoSink));
 
         newedIntermediate[stage] = true;
     }
@@ -2130,6 +3385,11 @@ const char* TProgram::getInfoDebugLog()
     return infoSink->debug.c_str();
 }
 
+const TMemoryStats& TProgram::getMemoryStats() const
+{
+    return ProgramMemoryStats(infoSink);
+}
+
 //
 // Reflection implementation.
 //
@@ -2206,6 +3466,7 @@ bool TProgram::mapIO(TIoMapResolver* pResolver, TIoMapper* pIoMapper)
         return false;
 
     SetThreadPoolAllocator(pool);
+    TMemoryPhaseMarker memoryPhase(&ProgramMemoryStats(infoSink), EShMemoryPhaseMapIO);
 
     TIoMapper* ioMapper = nullptr;
     TIoMapper defaultIOMapper;
@@ -277,8 +277,14 @@ TSymbolTableLevel::~TSymbolTableLevel()
         const TString& name = it->first;
         auto retargetIter = std::find_if(retargetedSymbols.begin(), retargetedSymbols.end(),
                                       [&name](const std::pair<TString, TString>& i) { return i.first == name; });
-        if (retargetIter == retargetedSymbols.end())
-            delete (*it).second;
+        if (retargetIter != retargetedSymbols.end())
+            continue;
+        if (sharedFrom != nullptr) {
+            const auto shared = sharedFrom->level.find(name);
+            if (shared != sharedFrom->level.end() && shared->second == it->second)
+                continue;
+        }
+        delete (*it).second;
     }
 
 
@@ -340,6 +346,47 @@ void TSymbolTableLevel::readOnly()
         (*it).second->makeReadOnly();
 }
 
+//
+// Index this level, which must be the top of 'table', together with all the levels
+// beneath it, for findFrozen() and findFrozenFunctionNameList().  None of them may
+// change afterward.
+//
+void TSymbolTableLevel::freeze(const std::vector<TSymbolTableLevel*>& table)
+{
+    assert(table.back() == this);
+
+    size_t count = 0;
+    for (const TSymbolTableLevel* scope : table)
+        count += scope->level.size();
+    size_t size = 1;
+    while (size < 2 * count)
+        size <<= 1;
+    const size_t mask = size - 1;
+
+    frozen.assign(size, tFrozenSlot{ 0, nullptr, nullptr, 0 });
+    for (int l = static_cast<int>(table.size()) - 1; l >= 0; --l) {
+        for (tLevel::const_iterator it = table[l]->level.begin(); it != table[l]->level.end(); ++it) {
+            const size_t hash = std::hash<TString>()(it->first);
+            size_t slot = hash & mask;
+            while (frozen[slot].name != nullptr && ! (frozen[slot].hash == hash && *frozen[slot].name == it->first))
+                slot = (slot + 1) & mask;
+            if (frozen[slot].name == nullptr)
+                frozen[slot] = tFrozenSlot{ hash, &it->first, it->second, l };
+
+            const size_t parenAt = it->first.find_first_of('(');
+            if (parenAt != TString::npos)
+                frozenFunctions[TString(it->first, 0, parenAt + 1)].push_back(it->second->getAsFunction());
+        }
+    }
+
+    for (auto& overloads : frozenFunctions) {
+        std::stable_sort(overloads.second.begin(), overloads.second.end(),
+                         [](const TFunction* left, const TFunction* right) {
+                             return left->getParamCount() < right->getParamCount();
+                         });
+    }
+}
+
 //
 // Copy a symbol, but the copy is writable; call readOnly() afterward if that's not desired.
 //
@@ -466,6 +513,54 @@ TSymbolTableLevel* TSymbolTableLevel::clone() const
     return symTableLevel;
 }
 
+//
+// A new level holding the same symbols as this one, which must be read-only, so that
+// symbols can be added to it without copying all of them, as clone() would.  The
+// symbols are still this level's, and it must outlive the new one.
+//
+TSymbolTableLevel* TSymbolTableLevel::share() const
+{
+    TSymbolTableLevel* symTableLevel = new TSymbolTableLevel();
+    symTableLevel->level = level;
+    symTableLevel->retargetedSymbols = retargetedSymbols;
+    symTableLevel->anonId = anonId;
+    symTableLevel->thisLevel = thisLevel;
+    symTableLevel->sharedFrom = this;
+
+    return symTableLevel;
+}
+
+//
+// Replace 'symbol', a variable or anonymous member still shared by share(), with a
+// writable copy, under every name it has here.  An anonymous member takes its whole
+// container, and so all the other members, with it.  Returns the copy.
+//
+TSymbol* TSymbolTableLevel::unshare(TSymbol& symbol)
+{
+    const TAnonMember* anon = symbol.getAsAnonMember();
+    TVariable* container = anon != nullptr ? anon->getAnonContainer().clone() : nullptr;
+    TSymbol* copy = anon != nullptr ? nullptr : symbol.clone();
+
+    for (tLevel::iterator it = level.begin(); it != level.end(); ++it) {
+        if (anon == nullptr) {
+            if (it->second == &symbol)
+                it->second = copy;
+            continue;
+        }
+        const TAnonMember* member = it->second->getAsAnonMember();
+        if (member == nullptr || &member->getAnonContainer() != &anon->getAnonContainer())
+            continue;
+        TAnonMember* memberCopy = new TAnonMember(&member->getName(), member->getMemberNumber(), *container,
+                                                  member->getAnonId());
+        memberCopy->setUniqueId(member->getUniqueId());
+        if (member == anon)
+            copy = memberCopy;
+        it->second = memberCopy;
+    }
+
+    return copy;
+}
+
 void TSymbolTable::copyTable(const TSymbolTable& copyOf)
 {
     assert(adoptedLevels == copyOf.adoptedLevels);
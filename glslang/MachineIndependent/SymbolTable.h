@@ -201,6 +201,10 @@ public:
     virtual void dump(TInfoSink& infoSink, bool complete = false) const;
 
 protected:
+    // Built-in symbol table images are written and read member by member.
+    friend class TSymbolTableWriter;
+    friend class TSymbolTableReader;
+
     explicit TVariable(const TVariable&);
     TVariable& operator=(const TVariable&);
 
@@ -335,6 +339,9 @@ public:
     TLinkType getLinkType() const { return linkType; }
 
 protected:
+    friend class TSymbolTableWriter;
+    friend class TSymbolTableReader;
+
     explicit TFunction(const TFunction&);
     TFunction& operator=(const TFunction&);
 
@@ -409,7 +416,7 @@ protected:
 class TSymbolTableLevel {
 public:
     POOL_ALLOCATOR_NEW_DELETE(GetThreadPoolAllocator())
-    TSymbolTableLevel() : defaultPrecision(nullptr), anonId(0), thisLevel(false) { }
+    TSymbolTableLevel() : defaultPrecision(nullptr), anonId(0), thisLevel(false), sharedFrom(nullptr) { }
     ~TSymbolTableLevel();
 
     bool insert(const TString& name, TSymbol* symbol) {
@@ -496,7 +503,25 @@ public:
             return (*it).second;
     }
 
-    void findFunctionNameList(const TString& name, TVector<const TFunction*>& list)
+    // After freeze(), find 'name' in this level or any level beneath it, with a
+    // single hash probe.  'foundLevel' is set to the level the symbol came from.
+    bool isFrozen() const { return ! frozen.empty(); }
+    TSymbol* findFrozen(const TString& name, int& foundLevel) const
+    {
+        const size_t hash = std::hash<TString>()(name);
+        const size_t mask = frozen.size() - 1;
+        for (size_t slot = hash & mask; frozen[slot].name != nullptr; slot = (slot + 1) & mask) {
+            if (frozen[slot].hash == hash && *frozen[slot].name == name) {
+                foundLevel = frozen[slot].level;
+                return frozen[slot].symbol;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // If 'argCount' isn't negative, only functions that can take that many arguments are listed.
+    void findFunctionNameList(const TString& name, TVector<const TFunction*>& list, int argCount = -1)
     {
         size_t parenAt = name.find_first_of('(');
         TString base(name, 0, parenAt + 1);
@@ -504,8 +529,33 @@ public:
         tLevel::const_iterator begin = level.lower_bound(base);
         base[parenAt] = ')';  // assume ')' is lexically after '('
         tLevel::const_iterator end = level.upper_bound(base);
-        for (tLevel::const_iterator it = begin; it != end; ++it)
-            list.push_back(it->second->getAsFunction());
+        for (tLevel::const_iterator it = begin; it != end; ++it) {
+            const TFunction* function = it->second->getAsFunction();
+            if (takesArgCount(*function, argCount))
+                list.push_back(function);
+        }
+    }
+
+    // After freeze(), as findFunctionNameList(), but for this level and all those beneath it,
+    // through the overload index rather than a range scan.
+    void findFrozenFunctionNameList(const TString& name, TVector<const TFunction*>& list, int argCount) const
+    {
+        size_t parenAt = name.find_first_of('(');
+        const auto it = frozenFunctions.find(TString(name, 0, parenAt + 1));
+        if (it == frozenFunctions.end())
+            return;
+
+        // overloads are ordered by parameter count, so skip those taking too few
+        const TVector<const TFunction*>& overloads = it->second;
+        auto overload = overloads.begin();
+        if (argCount >= 0) {
+            overload = std::lower_bound(overloads.begin(), overloads.end(), argCount,
+                                        [](const TFunction* function, int count) { return function->getParamCount() < count; });
+        }
+        for (; overload != overloads.end(); ++overload) {
+            if (takesArgCount(**overload, argCount))
+                list.push_back(*overload);
+        }
     }
 
     // See if there is already a function in the table having the given non-function-style name.
@@ -583,12 +633,28 @@ public:
     void setSingleFunctionExtensions(const char* name, int num, const char* const extensions[]);
     void dump(TInfoSink& infoSink, bool complete = false) const;
     TSymbolTableLevel* clone() const;
+    TSymbolTableLevel* share() const;
+    bool isShared() const { return sharedFrom != nullptr; }
+    TSymbol* unshare(TSymbol& symbol);
     void readOnly();
+    void freeze(const std::vector<TSymbolTableLevel*>& table);
+
+    // Move all entries to 'to', leaving this level empty.  Entries whose key 'to' already
+    // has are dropped (not deleted; they live in the pool).
+    void transferSymbols(TSymbolTableLevel& to)
+    {
+        for (tLevel::const_iterator it = level.begin(); it != level.end(); ++it)
+            to.level.insert(*it);
+        level.clear();
+    }
 
     void setThisLevel() { thisLevel = true; }
     bool isThisLevel() const { return thisLevel; }
 
 protected:
+    friend class TSymbolTableWriter;
+    friend class TSymbolTableReader;
+
     explicit TSymbolTableLevel(TSymbolTableLevel&);
     TSymbolTableLevel& operator=(TSymbolTableLevel&);
 
@@ -596,18 +662,54 @@ protected:
     typedef const tLevel::value_type tLevelPair;
     typedef std::pair<tLevel::iterator, bool> tInsertResult;
 
+    // Open-addressed index of this level and those beneath it, built by freeze()
+    // once they are all read-only; inner levels hide outer ones, as in find().
+    struct tFrozenSlot {
+        size_t hash;
+        const TString* name;
+        TSymbol* symbol;
+        int level;
+    };
+
+    static bool takesArgCount(const TFunction& function, int argCount)
+    {
+        return argCount < 0 || (argCount >= function.getFixedParamCount() && argCount <= function.getParamCount());
+    }
+
     tLevel level;  // named mappings
+    TVector<tFrozenSlot> frozen;
+    // Also built by freeze(): the overloads of each function in this level and those beneath
+    // it, keyed by name up to the '('.  Stably sorted by parameter count, so each arity is one
+    // bucket, still in level and then mangled-name order.
+    TUnorderedMap<TString, TVector<const TFunction*>> frozenFunctions;
     TPrecisionQualifier *defaultPrecision;
     // pair<FromName, ToName>
     TVector<std::pair<TString, TString>> retargetedSymbols;
     int anonId;
     bool thisLevel;  // True if this level of the symbol table is a structure scope containing member function
                      // that are supposed to see anonymous access to member variables.
+    const TSymbolTableLevel* sharedFrom;  // set by share(); the symbols found there are its to delete
+};
+
+class TSymbolTable;
+
+//
+// Supplies built-in function prototypes that were left out of the shared built-in
+// levels, so that only those a shader actually looks up get built.
+//
+class TBuiltInFunctionSource {
+public:
+    virtual ~TBuiltInFunctionSource() { }
+
+    // If not done already, add all the built-in overloads of the function 'name'
+    // (not mangled) to 'symbolTable', through insertBuiltInFunctions().
+    virtual void materialize(const char* name, size_t length, TSymbolTable& symbolTable) = 0;
 };
 
 class TSymbolTable {
 public:
-    TSymbolTable() : uniqueId(0), noBuiltInRedeclarations(false), separateNameSpaces(false), adoptedLevels(0)
+    TSymbolTable() : uniqueId(0), noBuiltInRedeclarations(false), separateNameSpaces(false), adoptedLevels(0),
+                     builtInFunctionSource(nullptr), builtInFunctionLevel(0)
     {
         //
         // This symbol table cannot be used until push() is called.
@@ -633,6 +735,20 @@ public:
         separateNameSpaces = symTable.separateNameSpaces;
     }
 
+    // As adoptLevels(), except that the top level is shared (see TSymbolTableLevel::share()),
+    // so that it can be added to.
+    void adoptLevelsSharingTop(TSymbolTable& symTable)
+    {
+        for (unsigned int level = 0; level + 1 < symTable.table.size(); ++level) {
+            table.push_back(symTable.table[level]);
+            ++adoptedLevels;
+        }
+        table.push_back(symTable.table.back()->share());
+        uniqueId = symTable.uniqueId;
+        noBuiltInRedeclarations = symTable.noBuiltInRedeclarations;
+        separateNameSpaces = symTable.separateNameSpaces;
+    }
+
     //
     // While level adopting is generic, the methods below enact a the following
     // convention for levels:
@@ -710,9 +826,18 @@ public:
                     return false;
                 if (currentLevel() > 1 && table[1]->hasFunctionName(symbol.getName()))
                     return false;
+                if (builtInFunctionSource != nullptr && currentLevel() > builtInFunctionLevel) {
+                    materializeBuiltInFunctions(symbol.getName());
+                    if (table[builtInFunctionLevel]->hasFunctionName(symbol.getName()))
+                        return false;
+                }
             }
         }
 
+        // a user function may hide built-in overloads that were selected before
+        if (symbol.getAsFunction() != nullptr && ! atBuiltInLevel())
+            forgetSelectedOverloads();
+
         return table[currentLevel()]->insert(symbol, separateNameSpaces);
     }
 
@@ -782,16 +907,12 @@ public:
     // at a built-in level or the current top-scope level.
     TSymbol* find(const TString& name, bool* builtIn = nullptr, bool* currentScope = nullptr, int* thisDepthP = nullptr)
     {
+        if (builtInFunctionSource != nullptr && name.find_first_of('(') != TString::npos)
+            materializeBuiltInFunctions(name);
+
         int level = currentLevel();
-        TSymbol* symbol;
-        int thisDepth = 0;
-        do {
-            if (table[level]->isThisLevel())
-                ++thisDepth;
-            symbol = table[level]->find(name);
-            --level;
-        } while (symbol == nullptr && level >= 0);
-        level++;
+        int thisDepth;
+        TSymbol* symbol = findDownFrom(name, level, thisDepth);
         if (builtIn)
             *builtIn = isBuiltInLevel(level);
         if (currentScope)
@@ -817,16 +938,9 @@ public:
     TSymbol* find(const TString& name, int& thisDepth)
     {
         int level = currentLevel();
-        TSymbol* symbol;
-        thisDepth = 0;
-        do {
-            if (table[level]->isThisLevel())
-                ++thisDepth;
-            symbol = table[level]->find(name);
-            --level;
-        } while (symbol == nullptr && level >= 0);
+        TSymbol* symbol = findDownFrom(name, level, thisDepth);
 
-        if (! table[level + 1]->isThisLevel())
+        if (! table[level]->isThisLevel())
             thisDepth = 0;
 
         return symbol;
@@ -849,8 +963,13 @@ public:
         return false;
     }
 
-    void findFunctionNameList(const TString& name, TVector<const TFunction*>& list, bool& builtIn)
+    // Built-in functions that can't take 'argCount' arguments are left out, unless it is negative.
+    // User functions are never left out, as any of them hides all the built-in ones.
+    void findFunctionNameList(const TString& name, TVector<const TFunction*>& list, bool& builtIn, int argCount = -1)
     {
+        if (builtInFunctionSource != nullptr)
+            materializeBuiltInFunctions(name);
+
         // For user levels, return the set found in the first scope with a match
         builtIn = false;
         int level = currentLevel();
@@ -862,14 +981,32 @@ public:
         if (! list.empty())
             return;
 
-        // Gather across all built-in levels; they don't hide each other
+        // Gather across all built-in levels; they don't hide each other.  A frozen
+        // level's index covers the levels beneath it too.
         builtIn = true;
         do {
-            table[level]->findFunctionNameList(name, list);
+            if (table[level]->isFrozen()) {
+                table[level]->findFrozenFunctionNameList(name, list, argCount);
+                return;
+            }
+            table[level]->findFunctionNameList(name, list, argCount);
             --level;
         } while (level >= 0);
     }
 
+    // Built-in overloads already selected for calls, by mangled call name, so a parse
+    // context need not select again for another call with the same argument types.
+    // The parse context must forget them when its conversion rules change.  They belong
+    // to this compile's table rather than to the shared built-in levels it adopts, so
+    // those levels stay read-only while compiles run.
+    const TFunction* findSelectedOverload(const TString& callName) const
+    {
+        const auto it = selectedOverloads.find(callName);
+        return it == selectedOverloads.end() ? nullptr : it->second;
+    }
+    void rememberSelectedOverload(const TString& callName, const TFunction* function) { selectedOverloads[callName] = function; }
+    void forgetSelectedOverloads() { selectedOverloads.clear(); }
+
     void relateToOperator(const char* name, TOperator op)
     {
         for (unsigned int level = 0; level < table.size(); ++level)
@@ -920,10 +1057,14 @@ public:
 
     void setPreviousDefaultPrecisions(TPrecisionQualifier *p) { table[currentLevel()]->setPreviousDefaultPrecisions(p); }
 
+    // Adopted levels are left alone; they are the business of the table they came from.
+    // They are already read-only, though, so the top level can index all of them.
     void readOnly()
     {
-        for (unsigned int level = 0; level < table.size(); ++level)
+        for (unsigned int level = adoptedLevels; level < table.size(); ++level)
             table[level]->readOnly();
+        if (table.size() > adoptedLevels)
+            table.back()->freeze(table);
     }
 
     // Add current level in the high-bits of unique id
@@ -940,16 +1081,80 @@ public:
         updateUniqueIdLevelFlag();
     }
 
+    //
+    // Lazy built-in functions: the built-in levels don't hold the built-in function
+    // prototypes up front; 'source' adds the overloads of a name to the current level
+    // (the last built-in one) the first time that name is looked up.
+    //
+    void setBuiltInFunctionSource(TBuiltInFunctionSource* source)
+    {
+        builtInFunctionSource = source;
+        builtInFunctionLevel = currentLevel();
+    }
+
+    // For a TBuiltInFunctionSource: move everything in the levels of 'builtIns', which
+    // were built from this table's unique id, into the built-in function level.
+    void insertBuiltInFunctions(TSymbolTable& builtIns)
+    {
+        for (int level = builtIns.currentLevel(); level >= 0; --level)
+            builtIns.table[level]->transferSymbols(*table[builtInFunctionLevel]);
+        overwriteUniqueId(builtIns.uniqueId);
+    }
+
 protected:
+    friend class TSymbolTableWriter;
+    friend class TSymbolTableReader;
+
     TSymbolTable(TSymbolTable&);
     TSymbolTable& operator=(TSymbolTableLevel&);
 
     int currentLevel() const { return static_cast<int>(table.size()) - 1; }
+
+    // Search from 'level' outward, stopping at the first frozen level, whose index
+    // covers everything beneath it.  Leaves 'level' at the level the symbol was
+    // found in, or 0 if it wasn't.
+    //
+    // A variable found in a shared level is replaced there by a writable copy, as the
+    // compile may edit it in place, as it would a level of its own.
+    TSymbol* findDownFrom(const TString& name, int& level, int& thisDepth)
+    {
+        thisDepth = 0;
+        do {
+            const TSymbolTableLevel& scope = *table[level];
+            if (scope.isFrozen()) {
+                TSymbol* symbol = scope.findFrozen(name, level);
+                if (symbol == nullptr)
+                    level = 0;
+                return symbol;
+            }
+            if (scope.isThisLevel())
+                ++thisDepth;
+            TSymbol* symbol = scope.find(name);
+            if (symbol != nullptr && scope.isShared() && symbol->isReadOnly() && symbol->getAsFunction() == nullptr)
+                symbol = table[level]->unshare(*symbol);
+            if (symbol != nullptr)
+                return symbol;
+        } while (--level >= 0);
+
+        level = 0;
+        return nullptr;
+    }
+
+    // 'name' may be mangled
+    void materializeBuiltInFunctions(const TString& name)
+    {
+        size_t parenAt = name.find_first_of('(');
+        builtInFunctionSource->materialize(name.c_str(), parenAt == TString::npos ? name.size() : parenAt, *this);
+    }
+
     std::vector<TSymbolTableLevel*> table;
     long long uniqueId;     // for unique identification in code generation
     bool noBuiltInRedeclarations;
     bool separateNameSpaces;
     unsigned int adoptedLevels;
+    TUnorderedMap<TString, const TFunction*> selectedOverloads;
+    TBuiltInFunctionSource* builtInFunctionSource;
+    int builtInFunctionLevel;
 };
 
 } // end namespace glslang
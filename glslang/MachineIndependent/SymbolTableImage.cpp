@@ -0,0 +1,781 @@
+//
+// Copyright (C) 2026 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+//
+// Writing and reading built-in symbol table images.  See SymbolTableImage.h.
+//
+// All multi-byte values are little endian.  Strings are a 32-bit length
+// followed by the characters; a length of ~0 means a null string pointer.
+//
+
+#include "SymbolTableImage.h"
+
+#include <climits>
+#include <cstring>
+#include <set>
+#include <type_traits>
+
+// Build-time generated includes
+#include "glslang/build_info.h"
+
+namespace glslang {
+
+static_assert(std::is_trivially_copyable<TQualifier>::value, "TQualifier is stored by value in symbol table images");
+static_assert(std::is_trivially_copyable<TSampler>::value, "TSampler is stored by value in symbol table images");
+
+namespace {
+
+const unsigned int ImageMagic = 0x49424c47;   // "GLBI"
+const unsigned int ImageFormatVersion = 2;
+const unsigned int NullString = ~0u;
+
+// Symbol kinds, as stored in a level
+enum TImageSymbolKind {
+    EiskVariable,
+    EiskFunction,
+    EiskAnonContainer,  // a container of anonymous members; the members are recreated from it
+};
+
+// The fewest bytes the items counted in an image take, for bounding the counts:
+// a string is at least its length, and a type at least its fixed-size fields,
+// two strings, and the flags for array sizes and type parameters.
+const size_t MinStringBytes = 4;
+const size_t MinTypeBytes = 6 + sizeof(TQualifier) + sizeof(TSampler) + 2 * MinStringBytes + 2;
+
+// What identifies the build that wrote an image, followed in the image by
+// GLSLANG_BUILD_COMMIT, as sizes alone can match across builds.
+const unsigned int Fingerprint[] = {
+    ImageMagic,
+    ImageFormatVersion,
+    GLSLANG_VERSION_MAJOR,
+    GLSLANG_VERSION_MINOR,
+    GLSLANG_VERSION_PATCH,
+    static_cast<unsigned int>(sizeof(TQualifier)),
+    static_cast<unsigned int>(sizeof(TSampler)),
+    static_cast<unsigned int>(sizeof(TConstUnion)),
+    EbtNumTypes,
+    EbvLast,
+};
+
+} // end anonymous namespace
+
+//
+// TSymbolTableWriter
+//
+
+void TSymbolTableWriter::writeU32(unsigned int value)
+{
+    for (int b = 0; b < 4; ++b)
+        writeU8((value >> (8 * b)) & 0xff);
+}
+
+void TSymbolTableWriter::writeU64(unsigned long long value)
+{
+    writeU32(static_cast<unsigned int>(value & 0xffffffff));
+    writeU32(static_cast<unsigned int>(value >> 32));
+}
+
+void TSymbolTableWriter::writeBytes(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+void TSymbolTableWriter::writeString(const TString* str)
+{
+    if (str == nullptr) {
+        writeU32(NullString);
+        return;
+    }
+
+    writeU32(static_cast<unsigned int>(str->size()));
+    writeBytes(str->data(), str->size());
+}
+
+void TSymbolTableWriter::writeExtensions(int numExtensions, const char* const* extensionList)
+{
+    writeInt(numExtensions);
+    for (int e = 0; e < numExtensions; ++e) {
+        const size_t length = strlen(extensionList[e]);
+        writeU32(static_cast<unsigned int>(length));
+        writeBytes(extensionList[e], length);
+    }
+}
+
+void TSymbolTableWriter::writeFingerprint()
+{
+    for (unsigned int word : Fingerprint)
+        writeU32(word);
+
+    const TString commit(GLSLANG_BUILD_COMMIT);
+    writeString(&commit);
+}
+
+void TSymbolTableWriter::writeArraySizes(const TArraySizes* arraySizes)
+{
+    writeU8(arraySizes != nullptr);
+    if (arraySizes == nullptr)
+        return;
+
+    writeInt(arraySizes->getNumDims());
+    for (int d = 0; d < arraySizes->getNumDims(); ++d) {
+        if (arraySizes->getDimNode(d) != nullptr)
+            ok = false;
+        writeInt(arraySizes->getDimSize(d));
+    }
+    writeInt(arraySizes->implicitArraySize);
+    writeU8(arraySizes->implicitlySized);
+    writeU8(arraySizes->variablyIndexed);
+}
+
+// The qualifier is stored by value, but without its pointers, which images
+// don't carry (writeType() checks they are null).
+void TSymbolTableWriter::writeQualifier(const TQualifier& qualifier)
+{
+    TQualifier stored = qualifier;
+    stored.semanticName = nullptr;
+    stored.spirvDecorate = nullptr;
+    writeBytes(&stored, sizeof(stored));
+}
+
+void TSymbolTableWriter::writeType(const TType& type)
+{
+    if (type.spirvType != nullptr || type.isReference() ||
+        type.qualifier.semanticName != nullptr || type.qualifier.spirvDecorate != nullptr)
+        ok = false;
+
+    writeU8(type.basicType);
+    writeU8(type.vectorSize);
+    writeU8(type.matrixCols);
+    writeU8(type.matrixRows);
+    writeU8(type.coopmatKHRuse);
+    writeU8((type.vector1            ? 1 : 0) |
+            (type.coopmatNV          ? 2 : 0) |
+            (type.coopmatKHR         ? 4 : 0) |
+            (type.coopmatKHRUseValid ? 8 : 0));
+    writeQualifier(type.qualifier);
+    writeBytes(&type.sampler, sizeof(type.sampler));
+    writeString(type.fieldName);
+    writeString(type.typeName);
+    writeArraySizes(type.arraySizes);
+
+    writeU8(type.typeParameters != nullptr);
+    if (type.typeParameters != nullptr) {
+        if (type.typeParameters->spirvType != nullptr)
+            ok = false;
+        writeU8(type.typeParameters->basicType);
+        writeArraySizes(type.typeParameters->arraySizes);
+    }
+
+    if (! type.isStruct())
+        return;
+    if (type.structure == nullptr) {
+        writeInt(-1);
+        return;
+    }
+
+    // Structures can be shared across types; write each once, and refer to it by id after that.
+    auto it = structIds.find(type.structure);
+    if (it != structIds.end()) {
+        writeInt(it->second);
+        return;
+    }
+    const int id = static_cast<int>(structIds.size());
+    structIds[type.structure] = id;
+    writeInt(id);
+    writeInt(static_cast<int>(type.structure->size()));
+    for (const TTypeLoc& member : *type.structure) {
+        writeType(*member.type);
+        writeString(member.loc.name);
+        writeInt(member.loc.string);
+        writeInt(member.loc.line);
+        writeInt(member.loc.column);
+    }
+}
+
+void TSymbolTableWriter::writeVariable(const TVariable& variable)
+{
+    if (variable.constSubtree != nullptr)
+        ok = false;
+
+    writeString(variable.name);
+    writeU8(variable.mangledName != variable.name);
+    if (variable.mangledName != variable.name)
+        writeString(variable.mangledName);
+    writeU64(variable.uniqueId);
+    writeExtensions(variable.getNumExtensions(), variable.extensions ? variable.extensions->data() : nullptr);
+
+    writeType(variable.type);
+    writeU8(variable.userType);
+    writeInt(variable.anonId);
+
+    const int numConsts = variable.constArray.size();
+    writeInt(numConsts);
+    for (int c = 0; c < numConsts; ++c) {
+        const TConstUnion& value = variable.constArray[c];
+        writeU8(value.getType());
+        switch (value.getType()) {
+        case EbtInt8:   writeU64(static_cast<unsigned long long>(value.getI8Const()));  break;
+        case EbtUint8:  writeU64(value.getU8Const());                                   break;
+        case EbtInt16:  writeU64(static_cast<unsigned long long>(value.getI16Const())); break;
+        case EbtUint16: writeU64(value.getU16Const());                                  break;
+        case EbtInt:    writeU64(static_cast<unsigned long long>(value.getIConst()));   break;
+        case EbtUint:   writeU64(value.getUConst());                                    break;
+        case EbtInt64:  writeU64(static_cast<unsigned long long>(value.getI64Const())); break;
+        case EbtUint64: writeU64(value.getU64Const());                                  break;
+        case EbtBool:   writeU64(value.getBConst());                                    break;
+        case EbtDouble:
+        {
+            const double d = value.getDConst();
+            unsigned long long bits;
+            memcpy(&bits, &d, sizeof(bits));
+            writeU64(bits);
+            break;
+        }
+        default:
+            ok = false;
+            break;
+        }
+    }
+
+    writeU8(variable.hasMemberExtensions());
+    if (variable.hasMemberExtensions()) {
+        const int numMembers = static_cast<int>(variable.memberExtensions->size());
+        writeInt(numMembers);
+        for (int m = 0; m < numMembers; ++m)
+            writeExtensions(variable.getNumMemberExtensions(m), (*variable.memberExtensions)[m].data());
+    }
+}
+
+void TSymbolTableWriter::writeFunction(const TFunction& function)
+{
+    if (function.spirvInst != TSpirvInstruction())
+        ok = false;
+
+    writeString(function.name);
+    writeU64(function.uniqueId);
+    writeExtensions(function.getNumExtensions(), function.extensions ? function.extensions->data() : nullptr);
+
+    writeType(function.returnType);
+    writeInt(function.declaredBuiltIn);
+    writeString(&function.mangledName);
+    writeInt(function.op);
+    writeU8((function.defined             ? 1 : 0) |
+            (function.prototyped          ? 2 : 0) |
+            (function.implicitThis        ? 4 : 0) |
+            (function.illegalImplicitThis ? 8 : 0));
+    writeInt(function.defaultParamCount);
+    writeInt(function.linkType);
+
+    writeInt(function.getParamCount());
+    for (const TParameter& param : function.parameters) {
+        if (param.defaultValue != nullptr)
+            ok = false;
+        writeString(param.name);
+        writeType(*param.type);
+    }
+}
+
+void TSymbolTableWriter::writeLevel(const TSymbolTableLevel& level)
+{
+    writeInt(level.anonId);
+    writeU8(level.thisLevel);
+    writeU8(level.defaultPrecision != nullptr);
+    if (level.defaultPrecision != nullptr) {
+        for (int t = 0; t < EbtNumTypes; ++t)
+            writeU8(level.defaultPrecision[t]);
+    }
+
+    const auto isRetargeted = [&level](const TString& name) {
+        for (const auto& retarget : level.retargetedSymbols) {
+            if (retarget.first == name)
+                return true;
+        }
+        return false;
+    };
+
+    // Count first, so the reader knows how many entries follow.
+    std::set<int> containersSeen;
+    int numEntries = 0;
+    for (const auto& entry : level.level) {
+        const TAnonMember* anon = entry.second->getAsAnonMember();
+        if (anon != nullptr) {
+            if (containersSeen.insert(anon->getAnonId()).second)
+                ++numEntries;
+        } else if (! isRetargeted(entry.first))
+            ++numEntries;
+    }
+
+    writeInt(numEntries);
+    containersSeen.clear();
+    for (const auto& entry : level.level) {
+        const TSymbol& symbol = *entry.second;
+        const TAnonMember* anon = symbol.getAsAnonMember();
+        if (anon != nullptr) {
+            // Like TSymbolTableLevel::clone(), write the container once, which brings all its members.
+            if (containersSeen.insert(anon->getAnonId()).second) {
+                writeU8(EiskAnonContainer);
+                writeVariable(anon->getAnonContainer());
+            }
+        } else if (! isRetargeted(entry.first)) {
+            if (symbol.getAsFunction() != nullptr) {
+                writeU8(EiskFunction);
+                writeString(&entry.first);
+                writeFunction(*symbol.getAsFunction());
+            } else {
+                writeU8(EiskVariable);
+                writeString(&entry.first);
+                writeVariable(*symbol.getAsVariable());
+            }
+        }
+    }
+
+    writeInt(static_cast<int>(level.retargetedSymbols.size()));
+    for (const auto& retarget : level.retargetedSymbols) {
+        writeString(&retarget.first);
+        writeString(&retarget.second);
+    }
+}
+
+void TSymbolTableWriter::writeTable(const TSymbolTable& table)
+{
+    writeU64(static_cast<unsigned long long>(table.uniqueId));
+    writeU8(table.noBuiltInRedeclarations);
+    writeU8(table.separateNameSpaces);
+    writeInt(static_cast<int>(table.table.size() - table.adoptedLevels));
+    for (size_t level = table.adoptedLevels; level < table.table.size(); ++level)
+        writeLevel(*table.table[level]);
+}
+
+//
+// TSymbolTableReader
+//
+
+unsigned int TSymbolTableReader::readU8()
+{
+    if (cur == end) {
+        ok = false;
+        return 0;
+    }
+
+    return *cur++;
+}
+
+unsigned int TSymbolTableReader::readU32()
+{
+    unsigned int value = 0;
+    for (int b = 0; b < 4; ++b)
+        value |= readU8() << (8 * b);
+
+    return value;
+}
+
+unsigned long long TSymbolTableReader::readU64()
+{
+    const unsigned long long low = readU32();
+    const unsigned long long high = readU32();
+
+    return low | (high << 32);
+}
+
+void TSymbolTableReader::readBytes(void* data, size_t size)
+{
+    if (static_cast<size_t>(end - cur) < size) {
+        ok = false;
+        cur = end;
+        memset(data, 0, size);
+        return;
+    }
+
+    memcpy(data, cur, size);
+    cur += size;
+}
+
+bool TSymbolTableReader::readInt(int& value)
+{
+    value = static_cast<int>(readU32());
+
+    return ok;
+}
+
+//
+// Read a count of items that each take at least 'itemBytes' of the image,
+// failing for more than the rest of the image can hold.  So a corrupt or
+// truncated image can't make the reader allocate for, or loop over, items
+// that aren't there.
+//
+bool TSymbolTableReader::readCount(int& count, size_t itemBytes)
+{
+    const unsigned int value = readU32();
+    if (! ok || value > static_cast<size_t>(end - cur) / itemBytes || value > static_cast<unsigned int>(INT_MAX)) {
+        ok = false;
+        count = 0;
+        return false;
+    }
+
+    count = static_cast<int>(value);
+
+    return true;
+}
+
+TString* TSymbolTableReader::readString()
+{
+    const unsigned int size = readU32();
+    if (size == NullString || ! ok)
+        return nullptr;
+    if (static_cast<size_t>(end - cur) < size) {
+        ok = false;
+        cur = end;
+        return nullptr;
+    }
+
+    TString* str = NewPoolObject(static_cast<TString*>(nullptr));
+    str->assign(reinterpret_cast<const char*>(cur), size);
+    cur += size;
+
+    return str;
+}
+
+void TSymbolTableReader::readExtensions(std::vector<const char*>& list)
+{
+    list.clear();
+    int numExtensions;
+    if (! readCount(numExtensions, MinStringBytes))
+        return;
+
+    for (int e = 0; e < numExtensions && ok; ++e) {
+        const TString* name = readString();
+        if (name == nullptr) {
+            ok = false;
+            return;
+        }
+
+        // Symbols only keep pointers to extension names, so those need to outlive the table.
+        auto it = extensions.find(name->c_str());
+        if (it == extensions.end())
+            it = extensions.insert({ name->c_str(), name->c_str() }).first;
+        list.push_back(it->second);
+    }
+}
+
+bool TSymbolTableReader::readFingerprint()
+{
+    for (unsigned int word : Fingerprint) {
+        if (readU32() != word)
+            ok = false;
+    }
+    if (! ok)
+        return false;
+
+    // Compared in place, as the reader's pool isn't set up yet.
+    const char* commit = GLSLANG_BUILD_COMMIT;
+    const size_t length = strlen(commit);
+    if (readU32() != length || static_cast<size_t>(end - cur) < length || memcmp(cur, commit, length) != 0)
+        ok = false;
+    else
+        cur += length;
+
+    return ok;
+}
+
+TArraySizes* TSymbolTableReader::readArraySizes()
+{
+    if (readU8() == 0)
+        return nullptr;
+
+    TArraySizes* arraySizes = new TArraySizes;
+    int numDims;
+    if (! readCount(numDims, 4))
+        return arraySizes;
+    for (int d = 0; d < numDims && ok; ++d)
+        arraySizes->addInnerSize(static_cast<int>(readU32()));
+    arraySizes->implicitArraySize = static_cast<int>(readU32());
+    arraySizes->implicitlySized = readU8() != 0;
+    arraySizes->variablyIndexed = readU8() != 0;
+
+    return arraySizes;
+}
+
+// Never trust pointers from the image: the writer stores them null.
+void TSymbolTableReader::readQualifier(TQualifier& qualifier)
+{
+    readBytes(&qualifier, sizeof(qualifier));
+    if (qualifier.semanticName != nullptr || qualifier.spirvDecorate != nullptr)
+        ok = false;
+    qualifier.semanticName = nullptr;
+    qualifier.spirvDecorate = nullptr;
+}
+
+void TSymbolTableReader::readType(TType& type)
+{
+    const unsigned int basicType = readU8();
+    if (basicType >= EbtNumTypes)
+        ok = false;
+    type.basicType = static_cast<TBasicType>(basicType);
+    type.vectorSize = readU8();
+    type.matrixCols = readU8();
+    type.matrixRows = readU8();
+    type.coopmatKHRuse = readU8();
+    const unsigned int flags = readU8();
+    type.vector1            = (flags & 1) != 0;
+    type.coopmatNV          = (flags & 2) != 0;
+    type.coopmatKHR         = (flags & 4) != 0;
+    type.coopmatKHRUseValid = (flags & 8) != 0;
+    readQualifier(type.qualifier);
+    readBytes(&type.sampler, sizeof(type.sampler));
+    type.fieldName = readString();
+    type.typeName = readString();
+    type.arraySizes = readArraySizes();
+
+    if (readU8() != 0) {
+        type.typeParameters = new TTypeParameters;
+        type.typeParameters->basicType = static_cast<TBasicType>(readU8());
+        type.typeParameters->arraySizes = readArraySizes();
+        type.typeParameters->spirvType = nullptr;
+    }
+
+    if (! type.isStruct() || ! ok)
+        return;
+
+    const int id = static_cast<int>(readU32());
+    if (id == -1)
+        return;
+    if (id >= 0 && id < static_cast<int>(structs.size())) {
+        type.structure = structs[id];
+        return;
+    }
+    if (id != static_cast<int>(structs.size())) {
+        ok = false;
+        return;
+    }
+
+    type.structure = new TTypeList;
+    structs.push_back(type.structure);
+    int numMembers;
+    readCount(numMembers, MinTypeBytes + MinStringBytes + 12);
+    for (int m = 0; m < numMembers && ok; ++m) {
+        TTypeLoc member;
+        member.type = new TType;
+        readType(*member.type);
+        member.loc.name = readString();
+        member.loc.string = static_cast<int>(readU32());
+        member.loc.line = static_cast<int>(readU32());
+        member.loc.column = static_cast<int>(readU32());
+        type.structure->push_back(member);
+    }
+}
+
+TVariable* TSymbolTableReader::readVariable()
+{
+    const TString* name = readString();
+    const TString* mangledName = readU8() != 0 ? readString() : name;
+    const unsigned long long uniqueId = readU64();
+    std::vector<const char*> extensionList;
+    readExtensions(extensionList);
+    if (name == nullptr || mangledName == nullptr)
+        ok = false;
+    if (! ok)
+        return nullptr;
+
+    TType type;
+    readType(type);
+    const bool userType = readU8() != 0;
+    TVariable* variable = new TVariable(name, mangledName, type, userType);
+    variable->setUniqueId(uniqueId);
+    if (! extensionList.empty())
+        variable->setExtensions(static_cast<int>(extensionList.size()), extensionList.data());
+    variable->setAnonId(static_cast<int>(readU32()));
+
+    int numConsts;
+    if (readCount(numConsts, 9) && numConsts > 0) {
+        TConstUnionArray constArray(numConsts);
+        for (int c = 0; c < numConsts; ++c) {
+            const TBasicType constType = static_cast<TBasicType>(readU8());
+            const unsigned long long bits = readU64();
+            switch (constType) {
+            case EbtInt8:   constArray[c].setI8Const(static_cast<signed char>(bits));      break;
+            case EbtUint8:  constArray[c].setU8Const(static_cast<unsigned char>(bits));    break;
+            case EbtInt16:  constArray[c].setI16Const(static_cast<signed short>(bits));    break;
+            case EbtUint16: constArray[c].setU16Const(static_cast<unsigned short>(bits));  break;
+            case EbtInt:    constArray[c].setIConst(static_cast<int>(bits));               break;
+            case EbtUint:   constArray[c].setUConst(static_cast<unsigned int>(bits));      break;
+            case EbtInt64:  constArray[c].setI64Const(static_cast<long long>(bits));       break;
+            case EbtUint64: constArray[c].setU64Const(bits);                               break;
+            case EbtBool:   constArray[c].setBConst(bits != 0);                            break;
+            case EbtDouble:
+            {
+                double d;
+                memcpy(&d, &bits, sizeof(d));
+                constArray[c].setDConst(d);
+                break;
+            }
+            default:
+                ok = false;
+                break;
+            }
+        }
+        variable->setConstArray(constArray);
+    }
+
+    if (readU8() != 0) {
+        int numMembers;
+        readCount(numMembers, 4);
+        if (! type.isStruct() || numMembers != static_cast<int>(type.getStruct()->size()))
+            ok = false;
+        for (int m = 0; m < numMembers && ok; ++m) {
+            readExtensions(extensionList);
+            if (! extensionList.empty())
+                variable->setMemberExtensions(m, static_cast<int>(extensionList.size()), extensionList.data());
+        }
+    }
+
+    return variable;
+}
+
+TFunction* TSymbolTableReader::readFunction()
+{
+    const TString* name = readString();
+    const unsigned long long uniqueId = readU64();
+    std::vector<const char*> extensionList;
+    readExtensions(extensionList);
+    if (name == nullptr)
+        ok = false;
+    if (! ok)
+        return nullptr;
+
+    TType returnType;
+    readType(returnType);
+    TFunction* function = new TFunction(name, returnType);
+    function->setUniqueId(uniqueId);
+    if (! extensionList.empty())
+        function->setExtensions(static_cast<int>(extensionList.size()), extensionList.data());
+
+    function->declaredBuiltIn = static_cast<TBuiltInVariable>(readU32());
+    const TString* mangledName = readString();
+    if (mangledName != nullptr)
+        function->mangledName = *mangledName;
+    function->op = static_cast<TOperator>(readU32());
+    const unsigned int flags = readU8();
+    function->defined             = (flags & 1) != 0;
+    function->prototyped          = (flags & 2) != 0;
+    function->implicitThis        = (flags & 4) != 0;
+    function->illegalImplicitThis = (flags & 8) != 0;
+    function->defaultParamCount = static_cast<int>(readU32());
+    function->linkType = static_cast<TLinkType>(readU32());
+
+    int numParams;
+    readCount(numParams, MinStringBytes + MinTypeBytes);
+    for (int p = 0; p < numParams && ok; ++p) {
+        TParameter param = { readString(), new TType, nullptr };
+        readType(*param.type);
+        function->parameters.push_back(param);
+    }
+    if (function->defaultParamCount < 0 || function->defaultParamCount > numParams)
+        ok = false;
+
+    return function;
+}
+
+TSymbolTableLevel* TSymbolTableReader::readLevel()
+{
+    TSymbolTableLevel* level = new TSymbolTableLevel;
+    level->anonId = static_cast<int>(readU32());
+    level->thisLevel = readU8() != 0;
+    if (readU8() != 0) {
+        TPrecisionQualifier precisions[EbtNumTypes];
+        for (int t = 0; t < EbtNumTypes; ++t)
+            precisions[t] = static_cast<TPrecisionQualifier>(readU8());
+        level->setPreviousDefaultPrecisions(precisions);
+    }
+
+    int numEntries;
+    readCount(numEntries, 1 + MinStringBytes);
+    for (int e = 0; e < numEntries && ok; ++e) {
+        const unsigned int kind = readU8();
+        if (kind == EiskAnonContainer) {
+            TVariable* container = readVariable();
+            if (container == nullptr || ! container->getType().isStruct() ||
+                ! level->insertAnonymousMembers(*container, 0))
+                ok = false;
+            continue;
+        }
+
+        const TString* key = readString();
+        TSymbol* symbol = nullptr;
+        if (kind == EiskVariable)
+            symbol = readVariable();
+        else if (kind == EiskFunction)
+            symbol = readFunction();
+        if (key == nullptr || symbol == nullptr || ! level->insert(*key, symbol))
+            ok = false;
+    }
+
+    int numRetargets;
+    readCount(numRetargets, 2 * MinStringBytes);
+    for (int r = 0; r < numRetargets && ok; ++r) {
+        const TString* from = readString();
+        const TString* to = readString();
+        if (from == nullptr || to == nullptr) {
+            ok = false;
+            break;
+        }
+        level->retargetedSymbols.push_back({ *from, *to });
+        TSymbol* symbol = level->find(*to);
+        if (symbol != nullptr)
+            level->insert(*from, symbol);
+    }
+
+    return level;
+}
+
+bool TSymbolTableReader::readTable(TSymbolTable& table)
+{
+    const long long uniqueId = static_cast<long long>(readU64());
+    const bool noBuiltInRedeclarations = readU8() != 0;
+    const bool separateNameSpaces = readU8() != 0;
+    int numLevels;
+    readCount(numLevels, 14);
+
+    for (int level = 0; level < numLevels && ok; ++level)
+        table.table.push_back(readLevel());
+
+    table.uniqueId = uniqueId;
+    table.noBuiltInRedeclarations = noBuiltInRedeclarations;
+    table.separateNameSpaces = separateNameSpaces;
+
+    return ok;
+}
+
+} // end namespace glslang
@@ -0,0 +1,140 @@
+//
+// Copyright (C) 2026 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef _SYMBOL_TABLE_IMAGE_INCLUDED_
+#define _SYMBOL_TABLE_IMAGE_INCLUDED_
+
+//
+// Flat binary images of built-in symbol tables.
+//
+// The built-in tables are normally produced by generating the built-in
+// declarations as text and running them through the whole front end.  Once
+// built, they are read-only, so they can instead be written out as an image
+// and later reconstructed directly, without scanning or parsing anything.
+//
+// An image stores some POD parts of types (TQualifier, TSampler) with their
+// in-memory layout, so it is only meaningful to the glslang build that wrote
+// it.  writeFingerprint()/readFingerprint() reject images from other builds.
+//
+// Only what the built-ins actually use is supported: specialization-constant
+// array sizes, default parameter values, spirv_* intrinsics, buffer references
+// and semantic names make write() fail rather than produce a partial image.
+//
+
+#include "SymbolTable.h"
+
+#include <map>
+#include <vector>
+
+namespace glslang {
+
+class TSymbolTableWriter {
+public:
+    explicit TSymbolTableWriter(std::vector<unsigned char>& out) : out(out), ok(true) { }
+
+    void writeFingerprint();
+    void writeInt(int value) { writeU32(static_cast<unsigned int>(value)); }
+
+    // Write all the levels owned by the table (not those it adopted).
+    void writeTable(const TSymbolTable&);
+
+    bool success() const { return ok; }
+
+protected:
+    TSymbolTableWriter(const TSymbolTableWriter&);
+    TSymbolTableWriter& operator=(const TSymbolTableWriter&);
+
+    void writeU8(unsigned int value) { out.push_back(static_cast<unsigned char>(value)); }
+    void writeU32(unsigned int value);
+    void writeU64(unsigned long long value);
+    void writeBytes(const void* data, size_t size);
+    void writeString(const TString* str);
+    void writeExtensions(int numExtensions, const char* const* extensions);
+    void writeArraySizes(const TArraySizes*);
+    void writeQualifier(const TQualifier&);
+    void writeType(const TType&);
+    void writeVariable(const TVariable&);
+    void writeFunction(const TFunction&);
+    void writeLevel(const TSymbolTableLevel&);
+
+    std::vector<unsigned char>& out;
+    std::map<const TTypeList*, int> structIds;   // preserves structure sharing within an image
+    bool ok;
+};
+
+//
+// Reconstructs what a TSymbolTableWriter wrote.  All objects are allocated from
+// the current thread's pool, the same as if they had been parsed.
+//
+class TSymbolTableReader {
+public:
+    TSymbolTableReader(const unsigned char* data, size_t size) : cur(data), end(data + size), ok(true) { }
+
+    bool readFingerprint();
+    bool readInt(int& value);
+
+    // Append the levels of an image table on top of any levels 'table' has already adopted.
+    bool readTable(TSymbolTable& table);
+
+    bool atEnd() const { return cur == end; }
+
+protected:
+    TSymbolTableReader(const TSymbolTableReader&);
+    TSymbolTableReader& operator=(const TSymbolTableReader&);
+
+    unsigned int readU8();
+    unsigned int readU32();
+    unsigned long long readU64();
+    void readBytes(void* data, size_t size);
+    bool readCount(int& count, size_t itemBytes);
+    TString* readString();
+    void readExtensions(std::vector<const char*>& list);
+    TArraySizes* readArraySizes();
+    void readQualifier(TQualifier&);
+    void readType(TType&);
+    TVariable* readVariable();
+    TFunction* readFunction();
+    TSymbolTableLevel* readLevel();
+
+    const unsigned char* cur;
+    const unsigned char* end;
+    std::vector<TTypeList*> structs;                 // indexed by the writer's structIds
+    std::map<std::string, const char*> extensions;   // one pool copy of each extension name
+    bool ok;
+};
+
+} // end namespace glslang
+
+#endif // _SYMBOL_TABLE_IMAGE_INCLUDED_
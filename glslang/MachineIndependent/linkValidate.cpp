@@ -1515,7 +1515,8 @@ void TIntermediate::finalCheck(TInfoSink& infoSink, bool keepUncalled)
             // Implicitly size arrays.
             // If an unsized array is left as unsized, it effectively
             // becomes run-time sized.
-            symbol->getWritableType().adoptImplicitArraySizes(false);
+            if (symbol->isArray() || symbol->isStruct())
+                symbol->getWritableType().adoptImplicitArraySizes(false);
         }
     } finalLinkTraverser;
 
@@ -46,6 +46,7 @@
 #include <algorithm>
 #include <array>
 #include <functional>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -293,6 +294,40 @@ private:
     bool isSet = false;
 };
 
+//
+// Something outside the intermediate's own pool that its tree points into, such as
+// the shared built-in symbol tables, kept alive for as long as the intermediate is.
+//
+class TIntermediateHold {
+public:
+    virtual ~TIntermediateHold() { }
+};
+
+//
+// For its lifetime, counts what the thread's current pool allocates toward one
+// phase in 'stats', which can be null to count nothing.  switchTo() ends the
+// phase and starts counting toward another.
+//
+class TMemoryPhaseMarker {
+public:
+    TMemoryPhaseMarker(TMemoryStats* stats, EShMemoryPhase phase);
+    ~TMemoryPhaseMarker() { end(); }
+    void switchTo(EShMemoryPhase phase);
+
+protected:
+    void begin(EShMemoryPhase phase);
+    void end();
+
+    TMemoryStats* stats;
+    TPoolAllocator& pool;
+    EShMemoryPhase phase;
+    TPoolAllocator::TStats start;
+
+private:
+    TMemoryPhaseMarker(const TMemoryPhaseMarker&);
+    TMemoryPhaseMarker& operator=(const TMemoryPhaseMarker&);
+};
+
 //
 // Set of helper functions to help parse and build the tree.
 //
@@ -358,7 +393,8 @@ public:
         spirvRequirement(nullptr),
         spirvExecutionMode(nullptr),
         uniformLocationBase(0),
-        quadDerivMode(false), reqFullQuadsMode(false)
+        quadDerivMode(false), reqFullQuadsMode(false),
+        memoryStats(nullptr)
     {
         localSize[0] = 1;
         localSize[1] = 1;
@@ -1103,6 +1139,14 @@ public:
     unsigned long long getUniqueId() const { return uniqueId; }
     void setUniqueId(unsigned long long id) { uniqueId = id; }
 
+    // Takes ownership of 'hold', releasing it when the intermediate is destroyed.
+    void addHold(TIntermediateHold* hold) { holds.emplace_back(hold); }
+
+    // Where work on this intermediate records its memory use, if anywhere.
+    void setMemoryStats(TMemoryStats* stats) { memoryStats = stats; }
+    TMemoryStats* getMemoryStats() const { return memoryStats; }
+    void getTreeStats(TTreeStats&) const;
+
     // Certain explicit conversions are allowed conditionally
     bool getArithemeticInt8Enabled() const {
         return numericFeatures.contains(TNumericFeatures::shader_explicit_arithmetic_types) ||
@@ -1287,6 +1331,9 @@ protected:
     // for OpModuleProcessed, or equivalent
     TProcesses processes;
 
+    std::vector<std::unique_ptr<TIntermediateHold>> holds;
+    TMemoryStats* memoryStats;
+
 private:
     void operator=(TIntermediate&); // prevent assignments
 };
@@ -81,6 +81,7 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include <algorithm>
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
@@ -208,6 +209,7 @@ int TPpContext::CPPdefine(TPpToken* ppToken)
         *existing = mac;
     } else
         addMacroDef(defAtom, mac);
+    forgetMemoizedCalls();
 
     return '\n';
 }
@@ -225,8 +227,10 @@ int TPpContext::CPPundef(TPpToken* ppToken)
     parseContext.reservedPpErrorCheck(ppToken->loc, ppToken->name, "#undef");
 
     MacroSymbol* macro = lookupMacroDef(atomStrings.getAtom(ppToken->name));
-    if (macro != nullptr)
+    if (macro != nullptr) {
         macro->undef = 1;
+        forgetMemoizedCalls();
+    }
     token = scanToken(ppToken);
     if (token != '\n')
         parseContext.ppError(ppToken->loc, "can only be followed by a single macro name", "#undef", "");
@@ -283,6 +287,8 @@ int TPpContext::CPPelse(int matchelse, TPpToken* ppToken)
             --depth;
             --ifdepth;
         } else if (matchelse && depth == 0) {
+            if (nextAtom == PpAtomElse || nextAtom == PpAtomElif)
+                guardElse();
             if (nextAtom == PpAtomElse) {
                 elseSeen[elsetracker] = true;
                 token = extraTokenCheck(nextAtom, ppToken, scanToken(ppToken));
@@ -601,16 +607,21 @@ int TPpContext::CPPifdef(int defined, TPpToken* ppToken)
     if (token != PpAtomIdentifier) {
         if (defined)
             parseContext.ppError(ppToken->loc, "must be followed by macro name", "#ifdef", "");
-        else
+        else {
             parseContext.ppError(ppToken->loc, "must be followed by macro name", "#ifndef", "");
+            guardIfndef(0);
+        }
     } else {
         MacroSymbol* macro = lookupMacroDef(atomStrings.getAtom(ppToken->name));
+        const int guard = defined ? 0 : atomStrings.getAddAtom(ppToken->name);
         token = scanToken(ppToken);
         if (token != '\n') {
             parseContext.ppError(ppToken->loc, "unexpected tokens following #ifdef directive - expected a newline", "#ifdef", "");
             while (token != '\n' && token != EndOfInput)
                 token = scanToken(ppToken);
         }
+        if (! defined)
+            guardIfndef(guard);
         if (((macro != nullptr && !macro->undef) ? 1 : 0) != defined)
             token = CPPelse(1, ppToken);
     }
@@ -664,6 +675,12 @@ int TPpContext::CPPinclude(TPpToken* ppToken)
 
     // Process well-formed directive
 
+    // A header included before, that would add nothing now, need not be looked for again
+    const std::string key = includeKey(filename, startWithLocalSearch);
+    const auto resolved = resolvedIncludes.find(key);
+    if (resolved != resolvedIncludes.end() && includeIsEmpty(resolved->second))
+        return token;
+
     // Find the inclusion, first look in "Local" ("") paths, if requested,
     // otherwise, only search the "System" (<>) paths.
     TShader::Includer::IncludeResult* res = nullptr;
@@ -676,7 +693,14 @@ int TPpContext::CPPinclude(TPpToken* ppToken)
 
     // Process the results
     if (res != nullptr && !res->headerName.empty()) {
-        if (res->headerData != nullptr && res->headerLength > 0) {
+        resolvedIncludes[key] = res->headerName;
+        if (dependencies != nullptr &&
+            std::find(dependencies->begin(), dependencies->end(), res->headerName) == dependencies->end())
+            dependencies->push_back(res->headerName);
+        if (includeIsEmpty(res->headerName)) {
+            // included before, by another name, and would add nothing now
+            includer.releaseInclude(res);
+        } else if (res->headerData != nullptr && res->headerLength > 0) {
             // path for processing one or more tokens from an included header, hand off 'res'
             const bool forNextLine = parseContext.lineDirectiveShouldSetNextLine();
             std::ostringstream prologue;
@@ -704,6 +728,76 @@ int TPpContext::CPPinclude(TPpToken* ppToken)
     return token;
 }
 
+// Identifies an #include by what the includer is given: the header name, and the names
+// of the headers including it.
+std::string TPpContext::includeKey(const std::string& headerName, bool local) const
+{
+    std::string key = (local ? "\"" : "<") + headerName;
+    for (const TGuardScan& scan : guardScans) {
+        key += '\n';
+        key += scan.headerName;
+    }
+
+    return key;
+}
+
+// Whether including the header of 'resolvedName' again would add nothing, because it is
+// guarded by a macro now defined, or has '#pragma once'.
+bool TPpContext::includeIsEmpty(const std::string& resolvedName)
+{
+    const auto it = includeGuards.find(resolvedName);
+    if (it == includeGuards.end())
+        return false;
+    if (it->second.once)
+        return true;
+    if (it->second.macro == 0)
+        return false;
+    const MacroSymbol* macro = lookupMacroDef(it->second.macro);
+
+    return macro != nullptr && ! macro->undef;
+}
+
+void TPpContext::guardDirective(int atom)
+{
+    if (! atGuardLevel())
+        return;
+
+    TGuardScan& scan = guardScans.back();
+    switch (atom) {
+    case PpAtomIfndef:
+        scan.state = scan.state == EGuardStart ? EGuardOpening : EGuardNone;
+        break;
+    case PpAtomLine:    // only renumbers the rest of the header
+    case PpAtomPragma:  // see CPPpragma()
+        break;
+    default:
+        scan.state = EGuardNone;
+        break;
+    }
+}
+
+void TPpContext::guardIfndef(int macro)
+{
+    if (guardScans.empty())
+        return;
+
+    TGuardScan& scan = guardScans.back();
+    if (scan.state == EGuardOpening && ifdepth == scan.depth + 1) {
+        scan.state = macro != 0 ? EGuardInside : EGuardNone;
+        scan.macro = macro;
+    }
+}
+
+// At the end of a header, remember whether it was guarded.
+void TPpContext::endGuardScan()
+{
+    const TGuardScan& scan = guardScans.back();
+    const bool guarded = scan.state == EGuardInside && ifdepth == scan.depth;
+    if (guarded || includeGuards.find(scan.headerName) != includeGuards.end())
+        includeGuards[scan.headerName].macro = guarded ? scan.macro : 0;
+    guardScans.pop_back();
+}
+
 // Handle #line
 int TPpContext::CPPline(TPpToken* ppToken)
 {
@@ -827,8 +921,16 @@ int TPpContext::CPPpragma(TPpToken* ppToken)
 
     if (token == EndOfInput)
         parseContext.ppError(loc, "directive must end with a newline", "#pragma", "");
-    else
+    else {
+        TString first = tokens.empty() ? "" : tokens[0];
+        if (parseContext.isReadingHLSL())
+            std::transform(first.begin(), first.end(), first.begin(), ::tolower);
+        if (first == "once" && ! guardScans.empty())
+            includeGuards[guardScans.back().headerName].once = true;
+        else
+            guardMissed();
         parseContext.handlePragma(loc, tokens);
+    }
 
     return token;
 }
@@ -927,11 +1029,14 @@ int TPpContext::readCPPline(TPpToken* ppToken)
     int token = scanToken(ppToken);
 
     if (token == PpAtomIdentifier) {
-        switch (atomStrings.getAtom(ppToken->name)) {
+        const int atom = atomStrings.getAtom(ppToken->name);
+        guardDirective(atom);
+        switch (atom) {
         case PpAtomDefine:
             token = CPPdefine(ppToken);
             break;
         case PpAtomElse:
+            guardElse();
             if (elseSeen[elsetracker])
                 parseContext.ppError(ppToken->loc, "#else after #else", "#else", "");
             elseSeen[elsetracker] = true;
@@ -941,6 +1046,7 @@ int TPpContext::readCPPline(TPpToken* ppToken)
             token = CPPelse(0, ppToken);
             break;
         case PpAtomElif:
+            guardElse();
             if (ifdepth == 0)
                 parseContext.ppError(ppToken->loc, "mismatched statements", "#elif", "");
             if (elseSeen[elsetracker])
@@ -1144,8 +1250,10 @@ int TPpContext::tMacroInput::scan(TPpToken* ppToken)
         }
     }
 
-    if (token == EndOfInput)
+    if (token == EndOfInput && mac->busy) {
         mac->busy = 0;
+        --pp->busyMacros;
+    }
 
     return token;
 }
@@ -1165,6 +1273,31 @@ int TPpContext::tZeroInput::scan(TPpToken* ppToken)
     return PpAtomConstInt;
 }
 
+// Stop recording the expansion of a memoized call, keeping it only if 'complete'.
+void TPpContext::endRecording(bool complete)
+{
+    // A trailing function-like macro name is expanded again when replayed, with the
+    // tokens after the call as its arguments, which might not have happened here.
+    const TokenStream::Token* last = recordingCall->expansion.lastToken();
+    if (complete && last != nullptr && last->isAtom(PpAtomIdentifier)) {
+        TPpToken lastToken;
+        TokenStream::Token(*last).get(lastToken);
+        MacroSymbol* macro = lookupMacroDef(atomStrings.getAtom(lastToken.name));
+        if (macro != nullptr && macro->functionLike)
+            complete = false;
+    }
+
+    // A replay wouldn't repeat what was reported along the way (pasting errors, say).
+    if (parseContext.infoSink.info.getNumMessages() != recordingMessages)
+        complete = false;
+
+    recordingCall->recorded = complete;
+    recordingCall->failed = ! complete;
+    if (! complete)
+        recordingCall->expansion = TokenStream();
+    recordingCall = nullptr;
+}
+
 //
 // Check a token to see if it is a macro that should be expanded:
 // - If it is, and defined, push a tInput that will produce the appropriate
@@ -1177,7 +1310,7 @@ int TPpContext::tZeroInput::scan(TPpToken* ppToken)
 //   * The expansion was started, but could not be completed, due to an error
 //     that cannot be recovered from. Returns MacroExpandError.
 //
-MacroExpandResult TPpContext::MacroExpand(TPpToken* ppToken, bool expandUndef, bool newLineOkay)
+MacroExpandResult TPpContext::MacroExpand(TPpToken* ppToken, bool expandUndef, bool newLineOkay, bool memoize)
 {
     ppToken->space = false;
     int macroAtom = atomStrings.getAtom(ppToken->name);
@@ -1186,6 +1319,9 @@ MacroExpandResult TPpContext::MacroExpand(TPpToken* ppToken, bool expandUndef, b
 
     switch (macroAtom) {
     case PpAtomLineMacro:
+        // what this expands to depends on where it is, so can't be replayed elsewhere
+        if (recordingCall != nullptr)
+            endRecording(false);
         // Arguments which are macro have been replaced in the first stage.
         if (ppToken->ival == 0)
             ppToken->ival = parseContext.getCurrentLoc().line;
@@ -1194,6 +1330,8 @@ MacroExpandResult TPpContext::MacroExpand(TPpToken* ppToken, bool expandUndef, b
         return MacroExpandStarted;
 
     case PpAtomFileMacro: {
+        if (recordingCall != nullptr)
+            endRecording(false);
         if (parseContext.getCurrentLoc().name)
             parseContext.ppRequireExtensions(ppToken->loc, 1, &E_GL_GOOGLE_cpp_style_line_directive, "filename-based __FILE__");
         ppToken->ival = parseContext.getCurrentLoc().string;
@@ -1333,14 +1471,42 @@ MacroExpandResult TPpContext::MacroExpand(TPpToken* ppToken, bool expandUndef, b
             parseContext.ppError(loc, "Too many args in macro", "macro expansion", atomStrings.getString(macroAtom));
         }
 
+        // A call from the source text, outside any other expansion, expands the same
+        // as an earlier call of this macro with the same arguments, so replay that if it
+        // was recorded.  Otherwise, the second time a call is seen, have tokenize()
+        // record what it expands to.
+        if (memoize && busyMacros == 0 && recordingCall == nullptr && arg >= in->mac->args.size() &&
+            token == ')') {
+            TString key(reinterpret_cast<const char*>(&macroAtom), sizeof(macroAtom));
+            for (size_t i = 0; i < in->args.size(); i++)
+                in->args[i]->appendKey(key);
+            auto call = memoizedCalls.find(key);
+            if (call != memoizedCalls.end()) {
+                if (call->second.recorded) {
+                    delete in;
+                    pushTokenStreamInput(call->second.expansion, false, true);
+                    return MacroExpandStarted;
+                }
+                if (! call->second.failed) {
+                    recordingCall = &call->second;
+                    recordingDepth = inputStack.size();
+                    recordingMessages = parseContext.infoSink.info.getNumMessages();
+                }
+            } else if (memoizedCalls.size() < maxMemoizedCalls)
+                memoizedCalls[key];
+        }
+
         // We need both expanded and non-expanded forms of the argument, for whether or
         // not token pasting will be applied later when the argument is consumed next to ##.
         for (size_t i = 0; i < in->mac->args.size(); i++)
             in->expandedArgs[i] = PrescanMacroArg(*in->args[i], ppToken, newLineOkay);
+        if (recordingCall != nullptr && recordingDepth == inputStack.size())
+            recordingEnded = false;
     }
 
     pushInput(in);
     macro->busy = 1;
+    ++busyMacros;
     macro->body.reset();
 
     return MacroExpandStarted;
@@ -80,9 +80,11 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 #include "PpContext.h"
 #include "PpTokens.h"
@@ -149,33 +151,136 @@ const struct {
     { PpAtomInclude,         "include" },
 };
 
+// Bad source characters can lead to bad atoms, so these map to a string, too.
+const char BadToken[] = "<bad token>";
+
+// Looks 's' up in an open-addressing table of 'mask' + 1 slots.
+template<class GetString>
+int ProbeSlots(const TStringAtomMap::TSlot* slots, size_t mask, const char* s, size_t length, unsigned hash,
+               const GetString& getString)
+{
+    for (size_t i = hash & mask; slots[i].atom != 0; i = (i + 1) & mask) {
+        // Only strings of the same length get compared, so neither is read past its end.
+        if (slots[i].hash == hash && slots[i].length == length &&
+            memcmp(getString(slots[i].atom), s, length) == 0)
+            return slots[i].atom;
+    }
+
+    return 0;
+}
+
+// Puts 'atom', of a string of 'length', in the first free slot for 'hash'.
+void FillSlot(TStringAtomMap::TSlot* slots, size_t mask, unsigned hash, size_t length, int atom)
+{
+    size_t i = hash & mask;
+    while (slots[i].atom != 0)
+        i = (i + 1) & mask;
+    slots[i].hash = hash;
+    slots[i].length = static_cast<unsigned>(length);
+    slots[i].atom = atom;
+}
+
+// The atoms below PpAtomLast, which every compile starts with.  Made once per
+// process, and only read after that, so shared by all threads.
+class TFixedAtoms {
+public:
+    static const size_t numSlots = 256;
+
+    TFixedAtoms()
+    {
+        for (int atom = 0; atom < PpAtomLast; ++atom)
+            strings[atom] = BadToken;
+        slots.resize(numSlots, TStringAtomMap::TSlot{ 0, 0, 0 });
+
+        // Add single character tokens to the atom table:
+        const char* s = "~!%^&*()-+=|,.<>/?;:[]{}#\\";
+        for (; *s; ++s) {
+            char* single = &singles[2 * static_cast<unsigned char>(*s)];
+            single[0] = *s;
+            add(single, *s);
+        }
+
+        // Add multiple character scanner tokens :
+        for (size_t ii = 0; ii < sizeof(tokens)/sizeof(tokens[0]); ii++)
+            add(tokens[ii].str, tokens[ii].val);
+    }
+
+    int find(const char* s, size_t length, unsigned hash) const
+    {
+        return ProbeSlots(slots.data(), numSlots - 1, s, length, hash, [this](int a) { return strings[a]; });
+    }
+
+    const char* strings[PpAtomLast];
+
+protected:
+    void add(const char* s, int atom)
+    {
+        size_t length;
+        const unsigned hash = TStringAtomMap::hashString(s, length);
+        FillSlot(slots.data(), numSlots - 1, hash, length, atom);
+        strings[atom] = s;
+    }
+
+    std::vector<TStringAtomMap::TSlot> slots;
+    char singles[2 * (PpAtomMaxSingle + 1)] = { };   // a string for each single character token
+};
+
+const TFixedAtoms& GetFixedAtoms()
+{
+    static const TFixedAtoms fixedAtoms;
+    return fixedAtoms;
+}
+
 } // end anonymous namespace
 
 namespace glslang {
 
+const char* const TStringAtomMap::badToken = BadToken;
+
 //
 // Initialize the atom table.
 //
 TStringAtomMap::TStringAtomMap()
 {
-    badToken.assign("<bad token>");
+    // make sure the shared part is ready before compiles need it
+    GetFixedAtoms();
+
+    nextAtom = PpAtomLast;
+}
+
+int TStringAtomMap::findAtom(const char* s, size_t length, unsigned hash) const
+{
+    const int atom = GetFixedAtoms().find(s, length, hash);
+    if (atom != 0 || slots.empty())
+        return atom;
 
-    // Add single character tokens to the atom table:
-    const char* s = "~!%^&*()-+=|,.<>/?;:[]{}#\\";
-    char t[2];
+    return ProbeSlots(slots.data(), slots.size() - 1, s, length, hash,
+                      [this](int a) { return strings[a - PpAtomLast]; });
+}
 
-    t[1] = '\0';
-    while (*s) {
-        t[0] = *s;
-        addAtomFixed(t, s[0]);
-        s++;
+void TStringAtomMap::addAtom(const char* s, size_t length, unsigned hash, int atom)
+{
+    assert(atom == PpAtomLast + static_cast<int>(strings.size()));
+
+    // keep the table at most half full
+    if (2 * (strings.size() + 1) > slots.size()) {
+        TVector<TSlot> grown(std::max(slots.size() * 2, size_t(256)), TSlot{ 0, 0, 0 });
+        for (const TSlot& slot : slots) {
+            if (slot.atom != 0)
+                FillSlot(grown.data(), grown.size() - 1, slot.hash, slot.length, slot.atom);
+        }
+        slots.swap(grown);
     }
 
-    // Add multiple character scanner tokens :
-    for (size_t ii = 0; ii < sizeof(tokens)/sizeof(tokens[0]); ii++)
-        addAtomFixed(tokens[ii].str, tokens[ii].val);
+    char* text = static_cast<char*>(GetThreadPoolAllocator().allocate(length + 1));
+    memcpy(text, s, length + 1);
+    strings.push_back(text);
+    FillSlot(slots.data(), slots.size() - 1, hash, length, atom);
+}
 
-    nextAtom = PpAtomLast;
+const char* TStringAtomMap::fixedString(int atom)
+{
+    return atom >= 0 ? GetFixedAtoms().strings[atom] : badToken;
 }
 
 } // end namespace glslang
@@ -88,14 +88,24 @@ TPpContext::TPpContext(TParseContextBase& pc, const std::string& rootFileName, T
     preamble(nullptr), strings(nullptr), previous_token('\n'), parseContext(pc), includer(inclr), inComment(false),
     rootFileName(rootFileName),
     currentSourceFile(rootFileName),
+    dependencies(nullptr),
+    tokenizedTexts(nullptr),
     disableEscapeSequences(false),
-    inElseSkip(false)
+    inElseSkip(false),
+    pool(GetThreadPoolAllocator()),
+    overMemoryLimit(false)
 {
     ifdepth = 0;
     for (elsetracker = 0; elsetracker < maxIfNesting; elsetracker++)
         elseSeen[elsetracker] = false;
     elsetracker = 0;
 
+    recordingCall = nullptr;
+    recordingDepth = 0;
+    recordingEnded = false;
+    recordingMessages = 0;
+    busyMacros = 0;
+
     strtodStream.imbue(std::locale::classic());
 }
 
@@ -112,7 +122,11 @@ void TPpContext::setInput(TInputScanner& input, bool versionWillBeError)
 {
     assert(inputStack.size() == 0);
 
-    pushInput(new tStringInput(this, input));
+    // the shader's own strings are only worth keeping for others of the same batch
+    if (tokenizedTexts != nullptr && dependencies == nullptr)
+        pushInput(new tTokenizedStringInput(this, input));
+    else
+        pushInput(new tStringInput(this, input));
 
     errorOnVersion = versionWillBeError;
     versionSeen = false;
@@ -79,9 +79,12 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef PPCONTEXT_H
 #define PPCONTEXT_H
 
+#include <memory>
 #include <stack>
+#include <string>
 #include <unordered_map>
 #include <sstream>
+#include <vector>
 
 #include "../ParseHelper.h"
 #include "PpTokens.h"
@@ -132,6 +135,11 @@ class TStringAtomMap {
 // Maintain a bi-directional mapping between relevant preprocessor strings and
 // "atoms" which a unique integers (small, contiguous, not hash-like) per string.
 //
+// The atoms below PpAtomLast (operators and directive names) are the same for
+// every compile, so are looked up in one table made once per process.  Atoms added
+// by a compile go in an open-addressing table of its own, with their text kept in
+// the pool.  Strings are hashed where they are, with no copy made to look them up.
+//
 public:
     TStringAtomMap();
 
@@ -139,46 +147,66 @@ public:
     // Return 0 if no existing string.
     int getAtom(const char* s) const
     {
-        auto it = atomMap.find(s);
-        return it == atomMap.end() ? 0 : it->second;
+        size_t length;
+        const unsigned hash = hashString(s, length);
+        return findAtom(s, length, hash);
     }
 
     // Map a new or existing string -> atom, inventing a new atom if necessary.
     int getAddAtom(const char* s)
     {
-        int atom = getAtom(s);
+        size_t length;
+        const unsigned hash = hashString(s, length);
+        int atom = findAtom(s, length, hash);
         if (atom == 0) {
             atom = nextAtom++;
-            addAtomFixed(s, atom);
+            addAtom(s, length, hash, atom);
         }
         return atom;
     }
 
     // Map atom -> string.
-    const char* getString(int atom) const { return stringMap[atom]->c_str(); }
+    const char* getString(int atom) const
+    {
+        if (atom < PpAtomLast)
+            return fixedString(atom);
+        const size_t index = static_cast<size_t>(atom - PpAtomLast);
+        return index < strings.size() ? strings[index] : badToken;
+    }
+
+    // One slot of an open-addressing table: 0 for 'atom' when empty
+    struct TSlot {
+        unsigned hash;
+        unsigned length;    // of the atom's string
+        int atom;
+    };
+
+    // FNV-1a, setting 'length' to that of 's' along the way
+    static unsigned hashString(const char* s, size_t& length)
+    {
+        unsigned hash = 2166136261u;
+        const char* c = s;
+        for (; *c != '\0'; ++c)
+            hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+        length = static_cast<size_t>(c - s);
+
+        return hash;
+    }
 
 protected:
     TStringAtomMap(TStringAtomMap&);
     TStringAtomMap& operator=(TStringAtomMap&);
 
-    TUnorderedMap<TString, int> atomMap;
-    TVector<const TString*> stringMap;    // these point into the TString in atomMap
-    int nextAtom;
+    int findAtom(const char* s, size_t length, unsigned hash) const;
+    void addAtom(const char* s, size_t length, unsigned hash, int atom);
+    static const char* fixedString(int atom);
 
-    // Bad source characters can lead to bad atoms, so gracefully handle those by
-    // pre-filling the table with them (to avoid if tests later).
-    TString badToken;
+    TVector<TSlot> slots;               // size is a power of 2, at most half full
+    TVector<const char*> strings;       // for atom PpAtomLast + i, in the pool
+    int nextAtom;
 
-    // Add bi-directional mappings:
-    //  - string -> atom
-    //  - atom -> string
-    void addAtomFixed(const char* s, int atom)
-    {
-        auto it = atomMap.insert(std::pair<TString, int>(s, atom)).first;
-        if (stringMap.size() < (size_t)atom + 1)
-            stringMap.resize(atom + 100, &badToken);
-        stringMap[atom] = &it->first;
-    }
+    // Bad source characters can lead to bad atoms, so gracefully handle those
+    static const char* const badToken;
 };
 
 class TInputScanner;
@@ -200,9 +228,29 @@ public:
 
     void setPreamble(const char* preamble, size_t length);
 
+    // True while reading an #include'd header
+    bool inInclude() const { return ! includeStack.empty(); }
+
+    // Only run the directives, skipping all other lines, and list the names of the
+    // headers included, each once, in the order first seen
+    void setDependencyScan(std::vector<std::string>* headers) { dependencies = headers; }
+
     int tokenize(TPpToken& ppToken);
     int tokenPaste(int token, TPpToken&);
 
+    // Whether the shader has gone over its memory limit, reporting it the first time.
+    // Checked as each token is read; work that doesn't read tokens checks it itself.
+    bool checkMemoryLimit()
+    {
+        if (! pool.isOverLimit())
+            return false;
+        if (! overMemoryLimit) {
+            overMemoryLimit = true;
+            parseContext.ppError(parseContext.getCurrentLoc(), "shader memory limit exceeded", "", "");
+        }
+        return true;
+    }
+
     class tInput {
     public:
         tInput(TPpContext* p) : done(false), pp(p) { }
@@ -216,6 +264,7 @@ public:
         virtual bool endOfReplacementList() { return false; } // true when at the end of a macro replacement list (RHS of #define)
         virtual bool isMacroInput() { return false; }
         virtual bool isStringInput() { return false; }
+        virtual bool skipLine() { return false; } // true if it moved past the rest of the line
 
         // Will be called when we start reading tokens from this instance
         virtual void notifyActivated() {}
@@ -235,6 +284,8 @@ public:
     }
     void popInput()
     {
+        if (recordingCall != nullptr && inputStack.size() == recordingDepth + 1)
+            recordingEnded = true;
         inputStack.back()->notifyDeleted();
         delete inputStack.back();
         inputStack.pop_back();
@@ -261,12 +312,18 @@ public:
                 ppToken.clear();
                 ppToken.space = space;
                 ppToken.i64val = i64val;
-                snprintf(ppToken.name, sizeof(ppToken.name), "%s", name.c_str());
+                memcpy(ppToken.name, name.c_str(), name.size() + 1);
                 return atom;
             }
             bool isAtom(int a) const { return atom == a; }
             int getAtom() const { return atom; }
             bool nonSpaced() const { return !space; }
+            void appendKey(TString& key) const
+            {
+                key.append(reinterpret_cast<const char*>(&atom), sizeof(atom));
+                key.push_back(space ? ' ' : '\0');
+                key.append(name.c_str(), name.size() + 1);
+            }
         protected:
             Token() {}
             int atom;
@@ -313,12 +370,109 @@ public:
         bool peekTokenizedPasting(bool lastTokenPastes);
         bool peekUntokenizedPasting();
         void reset() { currentPos = 0; }
+        const Token* lastToken() const { return stream.empty() ? nullptr : &stream.back(); }
+
+        // Append the atoms, spacing and text of the tokens to 'key', for comparing
+        // streams by their keys.
+        void appendKey(TString& key) const
+        {
+            size_t count = stream.size();
+            key.append(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (const Token& token : stream)
+                token.appendKey(key);
+        }
 
     protected:
         TVector<Token> stream;
         size_t currentPos;
     };
 
+    // The tokens scanned from the text of an #include'd header, kept across shaders so
+    // later includes of the same text can replay them instead of scanning it again.
+    // These are tokens as scanned, before directives or macro expansion see them, so
+    // they don't depend on what is defined where the header is included.  Tokens whose
+    // scanning checks the version or extensions in effect are not kept, and get scanned
+    // again each time.  This outlives any one shader's pool, so uses the heap.
+    class TokenizedHeader {
+    public:
+        // Like TokenStream::Token, plus where in the text scanning for it started
+        // ('entry') and stopped, and how far it moved in lines and columns.  Its name
+        // is a piece of the text.
+        struct Token {
+            unsigned int entry;
+            unsigned int end;
+            unsigned int nameStart;
+            unsigned short nameLength;
+            short atom;
+            unsigned short column;
+            unsigned short endColumn;
+            unsigned char lines;      // from the entry to the token
+            unsigned char endLines;   // from the entry to the end
+            bool space;
+            long long i64val;
+        };
+
+        TokenizedHeader(EShSource s, const char* t, size_t length) : source(s), text(t, length) { }
+
+        // Add the token that scanning from offset 'entry' to 'end' found, given where
+        // the scanner was at each, unless replaying it might not do what scanning would.
+        void add(size_t entry, size_t end, int atom, const TPpToken&, const TSourceLoc& entryLoc,
+                 const TSourceLoc& endLoc);
+
+        // The token scanning from 'entry' finds, or nullptr if it was not kept.
+        // 'cursor' remembers where the last one was, for finding the next quickly.
+        const Token* find(size_t entry, size_t& cursor) const;
+
+        // Share 'header' with later includes of the same text, as room allows.
+        static void keep(std::unique_ptr<TokenizedHeader> header);
+
+        // A header kept for this text, if any.
+        static std::shared_ptr<const TokenizedHeader> find(EShSource, const char* text, size_t length);
+
+        // How much memory kept headers may use; 0 turns keeping them off.
+        static void setLimit(size_t bytes);
+        static bool enabled();
+
+        size_t getBytes() const;
+
+        const EShSource source;
+        const std::string text;
+
+    protected:
+        TokenizedHeader(const TokenizedHeader&);
+        TokenizedHeader& operator=(const TokenizedHeader&);
+
+        std::vector<Token> tokens;
+    };
+
+    // The tokens kept for the texts (shader strings and headers) scanned by a batch of
+    // compiles of the same shader, such as the permutations parsed by
+    // TShader::parsePermutations(), up to 'limit' bytes; texts past that are scanned
+    // each time.  Only used by one compile at a time.
+    class TokenizedTexts {
+    public:
+        explicit TokenizedTexts(size_t limit) : limit(limit), bytes(0) { }
+
+        std::shared_ptr<const TokenizedHeader> find(EShSource, const char* text, size_t length) const;
+        void keep(std::unique_ptr<TokenizedHeader> text);
+
+        // Keep nothing more, such as for the last compile of a batch.
+        void stopKeeping() { limit = 0; }
+        bool keeping() const { return bytes < limit; }
+
+    protected:
+        TokenizedTexts(const TokenizedTexts&);
+        TokenizedTexts& operator=(const TokenizedTexts&);
+
+        std::unordered_multimap<size_t, std::shared_ptr<const TokenizedHeader>> texts;
+        size_t limit;
+        size_t bytes;
+    };
+
+    // Replay and keep tokens with 'texts' rather than the headers kept across shaders,
+    // including those of the shader's own strings.
+    void setTokenizedTexts(TokenizedTexts* texts) { tokenizedTexts = texts; }
+
     //
     // From Pp.cpp
     //
@@ -341,6 +495,31 @@ public:
     }
     void addMacroDef(int atom, MacroSymbol& macroDef) { macroDefs[atom] = macroDef; }
 
+    // Function-like macro calls made from the source text, keyed by the macro and the
+    // tokens of its arguments, so a call repeating an earlier one can replay what that
+    // one expanded to.  Forgotten whenever a macro is defined or undefined.  See
+    // MacroExpand() and tokenize().
+    struct TMemoizedCall {
+        TMemoizedCall() : recorded(false), failed(false) { }
+        TokenStream expansion;
+        bool recorded;  // 'expansion' holds the complete expansion
+        bool failed;    // the expansion depended on more than the call, don't try again
+    };
+    static const size_t maxMemoizedCalls = 16384;
+    TUnorderedMap<TString, TMemoizedCall> memoizedCalls;
+    TMemoizedCall* recordingCall;  // the call whose expansion tokenize() is recording
+    size_t recordingDepth;         // inputStack depth below that expansion's input
+    bool recordingEnded;           // that expansion's input was popped
+    size_t recordingMessages;      // messages in the info log when that recording started
+    int busyMacros;                // number of macros with 'busy' set
+
+    void forgetMemoizedCalls()
+    {
+        recordingCall = nullptr;
+        memoizedCalls.clear();
+    }
+    void endRecording(bool complete);
+
 protected:
     TPpContext(TPpContext&);
     TPpContext& operator=(TPpContext&);
@@ -365,6 +544,10 @@ protected:
     {
         int token = EndOfInput;
 
+        // Compiling stops, as at the end of input, once the shader uses too much memory.
+        if (checkMemoryLimit())
+            return token;
+
         while (! inputStack.empty()) {
             token = inputStack.back()->scan(ppToken);
             if (token != EndOfInput || inputStack.empty())
@@ -494,7 +677,7 @@ protected:
     int readCPPline(TPpToken * ppToken);
     int scanHeaderName(TPpToken* ppToken, char delimit);
     TokenStream* PrescanMacroArg(TokenStream&, TPpToken*, bool newLineOkay);
-    MacroExpandResult MacroExpand(TPpToken* ppToken, bool expandUndef, bool newLineOkay);
+    MacroExpandResult MacroExpand(TPpToken* ppToken, bool expandUndef, bool newLineOkay, bool memoize = false);
 
     //
     // From PpTokens.cpp
@@ -549,6 +732,7 @@ protected:
         tStringInput(TPpContext* pp, TInputScanner& i) : tInput(pp), input(&i) { }
         virtual int scan(TPpToken*) override;
         bool isStringInput() override { return true; }
+        bool skipLine() override;
         // Scanner used to get source stream characters.
         //  - Escaped newlines are handled here, invisibly to the caller.
         //  - All forms of newline are handled, and turned into just a '\n'.
@@ -638,7 +822,8 @@ protected:
               includedFile_(includedFile),
               scanner(3, strings, lengths, nullptr, 0, 0, true),
               prevScanner(nullptr),
-              stringInput(pp, scanner)
+              stringInput(pp, scanner),
+              cursor(0)
         {
               strings[0] = prologue_.data();
               strings[1] = includedFile_->headerData;
@@ -654,12 +839,29 @@ protected:
               scanner.setFile(startLoc.getFilenameStr(), 0);
               scanner.setFile(startLoc.getFilenameStr(), 1);
               scanner.setFile(startLoc.getFilenameStr(), 2);
+
+              if (pp->keepingTokens()) {
+                  tokenized = pp->findTokenized(strings[1], lengths[1]);
+                  if (tokenized == nullptr && pp->recordingTokens())
+                      recording.reset(new TokenizedHeader(pp->parseContext.intermediate.getSource(),
+                                                          strings[1], lengths[1]));
+              }
+        }
+
+        ~TokenizableIncludeFile()
+        {
+            if (recording != nullptr)
+                pp->keepTokenized(std::move(recording));
         }
 
         // tInput methods:
-        int scan(TPpToken* t) override { return stringInput.scan(t); }
+        int scan(TPpToken* t) override
+        {
+            return pp->scanTokenized(stringInput, scanner, 1, tokenized.get(), recording.get(), cursor, t);
+        }
         int getch() override { return stringInput.getch(); }
         void ungetch() override { stringInput.ungetch(); }
+        bool skipLine() override { return stringInput.skipLine(); }
 
         void notifyActivated() override
         {
@@ -700,6 +902,56 @@ protected:
         TInputScanner* prevScanner;
         // Delegate object implementing the tInput interface.
         tStringInput stringInput;
+
+        // The header's tokens, from an earlier include of the same text, or being
+        // kept for later ones (at most one of these is set).
+        std::shared_ptr<const TokenizedHeader> tokenized;
+        std::unique_ptr<TokenizedHeader> recording;
+        size_t cursor;
+    };
+
+    // The shader's own strings, replaying the tokens kept for them by an earlier compile
+    // of the same text, or keeping them for later ones, as TokenizableIncludeFile does
+    // for headers.
+    class tTokenizedStringInput : public tStringInput {
+    public:
+        tTokenizedStringInput(TPpContext* pp, TInputScanner& i) :
+            tStringInput(pp, i), string(-1), cursor(0) { }
+
+        ~tTokenizedStringInput() { keep(); }
+
+        int scan(TPpToken* ppToken) override
+        {
+            if (input->getCurrentSource() != string)
+                startString();
+            return pp->scanTokenized(*this, *input, string, tokenized.get(), recording.get(), cursor, ppToken);
+        }
+
+    protected:
+        void keep()
+        {
+            if (recording != nullptr)
+                pp->keepTokenized(std::move(recording));
+        }
+        void startString()
+        {
+            keep();
+            tokenized.reset();
+            string = input->getCurrentSource();
+            cursor = 0;
+            if (input->isUserString(string)) {
+                const char* text = input->getString(string);
+                const size_t length = input->getStringLength(string);
+                tokenized = pp->findTokenized(text, length);
+                if (tokenized == nullptr && pp->recordingTokens())
+                    recording.reset(new TokenizedHeader(pp->parseContext.intermediate.getSource(), text, length));
+            }
+        }
+
+        int string;  // the string of 'input' the tokens below are for
+        std::shared_ptr<const TokenizedHeader> tokenized;
+        std::unique_ptr<TokenizedHeader> recording;
+        size_t cursor;
     };
 
     int ScanFromString(char* s);
@@ -711,12 +963,14 @@ protected:
     {
         currentSourceFile = result->headerName;
         includeStack.push(result);
+        guardScans.push_back(TGuardScan(result->headerName, ifdepth));
     }
 
     void pop_include()
     {
         TShader::Includer::IncludeResult* include = includeStack.top();
         includeStack.pop();
+        endGuardScan();
         includer.releaseInclude(include);
         if (includeStack.empty()) {
             currentSourceFile = rootFileName;
@@ -730,11 +984,87 @@ protected:
     std::stack<TShader::Includer::IncludeResult*> includeStack;
     std::string currentSourceFile;
 
+    //
+    // Multiple-include optimization: a header found to be wholly inside
+    // '#ifndef X ... #endif', or to have '#pragma once', is not read again while
+    // X is defined (or at all).
+    //
+
+    // What is known of a header, by its resolved name.
+    struct TIncludeGuard {
+        TIncludeGuard() : macro(0), once(false) { }
+        int macro;    // atom of the guarding macro, or 0
+        bool once;
+    };
+    std::unordered_map<std::string, TIncludeGuard> includeGuards;
+
+    // The resolved names of headers included before, by includeKey()
+    std::unordered_map<std::string, std::string> resolvedIncludes;
+
+    // Looking for the guard of each header being read, in the order of includeStack.
+    // ('#pragma once' goes straight into includeGuards.)
+    enum TGuardState {
+        EGuardStart,      // nothing seen yet
+        EGuardOpening,    // in the #ifndef that may be the guard
+        EGuardInside,     // in (or just past the end of) the guard
+        EGuardNone,       // something outside the guard, or no guard
+    };
+    struct TGuardScan {
+        TGuardScan(const std::string& name, int d) : headerName(name), depth(d), state(EGuardStart), macro(0) { }
+        std::string headerName;
+        int depth;        // ifdepth outside the guard
+        TGuardState state;
+        int macro;
+    };
+    std::vector<TGuardScan> guardScans;
+
+    // True when in a header but outside anything it has #if'd
+    bool atGuardLevel() const { return ! guardScans.empty() && ifdepth == guardScans.back().depth; }
+    // Something other than the guard is outside it
+    void guardMissed()
+    {
+        if (atGuardLevel())
+            guardScans.back().state = EGuardNone;
+    }
+    // A directive 'atom' is starting
+    void guardDirective(int atom);
+    // The #ifndef of 'macro' (or of nothing valid, for 0) has been read
+    void guardIfndef(int macro);
+    // An #else or #elif is next to the innermost #if
+    void guardElse()
+    {
+        if (! guardScans.empty() && ifdepth == guardScans.back().depth + 1)
+            guardScans.back().state = EGuardNone;
+    }
+    void endGuardScan();
+    std::string includeKey(const std::string& headerName, bool local) const;
+    bool includeIsEmpty(const std::string& resolvedName);
+
+    // Where the header names go, when scanning only for dependencies
+    std::vector<std::string>* dependencies;
+
+    // Where tokens scanned are kept, if not with the headers kept across shaders
+    TokenizedTexts* tokenizedTexts;
+    bool keepingTokens() const
+    {
+        return dependencies == nullptr && (tokenizedTexts != nullptr || TokenizedHeader::enabled());
+    }
+    // Whether texts not kept yet are worth recording the tokens of
+    bool recordingTokens() const { return tokenizedTexts == nullptr || tokenizedTexts->keeping(); }
+    std::shared_ptr<const TokenizedHeader> findTokenized(const char* text, size_t length) const;
+    void keepTokenized(std::unique_ptr<TokenizedHeader> text);
+    int scanTokenized(tStringInput&, TInputScanner&, int string, const TokenizedHeader* tokenized,
+                      TokenizedHeader* recording, size_t& cursor, TPpToken*);
+
     std::istringstream strtodStream;
     bool disableEscapeSequences;
     // True if we're skipping a section enclosed by #if/#ifdef/#elif/#else which was evaluated to
     // be inactive, e.g. #if 0
     bool inElseSkip;
+
+    // The pool the shader is compiled into, and whether going over its limit was reported
+    TPoolAllocator& pool;
+    bool overMemoryLimit;
 };
 
 } // end namespace glslang
@@ -84,6 +84,7 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -466,6 +467,16 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
     const auto floatingPointChar = [&](int ch) { return ch == '.' || ch == 'e' || ch == 'E' ||
                                                                      ch == 'f' || ch == 'F' ||
                                                                      ch == 'h' || ch == 'H'; };
+    // Add the rest of a run of 'runClass' characters to the name in one go, when len < MaxTokenLength.
+    const auto nameRun = [&](TInputScanner::TRunClass runClass, const char* tooLong) {
+        const size_t room = MaxTokenLength - len;
+        const size_t run = input->skipRun(runClass, ppToken->name + len, room);
+        len += static_cast<int>(std::min(run, room));
+        if (run > room && ! AlreadyComplained) {
+            pp->parseContext.ppError(ppToken->loc, tooLong, "", "");
+            AlreadyComplained = 1;
+        }
+    };
 
     static const char* const Int64_Extensions[] = {
         E_GL_ARB_gpu_shader_int64,
@@ -484,6 +495,7 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
     for (;;) {
         while (ch == ' ' || ch == '\t') {
             ppToken->space = true;
+            input->skipRun(TInputScanner::ERunBlanks);
             ch = getch();
         }
 
@@ -511,6 +523,7 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
             do {
                 if (len < MaxTokenLength) {
                     ppToken->name[len++] = (char)ch;
+                    nameRun(TInputScanner::ERunIdentifier, "name too long");
                     ch = getch();
                 } else {
                     if (! AlreadyComplained) {
@@ -855,9 +868,10 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
             // can't be hexadecimal or octal, is either decimal or floating point
 
             do {
-                if (len < MaxTokenLength)
+                if (len < MaxTokenLength) {
                     ppToken->name[len++] = (char)ch;
-                else if (! AlreadyComplained) {
+                    nameRun(TInputScanner::ERunDigits, "numeric literal too long");
+                } else if (! AlreadyComplained) {
                     pp->parseContext.ppError(ppToken->loc, "numeric literal too long", "", "");
                     AlreadyComplained = 1;
                 }
@@ -1084,6 +1098,7 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
             if (ch == '/') {
                 pp->inComment = true;
                 do {
+                    input->skipRun(TInputScanner::ERunLineComment);
                     ch = getch();
                 } while (ch != '\n' && ch != EndOfInput);
                 ppToken->space = true;
@@ -1098,6 +1113,7 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
                             pp->parseContext.ppError(ppToken->loc, "End of input in comment", "comment", "");
                             return ch;
                         }
+                        input->skipRun(TInputScanner::ERunBlockComment);
                         ch = getch();
                     }
                     ch = getch();
@@ -1217,6 +1233,63 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
     }
 }
 
+//
+// Move past the rest of the line, through its newline, without forming tokens.
+// Comments and string literals are stepped over as scan() would, so a block
+// comment carries on to later lines, and nothing inside either is taken to
+// end the line.
+//
+bool TPpContext::tStringInput::skipLine()
+{
+    int ch = getch();
+    while (ch != '\n' && ch != EndOfInput) {
+        switch (ch) {
+        case '/':
+            ch = getch();
+            if (ch == '/') {
+                pp->inComment = true;
+                do {
+                    input->skipRun(TInputScanner::ERunLineComment);
+                    ch = getch();
+                } while (ch != '\n' && ch != EndOfInput);
+                pp->inComment = false;
+            } else if (ch == '*') {
+                ch = getch();
+                do {
+                    while (ch != '*' && ch != EndOfInput) {
+                        input->skipRun(TInputScanner::ERunBlockComment);
+                        ch = getch();
+                    }
+                    if (ch != EndOfInput)
+                        ch = getch();
+                } while (ch != '/' && ch != EndOfInput);
+                if (ch == '/')
+                    ch = getch();
+            }
+            break;
+        case '"':
+            ch = getch();
+            while (ch != '"' && ch != '\n' && ch != EndOfInput) {
+                if (ch == '\\' && ! pp->disableEscapeSequences) {
+                    ch = getch();
+                    if (ch == '\n' || ch == EndOfInput)
+                        break;
+                }
+                ch = getch();
+            }
+            if (ch == '"')
+                ch = getch();
+            break;
+        default:
+            input->skipRun(TInputScanner::ERunLineText);
+            ch = getch();
+            break;
+        }
+    }
+
+    return true;
+}
+
 //
 // The main functional entry point into the preprocessor, which will
 // scan the source strings to figure out and return the next processing token.
@@ -1228,9 +1301,16 @@ int TPpContext::tokenize(TPpToken& ppToken)
     for(;;) {
         int token = scanToken(&ppToken);
 
+        // a memoized call's expansion being recorded ends where its input does
+        if (recordingCall != nullptr && recordingEnded)
+            endRecording(true);
+
         // Handle token-pasting logic
         token = tokenPaste(token, ppToken);
 
+        if (recordingCall != nullptr && (recordingEnded || token == EndOfInput || token == '#'))
+            endRecording(false);
+
         if (token == EndOfInput) {
             missingEndifCheck();
             return EndOfInput;
@@ -1252,10 +1332,24 @@ int TPpContext::tokenize(TPpToken& ppToken)
 
         if (token == '\n')
             continue;
+        guardMissed();
+
+        // when only scanning for dependencies, the rest of the line is of no interest
+        if (dependencies != nullptr) {
+            if (inputStack.back()->skipLine())
+                previous_token = '\n';
+            continue;
+        }
 
         // expand macros
         if (token == PpAtomIdentifier) {
-            switch (MacroExpand(&ppToken, false, true)) {
+            MacroExpandResult result = MacroExpand(&ppToken, false, true, true);
+
+            // an expansion that read the tokens after it is not the call's alone
+            if (recordingCall != nullptr && (recordingEnded || result == MacroExpandError))
+                endRecording(false);
+
+            switch (result) {
             case MacroExpandNotStarted:
                 break;
             case MacroExpandError:
@@ -1266,6 +1360,9 @@ int TPpContext::tokenize(TPpToken& ppToken)
             }
         }
 
+        if (recordingCall != nullptr)
+            recordingCall->expansion.putToken(token, &ppToken);
+
         switch (token) {
         case PpAtomIdentifier:
         case PpAtomConstInt:
@@ -86,10 +86,18 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <climits>
 #include <cstdlib>
 #include <cstring>
 #include <cctype>
+#ifndef DISABLE_THREAD_SUPPORT
+#include <mutex>
+#endif
+#include <string_view>
+#include <unordered_map>
 
 #include "PpContext.h"
 #include "PpTokens.h"
@@ -213,4 +221,275 @@ void TPpContext::UngetToken(int token, TPpToken* ppToken)
     pushInput(new tUngotTokenInput(this, token, ppToken));
 }
 
+namespace {
+
+// Headers kept by TokenizedHeader::keep(), by a hash of their text.
+struct TKeptHeader {
+    std::shared_ptr<const TPpContext::TokenizedHeader> header;
+    size_t bytes;
+    unsigned long long lastUse;
+};
+#ifndef DISABLE_THREAD_SUPPORT
+std::mutex KeptHeadersLock;
+#endif
+std::unordered_multimap<size_t, TKeptHeader> KeptHeaders;
+size_t KeptHeaderBytes = 0;
+unsigned long long KeptHeaderUses = 0;
+std::atomic<size_t> KeptHeaderLimit(0);
+
+size_t HashText(const char* text, size_t length)
+{
+    return std::hash<std::string_view>()(std::string_view(text, length));
+}
+
+// Drop the headers used least recently until those left fit in 'limit'.
+// The lock must be held.
+void TrimKeptHeaders(size_t limit)
+{
+    while (KeptHeaderBytes > limit) {
+        auto oldest = KeptHeaders.begin();
+        for (auto it = KeptHeaders.begin(); it != KeptHeaders.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse)
+                oldest = it;
+        }
+        KeptHeaderBytes -= oldest->second.bytes;
+        KeptHeaders.erase(oldest);
+    }
+}
+
+} // end anonymous namespace
+
+void TPpContext::TokenizedHeader::add(size_t entry, size_t end, int atom, const TPpToken& ppToken,
+                                      const TSourceLoc& entryLoc, const TSourceLoc& endLoc)
+{
+    if ((! tokens.empty() && entry <= tokens.back().entry) || end > text.size() || end > UINT_MAX ||
+        ppToken.loc.string != entryLoc.string || ppToken.loc.name != entryLoc.name)
+        return;
+
+    // Escaped newlines, and literals with suffixes, get checked against the version and
+    // extensions as they are scanned (which can look a character past the token), so
+    // must be scanned each time.
+    const char next = end < text.size() ? text[end] : '\n';
+    if (memchr(text.data() + entry, '\\', end - entry) != nullptr || next == '\\')
+        return;
+    switch (atom) {
+    case EndOfInput:
+    case PpAtomConstInt64:
+    case PpAtomConstUint64:
+    case PpAtomConstInt16:
+    case PpAtomConstUint16:
+    case PpAtomConstDouble:
+    case PpAtomConstFloat16:
+        return;
+    case PpAtomConstFloat:
+        if (strpbrk(ppToken.name, "fF#") != nullptr ||
+            next == 'l' || next == 'L' || next == 'h' || next == 'H' || next == '#')
+            return;
+        break;
+    default:
+        break;
+    }
+
+    // The name is what was scanned, just before the end (or its closing quote)
+    const size_t nameLength = strlen(ppToken.name);
+    size_t nameStart = end - std::min(end, nameLength);
+    if (text.compare(nameStart, nameLength, ppToken.name) != 0) {
+        nameStart = nameStart - std::min<size_t>(nameStart, 1);
+        if (text.compare(nameStart, nameLength, ppToken.name) != 0)
+            return;
+    }
+
+    const int lines = ppToken.loc.line - entryLoc.line;
+    const int endLines = endLoc.line - entryLoc.line;
+    if (lines < 0 || lines > UCHAR_MAX || endLines < 0 || endLines > UCHAR_MAX ||
+        ppToken.loc.column < 0 || ppToken.loc.column > USHRT_MAX || endLoc.column < 0 || endLoc.column > USHRT_MAX)
+        return;
+
+    Token token;
+    token.entry = static_cast<unsigned int>(entry);
+    token.end = static_cast<unsigned int>(end);
+    token.nameStart = static_cast<unsigned int>(nameStart);
+    token.nameLength = static_cast<unsigned short>(nameLength);
+    token.atom = static_cast<short>(atom);
+    token.column = static_cast<unsigned short>(ppToken.loc.column);
+    token.endColumn = static_cast<unsigned short>(endLoc.column);
+    token.lines = static_cast<unsigned char>(lines);
+    token.endLines = static_cast<unsigned char>(endLines);
+    token.space = ppToken.space;
+    token.i64val = ppToken.i64val;
+    tokens.push_back(token);
+}
+
+const TPpContext::TokenizedHeader::Token* TPpContext::TokenizedHeader::find(size_t entry, size_t& cursor) const
+{
+    if (cursor < tokens.size() && tokens[cursor].entry == entry)
+        return &tokens[cursor++];
+
+    auto it = std::lower_bound(tokens.begin(), tokens.end(), entry,
+                               [](const Token& token, size_t e) { return token.entry < e; });
+    if (it == tokens.end() || it->entry != entry)
+        return nullptr;
+    cursor = (it - tokens.begin()) + 1;
+
+    return &*it;
+}
+
+size_t TPpContext::TokenizedHeader::getBytes() const
+{
+    return sizeof(*this) + text.size() + tokens.size() * sizeof(Token);
+}
+
+void TPpContext::TokenizedHeader::keep(std::unique_ptr<TokenizedHeader> header)
+{
+    if (header->tokens.empty())
+        return;
+    header->tokens.shrink_to_fit();
+    const size_t bytes = header->getBytes();
+    const size_t hash = HashText(header->text.data(), header->text.size());
+
+#ifndef DISABLE_THREAD_SUPPORT
+    const std::lock_guard<std::mutex> guard(KeptHeadersLock);
+#endif
+
+    const size_t limit = KeptHeaderLimit;
+    if (bytes > limit)
+        return;
+
+    // Another include (on another thread) may have kept the same text meanwhile
+    auto range = KeptHeaders.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.header->source == header->source && it->second.header->text == header->text)
+            return;
+    }
+
+    TrimKeptHeaders(limit - bytes);
+    KeptHeaders.emplace(hash, TKeptHeader{ std::move(header), bytes, ++KeptHeaderUses });
+    KeptHeaderBytes += bytes;
+}
+
+std::shared_ptr<const TPpContext::TokenizedHeader> TPpContext::TokenizedHeader::find(EShSource source,
+                                                                                     const char* text, size_t length)
+{
+    const size_t hash = HashText(text, length);
+
+#ifndef DISABLE_THREAD_SUPPORT
+    const std::lock_guard<std::mutex> guard(KeptHeadersLock);
+#endif
+
+    auto range = KeptHeaders.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const TokenizedHeader& header = *it->second.header;
+        if (header.source == source && header.text.size() == length && memcmp(header.text.data(), text, length) == 0) {
+            it->second.lastUse = ++KeptHeaderUses;
+            return it->second.header;
+        }
+    }
+
+    return nullptr;
+}
+
+void TPpContext::TokenizedHeader::setLimit(size_t bytes)
+{
+#ifndef DISABLE_THREAD_SUPPORT
+    const std::lock_guard<std::mutex> guard(KeptHeadersLock);
+#endif
+    KeptHeaderLimit = bytes;
+    TrimKeptHeaders(bytes);
+}
+
+bool TPpContext::TokenizedHeader::enabled()
+{
+    return KeptHeaderLimit.load(std::memory_order_relaxed) != 0;
+}
+
+std::shared_ptr<const TPpContext::TokenizedHeader> TPpContext::TokenizedTexts::find(EShSource source,
+                                                                                    const char* text, size_t length) const
+{
+    auto range = texts.equal_range(HashText(text, length));
+    for (auto it = range.first; it != range.second; ++it) {
+        const TokenizedHeader& header = *it->second;
+        if (header.source == source && header.text.size() == length && memcmp(header.text.data(), text, length) == 0)
+            return it->second;
+    }
+
+    return nullptr;
+}
+
+void TPpContext::TokenizedTexts::keep(std::unique_ptr<TokenizedHeader> text)
+{
+    if (find(text->source, text->text.data(), text->text.size()) != nullptr)
+        return;
+    const size_t size = text->getBytes();
+    if (size > limit - std::min(limit, bytes))
+        return;
+    const size_t hash = HashText(text->text.data(), text->text.size());
+    texts.emplace(hash, std::move(text));
+    bytes += size;
+}
+
+std::shared_ptr<const TPpContext::TokenizedHeader> TPpContext::findTokenized(const char* text, size_t length) const
+{
+    const EShSource source = parseContext.intermediate.getSource();
+    if (tokenizedTexts != nullptr)
+        return tokenizedTexts->find(source, text, length);
+    else
+        return TokenizedHeader::find(source, text, length);
+}
+
+void TPpContext::keepTokenized(std::unique_ptr<TokenizedHeader> text)
+{
+    if (tokenizedTexts != nullptr)
+        tokenizedTexts->keep(std::move(text));
+    else
+        TokenizedHeader::keep(std::move(text));
+}
+
+// Scan the next token of 'input', replaying it if 'tokenized' (the tokens kept for
+// string 'string' of 'scanner') kept it, or adding it to 'recording'.
+int TPpContext::scanTokenized(tStringInput& input, TInputScanner& scanner, int string,
+                              const TokenizedHeader* tokenized, TokenizedHeader* recording, size_t& cursor,
+                              TPpToken* ppToken)
+{
+    // Only the text itself (not the prologue and epilogue around a header, which vary
+    // by include) is kept, and not while escape sequences are off.
+    if ((tokenized == nullptr && recording == nullptr) || scanner.getCurrentSource() != string ||
+        disableEscapeSequences)
+        return input.tStringInput::scan(ppToken);
+
+    const size_t entry = scanner.getCurrentChar();
+
+    if (tokenized != nullptr) {
+        const TokenizedHeader::Token* token = tokenized->find(entry, cursor);
+        if (token == nullptr)
+            return input.tStringInput::scan(ppToken);
+
+        ppToken->clear();
+        ppToken->space = token->space;
+        ppToken->i64val = token->i64val;
+        memcpy(ppToken->name, tokenized->text.data() + token->nameStart, token->nameLength);
+        ppToken->name[token->nameLength] = '\0';
+        ppToken->loc = scanner.getSourceLoc();
+        ppToken->loc.line += token->lines;
+        ppToken->loc.column = token->column;
+        scanner.skipTo(token->end, token->endLines, token->endColumn);
+
+        return token->atom;
+    }
+
+    const TSourceLoc entryLoc = scanner.getSourceLoc();
+    const size_t messages = parseContext.infoSink.info.getNumMessages();
+    const int atom = input.tStringInput::scan(ppToken);
+
+    // Keep it if scanning it went without complaint (error or warning, so replays
+    // scan it again and say the same) and stopped within the text, or right at its end.
+    if (parseContext.infoSink.info.getNumMessages() == messages) {
+        if (scanner.getCurrentSource() == string)
+            recording->add(entry, scanner.getCurrentChar(), atom, *ppToken, entryLoc, scanner.getSourceLoc());
+        else if (scanner.getCurrentSource() == string + 1 && scanner.getCurrentChar() == 0)
+            recording->add(entry, recording->text.size(), atom, *ppToken, entryLoc, scanner.getSourceLoc());
+    }
+
+    return atom;
+}
+
 } // end namespace glslang
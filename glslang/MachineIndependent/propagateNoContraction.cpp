@@ -231,6 +231,10 @@ ObjectAccessChain getSubAccessChainAfterPrefix(const ObjectAccessChain& chain,
 //  1) A mapping from symbol nodes' IDs to their defining operation nodes.
 //  2) A set of access chains of the initial precise object nodes.
 //
+// It leaves descending into children to the traversal engine, working between
+// them from in- and post-visits, so arbitrarily deep expressions don't
+// deepen the native stack.
+//
 class TSymbolDefinitionCollectingTraverser : public glslang::TIntermTraverser {
 public:
     TSymbolDefinitionCollectingTraverser(NodeMapping* symbol_definition_mapping,
@@ -272,7 +276,7 @@ TSymbolDefinitionCollectingTraverser::TSymbolDefinitionCollectingTraverser(
     NodeMapping* symbol_definition_mapping, AccessChainMapping* accesschain_mapping,
     ObjectAccesschainSet* precise_objects,
     std::unordered_set<glslang::TIntermBranch*>* precise_return_nodes)
-    : TIntermTraverser(true, false, false), symbol_definition_mapping_(*symbol_definition_mapping),
+    : TIntermTraverser(true, true, true), symbol_definition_mapping_(*symbol_definition_mapping),
       precise_objects_(*precise_objects), precise_return_nodes_(*precise_return_nodes),
       current_object_(), accesschain_mapping_(*accesschain_mapping),
       current_function_definition_node_(nullptr) {}
@@ -287,50 +291,52 @@ void TSymbolDefinitionCollectingTraverser::visitSymbol(glslang::TIntermSymbol* n
     accesschain_mapping_[node] = current_object_;
 }
 
-// Visits an aggregate node, traverses all of its children.
-bool TSymbolDefinitionCollectingTraverser::visitAggregate(glslang::TVisit,
+// Visits an aggregate node, clearing the access chain under construction
+// before each of its children.
+bool TSymbolDefinitionCollectingTraverser::visitAggregate(glslang::TVisit visit,
                                                           glslang::TIntermAggregate* node)
 {
     // This aggregate node might be a function definition node, in which case we need to
     // cache this node, so we can get the preciseness information of the return value
-    // of this function later.
-    StateSettingGuard<glslang::TIntermAggregate*> current_function_definition_node_setting_guard(
-        &current_function_definition_node_);
+    // of this function later.  Function definitions don't nest, so there is no
+    // outer one to go back to after it.
     if (node->getOp() == glslang::EOpFunction) {
-        // This is function definition node, we need to cache this node so that we can
-        // get the preciseness of the return value later.
-        current_function_definition_node_setting_guard.setState(node);
+        if (visit == glslang::EvPreVisit)
+            current_function_definition_node_ = node;
+        else if (visit == glslang::EvPostVisit)
+            current_function_definition_node_ = nullptr;
     }
-    // Traverse the items in the sequence.
-    glslang::TIntermSequence& seq = node->getSequence();
-    for (int i = 0; i < (int)seq.size(); ++i) {
+    if (visit != glslang::EvPostVisit)
         current_object_.clear();
-        seq[i]->traverse(this);
-    }
-    return false;
+    return true;
 }
 
-bool TSymbolDefinitionCollectingTraverser::visitBranch(glslang::TVisit,
+bool TSymbolDefinitionCollectingTraverser::visitBranch(glslang::TVisit visit,
                                                        glslang::TIntermBranch* node)
 {
-    if (node->getFlowOp() == glslang::EOpReturn && node->getExpression() &&
+    if (visit == glslang::EvPreVisit && node->getFlowOp() == glslang::EOpReturn && node->getExpression() &&
         current_function_definition_node_ &&
         current_function_definition_node_->getType().getQualifier().noContraction) {
         // This node is a return node with an expression, and its function has a
         // precise return value. We need to find the involved objects in its
         // expression and add them to the set of initial precise objects.
         precise_return_nodes_.insert(node);
-        node->getExpression()->traverse(this);
+        return true;
     }
     return false;
 }
 
 // Visits a unary node. This might be an implicit assignment like i++, i--. etc.
-bool TSymbolDefinitionCollectingTraverser::visitUnary(glslang::TVisit /* visit */,
+bool TSymbolDefinitionCollectingTraverser::visitUnary(glslang::TVisit visit,
                                                       glslang::TIntermUnary* node)
 {
-    current_object_.clear();
-    node->getOperand()->traverse(this);
+    if (visit == glslang::EvPreVisit) {
+        // Traverses the operand node to build the access chain info for the object.
+        current_object_.clear();
+        return true;
+    }
+
+    // Post-visit: the operand node has been traversed.
     if (isAssignOperation(node->getOp())) {
         // We should always be able to get an access chain of the operand node.
         assert(!current_object_.empty());
@@ -356,13 +362,18 @@ bool TSymbolDefinitionCollectingTraverser::visitUnary(glslang::TVisit /* visit *
 
 // Visits a binary node and updates the mapping from symbol IDs to the definition
 // nodes. Also collects the access chains for the initial precise objects.
-bool TSymbolDefinitionCollectingTraverser::visitBinary(glslang::TVisit /* visit */,
+bool TSymbolDefinitionCollectingTraverser::visitBinary(glslang::TVisit visit,
                                                        glslang::TIntermBinary* node)
 {
-    // Traverses the left node to build the access chain info for the object.
-    current_object_.clear();
-    node->getLeft()->traverse(this);
+    if (visit == glslang::EvPreVisit) {
+        // Traverses the left node to build the access chain info for the object.
+        current_object_.clear();
+        return true;
+    }
+    if (visit == glslang::EvPostVisit)
+        return true;
 
+    // In-visit: the left node has been traversed.
     if (isAssignOperation(node->getOp())) {
         // We should always be able to get an access chain for the left node.
         assert(!current_object_.empty());
@@ -385,7 +396,7 @@ bool TSymbolDefinitionCollectingTraverser::visitBinary(glslang::TVisit /* visit
         // Traverses the right node, there may be other 'assignment'
         // operations in the right.
         current_object_.clear();
-        node->getRight()->traverse(this);
+        return true;
 
     } else if (isDereferenceOperation(node->getOp())) {
         // The left node (parent node) is a struct type object. We need to
@@ -400,13 +411,13 @@ bool TSymbolDefinitionCollectingTraverser::visitBinary(glslang::TVisit /* visit
 
         // For a dereference node, there is no need to traverse the right child
         // node as the right node should always be an integer type object.
+        return false;
 
     } else {
         // For other binary nodes, still traverse the right node.
         current_object_.clear();
-        node->getRight()->traverse(this);
+        return true;
     }
-    return false;
 }
 
 // Traverses the AST and returns a tuple of four members:
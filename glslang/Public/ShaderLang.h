@@ -393,6 +393,8 @@ GLSLANG_EXPORT int ShGetUniformLocation(const ShHandle uniformMap, const char* n
 // (treeRoot in TIntermediate) level, and then a full stage can be lowered.
 //
 
+#include <functional>
+#include <iosfwd>
 #include <list>
 #include <string>
 #include <utility>
@@ -425,6 +427,127 @@ GLSLANG_EXPORT bool InitializeProcess();
 // Call once per process to tear down everything
 GLSLANG_EXPORT void FinalizeProcess();
 
+// The configurations that built-in symbol tables are generated and cached for,
+// once per process: a GLSL version and profile (ignored for HLSL), what client's
+// SPIR-V rules apply (EShClientNone for no SPIR-V), and the source language.
+struct TargetTuple {
+    int version;
+    EProfile profile;
+    EShClient client;
+    bool vulkanRulesRelaxed;
+    EShSource source;
+};
+
+// Write the built-in symbol tables for 'target' to 'image', generating them if needed.
+// The image is only valid for this same build of glslang.
+GLSLANG_EXPORT bool SaveBuiltInSymbolTables(const TargetTuple& target, std::vector<unsigned char>& image);
+
+// Install built-in symbol tables from an image written by SaveBuiltInSymbolTables(),
+// so that compiles for its target skip generating and parsing built-ins.
+// Must be called after InitializeProcess().  Returns false for an invalid image,
+// including one from a different build of glslang.
+GLSLANG_EXPORT bool LoadBuiltInSymbolTables(const void* image, size_t size);
+
+// Lazy built-in mode: GLSL built-in symbol tables generated from now on hold only
+// the built-in variables; each compile parses the prototypes of just the built-in
+// functions it looks up, on first use.  This trades a little per-compile work for
+// much faster table generation and much less memory per version/profile kept.
+// Tables already generated (or loaded from an image) are not affected, and tables
+// generated in this mode can't be saved with SaveBuiltInSymbolTables().  Generating
+// still checks that all the prototypes parse; if not, the tables are generated in
+// full instead, so compiles fail the same way as without lazy mode.
+GLSLANG_EXPORT void SetLazyBuiltIns(bool lazy);
+
+// Generate the built-in symbol tables for each of 'targets' now, on up to 'threads'
+// threads (the calling thread included), so that no later compile has to wait for
+// them.  Tables for different targets are built concurrently; each is still only
+// ever built once.  Must be called after InitializeProcess().  Returns false if any
+// target could not be set up, including one with an unknown version.
+GLSLANG_EXPORT bool PrewarmBuiltins(const std::vector<TargetTuple>& targets, int threads);
+
+// Roughly the memory held by built-in symbol tables, in bytes: all of them, or just
+// those for 'target' (0 when they are not currently generated).
+GLSLANG_EXPORT size_t GetBuiltInMemoryUsage();
+GLSLANG_EXPORT size_t GetBuiltInMemoryUsage(const TargetTuple& target);
+
+// Keep the memory held by built-in symbol tables to about 'bytes' (0, the default, for
+// no limit).  When over, the tables of the targets used least recently are freed, to
+// be generated again when next needed.  Tables a compiled TShader (or one compiling)
+// uses are kept until that TShader is destroyed, which can take usage over the limit.
+GLSLANG_EXPORT void SetBuiltInMemoryBudget(size_t bytes);
+
+// Let each thread keep up to 'bytes' of the memory pages freed by TShader and TProgram
+// objects destroyed on it, for the next ones created to reuse instead of going back to
+// the system heap (0, the default, for none).  This helps when one thread compiles
+// many small shaders in turn.  A lower limit trims the calling thread's pages at once,
+// and other threads' as they next free pages.
+GLSLANG_EXPORT void SetPoolPageCacheLimit(size_t bytes);
+
+// Keep up to about 'bytes' of the tokens scanned from #include'd headers, so including
+// the same header text again, in this or any other shader and on any thread, replays
+// them instead of scanning the text again (0, the default, for none).  When over, the
+// headers used least recently are dropped.
+GLSLANG_EXPORT void SetIncludeTokenCacheLimit(size_t bytes);
+
+// Supplies the memory glslang's pools are made of: pages (8KB by default), and blocks
+// for allocations too big for a page.  Both are called from whichever threads are
+// compiling, possibly at the same time.
+class TPageAllocator {
+public:
+    virtual ~TPageAllocator() { }
+
+    // Return 'bytes' of memory aligned as for new[], or nullptr if there is none.
+    virtual void* allocate(size_t bytes) = 0;
+
+    // Take back 'memory', which allocate('bytes') returned.
+    virtual void deallocate(void* memory, size_t bytes) = 0;
+};
+
+// Have pools get their memory from 'allocator' from now on, or from the heap again for
+// nullptr (the default).  Memory always goes back to the allocator it came from, so
+// this can be changed at any time, but an allocator must outlive what it supplied:
+// the TShader and TProgram objects and built-in symbol tables it backs (the latter
+// until FinalizeProcess()), and the default pool of each thread that used glslang
+// while it was set, which is freed when that thread exits.
+GLSLANG_EXPORT void SetPageAllocator(TPageAllocator* allocator);
+
+// The phases of work whose memory use TShader::getMemoryStats() and TProgram::getMemoryStats()
+// break down.  A full parse preprocesses as it goes, so its preprocessing is counted as
+// parsing; EShMemoryPhasePreprocess is TShader::preprocess().  SPIR-V generation is
+// counted by whichever of them owns the linked stage's TIntermediate: the TShader when it
+// was the only one of its stage, otherwise the TProgram.
+typedef enum {
+    EShMemoryPhaseBuiltIns,     // finding the version and setting up built-in symbols
+    EShMemoryPhasePreprocess,
+    EShMemoryPhaseParse,
+    EShMemoryPhaseLink,
+    EShMemoryPhaseMapIO,
+    EShMemoryPhaseSpirv,
+    LAST_ELEMENT_MARKER(EShMemoryPhaseCount),
+} EShMemoryPhase;
+
+// Pool memory use of one phase, summed over each time it ran, except for peakBytes,
+// the most pool memory in use at any time during it.
+struct TMemoryPhaseStats {
+    size_t allocations;
+    size_t bytesAllocated;
+    size_t pagesUsed;
+    size_t peakBytes;
+};
+
+struct TMemoryStats {
+    TMemoryPhaseStats phases[EShMemoryPhaseCount];
+    size_t peakBytes;       // the most of any phase
+};
+
+// The size of a shader's AST, from TShader::getTreeStats().  Types shared by several
+// nodes count once.
+struct TTreeStats {
+    size_t nodes;
+    size_t nodeBytes;
+    size_t typeBytes;
+};
+
 // Resource type for IO resolver
 enum TResourceType {
     EResSampler,
@@ -503,6 +626,12 @@ public:
 #endif
     GLSLANG_EXPORT void setNoStorageFormat(bool useUnknownFormat);
     GLSLANG_EXPORT void setNanMinMaxClamp(bool nanMinMaxClamp);
+    // Stop compiling with an error once this shader holds more than 'bytes' of memory
+    // (0, the default, for no limit).  Going over is noted as memory is taken, and acted
+    // on as the next token is read, at constant folding, and after the parse, so usage
+    // can go over by what one step of that work allocates.  Linking and SPIR-V
+    // generation are not limited.
+    GLSLANG_EXPORT void setMemoryLimit(size_t bytes);
     GLSLANG_EXPORT void setTextureSamplerTransformMode(EShTextureSamplerTransformMode mode);
     GLSLANG_EXPORT void addBlockStorageOverride(const char* nameStr, glslang::TBlockStorageClass backing);
 
@@ -695,16 +824,59 @@ public:
         bool forwardCompatible, EShMessages message, std::string* outputString,
         Includer& includer);
 
+    // Receives preprocessed text in pieces, as it is produced; 'text' is only valid
+    // during the call, and is not null-terminated.
+    typedef std::function<void(const char* text, size_t length)> PreprocessSink;
+
+    // As preprocess(), but streams the output instead of building a string, holding
+    // back only a bounded amount of it at any time.  (Not a preprocess() overload, so
+    // passing nullptr for the output string stays unambiguous.)
+    GLSLANG_EXPORT bool preprocessToSink(
+        const TBuiltInResource* builtInResources, int defaultVersion,
+        EProfile defaultProfile, bool forceDefaultVersionAndProfile,
+        bool forwardCompatible, EShMessages message, const PreprocessSink& sink,
+        Includer& includer);
+    GLSLANG_EXPORT bool preprocess(
+        const TBuiltInResource* builtInResources, int defaultVersion,
+        EProfile defaultProfile, bool forceDefaultVersionAndProfile,
+        bool forwardCompatible, EShMessages message, std::ostream& output,
+        Includer& includer);
+
+    // Lists the headers the shader includes, running only the preprocessor directives
+    // needed to find them, for build systems tracking dependencies.
+    GLSLANG_EXPORT bool scanDependencies(
+        const TBuiltInResource* builtInResources, int defaultVersion,
+        EProfile defaultProfile, bool forceDefaultVersionAndProfile,
+        bool forwardCompatible, EShMessages message, std::vector<std::string>* includedHeaders,
+        Includer& includer);
+
+    // Parses the strings of this shader once for each of 'preambles', as if set by
+    // setPreamble() in turn, into the shader of the same index in 'permutations'.  Each
+    // of those must be of this shader's stage, and is otherwise set up as it would be
+    // for parse(), but for its strings.  The text of the strings and of the headers they
+    // include is scanned just once for all of them, as long as the tokens kept for that
+    // stay within 64MB.  Each permutation gets its own getIntermediate() and
+    // getInfoLog().  Returns true if all of them parsed; if the permutations don't match
+    // 'preambles' or this shader's stage, returns false before parsing any.
+    GLSLANG_EXPORT bool parsePermutations(
+        const TBuiltInResource* builtInResources, int defaultVersion,
+        EProfile defaultProfile, bool forceDefaultVersionAndProfile,
+        bool forwardCompatible, EShMessages message,
+        const std::vector<std::string>& preambles, const std::vector<TShader*>& permutations,
+        Includer& includer);
+
     GLSLANG_EXPORT const char* getInfoLog();
     GLSLANG_EXPORT const char* getInfoDebugLog();
     EShLanguage getStage() const { return stage; }
     TIntermediate* getIntermediate() const { return intermediate; }
+    GLSLANG_EXPORT const TMemoryStats& getMemoryStats() const;
+    GLSLANG_EXPORT TTreeStats getTreeStats() const;
 
 protected:
     TPoolAllocator* pool;
     EShLanguage stage;
     TCompiler* compiler;
-    TIntermediate* intermediate;
+    TIntermediate* intermediate;   // also holds the memory statistics
     TInfoSink* infoSink;
     // strings and lengths follow the standard for glShaderSource:
     //     strings is an array of numStrings pointers to string data.
@@ -888,6 +1060,7 @@ public:
     GLSLANG_EXPORT const char* getInfoDebugLog();
 
     TIntermediate* getIntermediate(EShLanguage stage) const { return intermediate[stage]; }
+    GLSLANG_EXPORT const TMemoryStats& getMemoryStats() const;
 
     // Reflection Interface
 
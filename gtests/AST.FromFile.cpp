@@ -33,9 +33,13 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <tuple>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "TestFixture.h"
+#include "glslang/MachineIndependent/localintermediate.h"
 
 namespace glslangtest {
 namespace {
@@ -44,6 +48,8 @@ using CompileToAstTest = GlslangTest<::testing::TestWithParam<std::string>>;
 
 using CompileToAstTestNV = GlslangTest<::testing::TestWithParam<std::string>>;
 
+using ParsePermutationsTest = GlslangTest<::testing::TestWithParam<std::string>>;
+
 TEST_P(CompileToAstTest, FromFile)
 {
     loadFileCompileAndCheck(GlobalTestSettings.testRoot, GetParam(),
@@ -59,6 +65,138 @@ TEST_P(CompileToAstTestNV, FromFile)
                             Target::AST);
 }
 
+// Parsing a shader's permutations together matches parsing them one at a time.
+TEST_P(ParsePermutationsTest, FromFile)
+{
+    loadFileParsePermutationsAndCheck(GlobalTestSettings.testRoot, GetParam(),
+                                      {"", "#define FOO 1\n", "#define FOO 2\n#define BAR\n", "#define A 3\n"});
+}
+
+// A mismatched permutation is found before any of them is parsed.
+TEST(ParsePermutations, ChecksEveryStageFirst)
+{
+    const char* text = "#version 450\nvoid main() { }\n";
+    glslang::TShader base(EShLangFragment);
+    base.setStrings(&text, 1);
+    glslang::TShader first(EShLangFragment);
+    glslang::TShader second(EShLangVertex);
+    glslang::TShader::ForbidIncluder includer;
+    // Parsing leaves a permutation's pool in use, which goes when the permutation does.
+    glslang::TPoolAllocator& previousAllocator = glslang::GetThreadPoolAllocator();
+
+    EXPECT_FALSE(base.parsePermutations(GetDefaultResources(), 100, ENoProfile, false, false, EShMsgDefault,
+                                        {"", ""}, {&first, &second}, includer));
+    EXPECT_EQ(first.getTreeStats().nodes, 0u);
+    EXPECT_STREQ(first.getInfoLog(), "");
+
+    EXPECT_TRUE(base.parsePermutations(GetDefaultResources(), 100, ENoProfile, false, false, EShMsgDefault,
+                                       {""}, {&first}, includer));
+    glslang::SetThreadPoolAllocator(&previousAllocator);
+    EXPECT_GT(first.getTreeStats().nodes, 0u);
+}
+
+// Logs every visit: the node, the kind of visit, and the traversal depth.
+class TVisitLog : public glslang::TIntermTraverser {
+public:
+    TVisitLog(bool rightToLeft) : TIntermTraverser(true, true, true, rightToLeft) { }
+
+    void visitSymbol(glslang::TIntermSymbol* node) override { log(node, glslang::EvPreVisit); }
+    void visitConstantUnion(glslang::TIntermConstantUnion* node) override { log(node, glslang::EvPreVisit); }
+    bool visitBinary(glslang::TVisit visit, glslang::TIntermBinary* node) override
+    {
+        // Cancel some right operands and post-visits too.
+        return log(node, visit) && (visit != glslang::EvInVisit || node->getOp() != glslang::EOpGreaterThan);
+    }
+    bool visitUnary(glslang::TVisit visit, glslang::TIntermUnary* node) override { return log(node, visit); }
+    bool visitAggregate(glslang::TVisit visit, glslang::TIntermAggregate* node) override { return log(node, visit); }
+    bool visitSelection(glslang::TVisit visit, glslang::TIntermSelection* node) override { return log(node, visit); }
+    bool visitLoop(glslang::TVisit visit, glslang::TIntermLoop* node) override { return log(node, visit); }
+    bool visitBranch(glslang::TVisit visit, glslang::TIntermBranch* node) override { return log(node, visit); }
+    bool visitSwitch(glslang::TVisit visit, glslang::TIntermSwitch* node) override { return log(node, visit); }
+
+    std::vector<std::tuple<const TIntermNode*, int, int>> visits;
+
+private:
+    bool log(const TIntermNode* node, glslang::TVisit visit)
+    {
+        visits.emplace_back(node, visit, depth);
+        return true;
+    }
+};
+
+// Below TIntermTraverser::maxRecursion, the traversal goes on without
+// recursing; it must visit in the same order, with the same depths, as above.
+TEST(Traversal, SameVisitsBelowRecursionLimit)
+{
+    // Nested statements of each kind, around an expression with operators of
+    // each kind, nested much deeper than the limit.
+    std::string code = "#version 450\n"
+                       "layout(location = 0) in float a;\n"
+                       "layout(location = 1) in float b;\n"
+                       "layout(location = 0) out float o;\n"
+                       "float deep() {\n";
+    std::string expression = "a";
+    for (int i = 0; i < 60; ++i) {
+        if (i % 3 == 0)
+            code += "if (a > " + std::to_string(i) + ".0) {\n";
+        else if (i % 3 == 1)
+            code += "for (int i" + std::to_string(i) + " = 0; i" + std::to_string(i) + " < 2; ++i" + std::to_string(i) + ") {\n";
+        else
+            code += "switch (int(b)) { case " + std::to_string(i) + ": {\n";
+    }
+    for (int i = 0; i < 200; ++i) {
+        if (i % 3 == 0)
+            expression = "(" + expression + ") + b";
+        else if (i % 3 == 1)
+            expression = "-(" + expression + ")";
+        else
+            expression = "(b > 0.0 ? " + expression + " : a)";
+    }
+    code += "return " + expression + ";\n";
+    for (int i = 0; i < 60; ++i)
+        code += i % 3 == 1 ? "}\n" : (i % 3 == 2 ? "} }\n" : "}\n");
+    code += "return b;\n}\nvoid main() { o = deep(); }\n";
+
+    const char* text = code.c_str();
+    glslang::TShader shader(EShLangFragment);
+    shader.setStrings(&text, 1);
+    // Parsing leaves the shader's pool in use, which goes when the shader does.
+    glslang::TPoolAllocator& previousAllocator = glslang::GetThreadPoolAllocator();
+    const bool parsed = shader.parse(GetDefaultResources(), 100, false, EShMsgDefault);
+    glslang::SetThreadPoolAllocator(&previousAllocator);
+    ASSERT_TRUE(parsed) << shader.getInfoLog();
+    TIntermNode* root = shader.getIntermediate()->getTreeRoot();
+
+    for (const bool rightToLeft : { false, true }) {
+        TVisitLog whole(rightToLeft);
+        root->traverse(&whole);
+
+        // A negation the whole tree's traversal reaches only without
+        // recursing, which starts out recursing when traversed by itself.
+        size_t start = 0;
+        TIntermNode* subtree = nullptr;
+        for (; start < whole.visits.size(); ++start) {
+            subtree = const_cast<TIntermNode*>(std::get<0>(whole.visits[start]));
+            if (std::get<2>(whole.visits[start]) >= glslang::TIntermTraverser::maxRecursion + 8 &&
+                subtree->getAsUnaryNode() != nullptr && subtree->getAsUnaryNode()->getOp() == glslang::EOpNegative)
+                break;
+        }
+        ASSERT_LT(start, whole.visits.size());
+        const int depth = std::get<2>(whole.visits[start]);
+
+        TVisitLog part(rightToLeft);
+        subtree->traverse(&part);
+        ASSERT_LE(start + part.visits.size(), whole.visits.size());
+        EXPECT_GT(part.visits.size(), (size_t)glslang::TIntermTraverser::maxRecursion);
+        for (size_t v = 0; v < part.visits.size(); ++v) {
+            auto expected = whole.visits[start + v];
+            std::get<2>(expected) -= depth;
+            ASSERT_EQ(part.visits[v], expected) << "visit " << v;
+        }
+        EXPECT_EQ(part.visits.back(), std::make_tuple((const TIntermNode*)subtree, (int)glslang::EvPostVisit, 0));
+    }
+}
+
 // clang-format off
 INSTANTIATE_TEST_SUITE_P(
     Glsl, CompileToAstTest,
@@ -329,6 +467,21 @@ INSTANTIATE_TEST_SUITE_P(
     FileNameAsCustomTestSuffix
 );
 
+INSTANTIATE_TEST_SUITE_P(
+    Glsl, ParsePermutationsTest,
+    ::testing::ValuesIn(std::vector<std::string>({
+        "cppSimple.vert",
+        "cppNest.vert",
+        "cppComplexExpr.vert",
+        "cppDeepNest.frag",
+        "cppMerge.frag",
+        "tokenPaste.vert",
+        "preprocessor.repeated_macro_call.vert",
+        "specExamples.frag",
+    })),
+    FileNameAsCustomTestSuffix
+);
+
 // clang-format on
 
 }  // anonymous namespace
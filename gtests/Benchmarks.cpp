@@ -0,0 +1,222 @@
+//
+// Copyright (C) 2026 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of The Khronos Group Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Microbenchmarks, disabled by default, for checking changes to hot paths.  Run
+// them with --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*, in a
+// release build.  They print their timings, and check only that what they time
+// gives the expected results.
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "glslang/MachineIndependent/ScanContext.h"
+#include "glslang/MachineIndependent/localintermediate.h"
+#include "glslang/Public/ResourceLimits.h"
+#include "glslang/Public/ShaderLang.h"
+#include "Settings.h"
+#include "TestFixture.h"
+
+namespace glslangtest {
+namespace {
+
+// Nanoseconds per call of 'work', called 'count' times a round, over rounds taking
+// about half a second in all.
+template<class Work>
+double NanosecondsPer(size_t count, const Work& work)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t rounds = 0;
+    const Clock::time_point start = Clock::now();
+    Clock::duration elapsed;
+    do {
+        work();
+        ++rounds;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * count);
+}
+
+// GLSL test shaders to take the benchmarks' input from.
+const char* const TestShaders[] = {
+    "sample.frag", "sample.vert", "specExamples.frag", "specExamples.vert", "100.frag", "300.vert",
+    "310.comp", "400.geom", "400.tesc", "400.tese", "410.geom", "420.frag", "430.vert", "440.frag",
+    "450.comp", "460.frag",
+};
+
+std::string ReadTestShader(const char* shader)
+{
+    std::ifstream file(GlobalTestSettings.testRoot + "/" + shader);
+    std::stringstream text;
+    text << file.rdbuf();
+
+    return text.str();
+}
+
+// Every identifier-like word in the test shaders, in order.
+std::vector<std::string> TestShaderWords()
+{
+    std::vector<std::string> words;
+    for (const char* shader : TestShaders) {
+        const std::string source = ReadTestShader(shader);
+        for (size_t c = 0; c < source.size();) {
+            if (isalpha(static_cast<unsigned char>(source[c])) || source[c] == '_') {
+                size_t end = c;
+                while (end < source.size() && (isalnum(static_cast<unsigned char>(source[end])) || source[end] == '_'))
+                    ++end;
+                words.push_back(source.substr(c, end - c));
+                c = end;
+            } else
+                ++c;
+        }
+    }
+
+    return words;
+}
+
+TEST(KeywordTable, FindsKeywordsAndReservedWords)
+{
+    EXPECT_GT(glslang::TScanContext::findKeyword("float"), 0);
+    EXPECT_GT(glslang::TScanContext::findKeyword("sampler2DMSArray"), 0);
+    EXPECT_EQ(glslang::TScanContext::findKeyword("namespace"), -1);
+    EXPECT_EQ(glslang::TScanContext::findKeyword("floats"), 0);
+    EXPECT_EQ(glslang::TScanContext::findKeyword("flo"), 0);
+    EXPECT_EQ(glslang::TScanContext::findKeyword(""), 0);
+}
+
+// The keyword table against a hash map of the same words, looking up every word
+// of the test shaders.
+TEST(Benchmark, DISABLED_KeywordLookup)
+{
+    const std::vector<std::string> words = TestShaderWords();
+    ASSERT_FALSE(words.empty());
+
+    std::unordered_map<std::string, int> map;
+    for (const std::string& word : words) {
+        const int keyword = glslang::TScanContext::findKeyword(word.c_str());
+        if (keyword != 0)
+            map[word] = keyword;
+    }
+
+    int tableSum = 0;
+    const double table = NanosecondsPer(words.size(), [&words, &tableSum]() {
+        for (const std::string& word : words)
+            tableSum += glslang::TScanContext::findKeyword(word.c_str());
+    });
+    int mapSum = 0;
+    const double hashed = NanosecondsPer(words.size(), [&words, &map, &mapSum]() {
+        for (const std::string& word : words) {
+            auto it = map.find(word);
+            mapSum += it == map.end() ? 0 : it->second;
+        }
+    });
+
+    printf("keyword lookup of %zu words: table %.1f ns, unordered_map %.1f ns\n", words.size(), table, hashed);
+    EXPECT_NE(tableSum, 0);
+    EXPECT_NE(mapSum, 0);
+}
+
+// Counts the visits a traversal makes, doing nothing else.
+class TVisitCounter : public glslang::TIntermTraverser {
+public:
+    TVisitCounter(bool inAndPostVisits) : TIntermTraverser(true, inAndPostVisits, inAndPostVisits), visits(0) { }
+
+    void visitSymbol(glslang::TIntermSymbol*) override { ++visits; }
+    void visitConstantUnion(glslang::TIntermConstantUnion*) override { ++visits; }
+    bool visitBinary(glslang::TVisit, glslang::TIntermBinary*) override { return ++visits != 0; }
+    bool visitUnary(glslang::TVisit, glslang::TIntermUnary*) override { return ++visits != 0; }
+    bool visitAggregate(glslang::TVisit, glslang::TIntermAggregate*) override { return ++visits != 0; }
+    bool visitSelection(glslang::TVisit, glslang::TIntermSelection*) override { return ++visits != 0; }
+    bool visitLoop(glslang::TVisit, glslang::TIntermLoop*) override { return ++visits != 0; }
+    bool visitBranch(glslang::TVisit, glslang::TIntermBranch*) override { return ++visits != 0; }
+    bool visitSwitch(glslang::TVisit, glslang::TIntermSwitch*) override { return ++visits != 0; }
+
+    size_t visits;
+};
+
+// Traversing the trees of the test shaders, with pre-visits only, and with
+// pre-, in- and post-visits.
+TEST(Benchmark, DISABLED_Traversal)
+{
+    // Parsing leaves the shader's pool in use, which goes when the shader does.
+    glslang::TPoolAllocator& previousAllocator = glslang::GetThreadPoolAllocator();
+    std::vector<std::unique_ptr<glslang::TShader>> shaders;
+    std::vector<TIntermNode*> roots;
+    for (const char* name : TestShaders) {
+        const std::string source = ReadTestShader(name);
+        const char* text = source.c_str();
+        shaders.emplace_back(new glslang::TShader(GetShaderStage(GetSuffix(name))));
+        shaders.back()->setStrings(&text, 1);
+        shaders.back()->parse(GetDefaultResources(), 100, false, EShMsgDefault);
+        if (shaders.back()->getIntermediate()->getTreeRoot() != nullptr)
+            roots.push_back(shaders.back()->getIntermediate()->getTreeRoot());
+    }
+    glslang::SetThreadPoolAllocator(&previousAllocator);
+    ASSERT_FALSE(roots.empty());
+
+    // Made once, so the rounds don't each allocate their traversal stacks.
+    TVisitCounter preOnly(false);
+    TVisitCounter allVisits(true);
+    const auto traverse = [&roots](TVisitCounter& counter) {
+        for (TIntermNode* root : roots)
+            root->traverse(&counter);
+    };
+    traverse(preOnly);
+    traverse(allVisits);
+    const size_t preVisits = preOnly.visits;
+    const size_t visits = allVisits.visits;
+    ASSERT_GT(preVisits, 0u);
+    ASSERT_GT(visits, preVisits);
+
+    const double pre = NanosecondsPer(preVisits, [&]() { traverse(preOnly); });
+    const double all = NanosecondsPer(visits, [&]() { traverse(allVisits); });
+
+    printf("traversal of %zu trees: %.1f ns per pre-visit, %.1f ns per visit with in- and post-visits\n",
+           roots.size(), pre, all);
+    EXPECT_EQ(preOnly.visits % preVisits, 0u);
+    EXPECT_EQ(allVisits.visits % visits, 0u);
+}
+
+}  // anonymous namespace
+}  // namespace glslangtest
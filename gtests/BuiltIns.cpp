@@ -0,0 +1,457 @@
+//
+// Copyright (C) 2026 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of The Khronos Group Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Tests of the process-wide built-in symbol table machinery.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SPIRV/GlslangToSpv.h"
+#include "glslang/Public/ResourceLimits.h"
+#include "glslang/Public/ShaderLang.h"
+#include "glslang/build_info.h"
+
+namespace glslangtest {
+namespace {
+
+const glslang::TargetTuple Glsl450Vulkan = { 450, ECoreProfile, glslang::EShClientVulkan, false, glslang::EShSourceGlsl };
+
+// Where an image's target starts: just after the build commit string ending its fingerprint.
+size_t TargetOffset(const std::vector<unsigned char>& image)
+{
+    const char* commit = GLSLANG_BUILD_COMMIT;
+    const auto found = std::search(image.begin(), image.end(), commit, commit + strlen(commit));
+    EXPECT_NE(found, image.end());
+
+    return (found - image.begin()) + strlen(commit);
+}
+
+// Counts the memory pools take, to tell compiles that generate built-in tables
+// from those that find them ready.  Never freed, as tables and thread pools it
+// supplied can outlive any test.
+class CountingPageAllocator : public glslang::TPageAllocator {
+public:
+    void* allocate(size_t bytes) override
+    {
+        allocated += bytes;
+        return new (std::nothrow) char[bytes];
+    }
+
+    void deallocate(void* memory, size_t) override { delete[] static_cast<char*>(memory); }
+
+    std::atomic<size_t> allocated{0};
+};
+
+CountingPageAllocator& PageCounter()
+{
+    static CountingPageAllocator* counter = new CountingPageAllocator;
+    return *counter;
+}
+
+const char* const SimpleFragment =
+    "#version 450\n"
+    "layout(location = 0) out vec4 color;\n"
+    "void main() { color = vec4(sin(1.0)); }\n";
+
+// Compile 'text' for Vulkan, as for Glsl450Vulkan, and return how much memory pools took.
+size_t CompileCountingPages(const char* text, bool& compiled)
+{
+    CountingPageAllocator& counter = PageCounter();
+    const size_t before = counter.allocated;
+    glslang::SetPageAllocator(&counter);
+    {
+        glslang::TShader shader(EShLangFragment);
+        shader.setStrings(&text, 1);
+        shader.setEnvInput(glslang::EShSourceGlsl, EShLangFragment, glslang::EShClientVulkan, 100);
+        shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+        shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+        compiled = shader.parse(GetDefaultResources(), 450, false, EShMsgDefault);
+    }
+    glslang::SetPageAllocator(nullptr);
+
+    return counter.allocated - before;
+}
+
+// Compile 'text' as a fragment shader for no client API.
+bool CompileFragment(glslang::TShader& shader, const std::string& text,
+                     const TBuiltInResource& resources = *GetDefaultResources())
+{
+    const char* strings = text.c_str();
+    shader.setStrings(&strings, 1);
+
+    return shader.parse(&resources, 100, false, EShMsgDefault);
+}
+
+// A fragment shader that compiles only if gl_MaxDrawBuffers is 'drawBuffers'.
+std::string FragmentForDrawBuffers(int drawBuffers)
+{
+    return "#version 450\n"
+           "layout(location = 0) out vec4 color[gl_MaxDrawBuffers == " + std::to_string(drawBuffers) + " ? 1 : 0];\n"
+           "void main() { color[0] = vec4(1.0); }\n";
+}
+
+std::string FragmentForVersion(const std::string& version)
+{
+    return "#version " + version + "\n"
+           "precision mediump float;\n"
+           "layout(location = 0) out vec4 color;\n"
+           "void main() { color = vec4(sin(1.0)); }\n";
+}
+
+// Free all built-in tables nothing holds.
+void EvictBuiltIns()
+{
+    glslang::SetBuiltInMemoryBudget(1);
+    glslang::SetBuiltInMemoryBudget(0);
+}
+
+void SetInt(std::vector<unsigned char>& image, size_t offset, unsigned int value)
+{
+    for (int b = 0; b < 4; ++b)
+        image[offset + b] = (value >> (8 * b)) & 0xff;
+}
+
+// Free every built-in table, leaving them as a new process has them.
+void RestartProcess()
+{
+    glslang::FinalizeProcess();
+    glslang::InitializeProcess();
+}
+
+const char* const BuiltInsFragment =
+    "#version 450\n"
+    "layout(binding = 0) uniform sampler2D tex;\n"
+    "layout(location = 0) in vec2 uv;\n"
+    "layout(location = 0) out vec4 color;\n"
+    "void main() { color = mix(texture(tex, uv), vec4(sin(gl_FragCoord.x)), clamp(uv.x, 0.0, 1.0)); }\n";
+
+// Compile and link 'text' as a fragment shader for Vulkan, as for Glsl450Vulkan, to SPIR-V.
+bool CompileFragmentToSpirv(const char* text, std::vector<unsigned int>& spirv)
+{
+    // Parsing and linking leave their own pools in use, which go with the shader and program.
+    glslang::TPoolAllocator& previousAllocator = glslang::GetThreadPoolAllocator();
+    bool compiled;
+    {
+        glslang::TShader shader(EShLangFragment);
+        shader.setStrings(&text, 1);
+        shader.setEnvInput(glslang::EShSourceGlsl, EShLangFragment, glslang::EShClientVulkan, 100);
+        shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+        shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+        glslang::TProgram program;
+        program.addShader(&shader);
+        compiled = shader.parse(GetDefaultResources(), 450, false, EShMsgDefault) && program.link(EShMsgDefault);
+        if (compiled)
+            glslang::GlslangToSpv(*program.getIntermediate(EShLangFragment), spirv);
+    }
+    glslang::SetThreadPoolAllocator(&previousAllocator);
+
+    return compiled;
+}
+
+TEST(BuiltInSymbolTableImage, LoadsOwnImage)
+{
+    RestartProcess();
+    std::vector<unsigned char> image;
+    ASSERT_TRUE(glslang::SaveBuiltInSymbolTables(Glsl450Vulkan, image));
+    const size_t generated = glslang::GetBuiltInMemoryUsage(Glsl450Vulkan);
+    std::vector<unsigned int> expected;
+    ASSERT_TRUE(CompileFragmentToSpirv(BuiltInsFragment, expected));
+    const size_t compileGrowth = glslang::GetBuiltInMemoryUsage(Glsl450Vulkan) - generated;
+
+    // Read the image into no tables at all, as a new process would.
+    RestartProcess();
+    ASSERT_EQ(glslang::GetBuiltInMemoryUsage(Glsl450Vulkan), 0u);
+    ASSERT_TRUE(glslang::LoadBuiltInSymbolTables(image.data(), image.size()));
+    const size_t loaded = glslang::GetBuiltInMemoryUsage(Glsl450Vulkan);
+    EXPECT_GT(loaded, 0u);
+
+    // Compiling uses the tables read, adding only what it adds to generated
+    // ones, for the same result.
+    std::vector<unsigned int> spirv;
+    ASSERT_TRUE(CompileFragmentToSpirv(BuiltInsFragment, spirv));
+    EXPECT_EQ(glslang::GetBuiltInMemoryUsage(Glsl450Vulkan) - loaded, compileGrowth);
+    EXPECT_EQ(spirv, expected);
+}
+
+TEST(BuiltInSymbolTableImage, RejectsTruncatedOrOvercounted)
+{
+    std::vector<unsigned char> image;
+    ASSERT_TRUE(glslang::SaveBuiltInSymbolTables(Glsl450Vulkan, image));
+    const size_t target = TargetOffset(image);
+    RestartProcess();
+
+    for (size_t size : { target + 32, image.size() / 2, image.size() - 1 })
+        EXPECT_FALSE(glslang::LoadBuiltInSymbolTables(image.data(), size)) << size;
+
+    // After the target, whether the general table is there, then its unique ID,
+    // two flags, and level count.
+    std::vector<unsigned char> overcounted = image;
+    SetInt(overcounted, target + 16 + 4 + 8 + 2, 0x7fffffff);
+    EXPECT_FALSE(glslang::LoadBuiltInSymbolTables(overcounted.data(), overcounted.size()));
+
+    EXPECT_EQ(glslang::GetBuiltInMemoryUsage(Glsl450Vulkan), 0u);
+    EXPECT_TRUE(glslang::LoadBuiltInSymbolTables(image.data(), image.size()));
+}
+
+TEST(BuiltInSymbolTableImage, RejectsUnknownProfileOrSource)
+{
+    std::vector<unsigned char> image;
+    ASSERT_TRUE(glslang::SaveBuiltInSymbolTables(Glsl450Vulkan, image));
+    const size_t target = TargetOffset(image);
+
+    // The target is the version index, SPIR-V version index, profile, and source.
+    std::vector<unsigned char> badProfile = image;
+    SetInt(badProfile, target + 8, 3);
+    EXPECT_FALSE(glslang::LoadBuiltInSymbolTables(badProfile.data(), badProfile.size()));
+
+    std::vector<unsigned char> badSource = image;
+    SetInt(badSource, target + 12, glslang::EShSourceCount);
+    EXPECT_FALSE(glslang::LoadBuiltInSymbolTables(badSource.data(), badSource.size()));
+}
+
+TEST(BuiltInSymbolTableImage, RejectsOtherBuild)
+{
+    std::vector<unsigned char> image;
+    ASSERT_TRUE(glslang::SaveBuiltInSymbolTables(Glsl450Vulkan, image));
+    image[TargetOffset(image) - 1] ^= 0x20;
+    EXPECT_FALSE(glslang::LoadBuiltInSymbolTables(image.data(), image.size()));
+}
+
+TEST(PrewarmBuiltins, FirstCompileFindsTablesReady)
+{
+    // A first compile without prewarming generates the tables...
+    EvictBuiltIns();
+    ASSERT_EQ(glslang::GetBuiltInMemoryUsage(Glsl450Vulkan), 0u);
+    bool compiled = false;
+    const size_t cold = CompileCountingPages(SimpleFragment, compiled);
+    EXPECT_TRUE(compiled);
+    EXPECT_GT(glslang::GetBuiltInMemoryUsage(Glsl450Vulkan), 0u);
+
+    // ...while after prewarming, it only takes a small part of that.
+    EvictBuiltIns();
+    ASSERT_TRUE(glslang::PrewarmBuiltins({ Glsl450Vulkan }, 2));
+    const size_t prewarmed = glslang::GetBuiltInMemoryUsage(Glsl450Vulkan);
+    EXPECT_GT(prewarmed, 0u);
+    const size_t warm = CompileCountingPages(SimpleFragment, compiled);
+    EXPECT_TRUE(compiled);
+    EXPECT_LT(warm * 4, cold);
+    EXPECT_GE(glslang::GetBuiltInMemoryUsage(Glsl450Vulkan), prewarmed);
+}
+
+TEST(PrewarmBuiltins, RejectsUnknownVersion)
+{
+    glslang::TargetTuple unknown = Glsl450Vulkan;
+    unknown.version = 451;
+    EXPECT_FALSE(glslang::PrewarmBuiltins({ unknown, Glsl450Vulkan }, 2));
+}
+
+TEST(BuiltInMemoryBudget, EvictsAroundHeldTablesUnderConcurrentCompiles)
+{
+    const glslang::TargetTuple held = { 450, ECoreProfile, glslang::EShClientNone, false, glslang::EShSourceGlsl };
+    const char* const churned[] = { "310 es", "330", "400", "420" };
+
+    // A budget of about one target's tables, for more targets than that.
+    EvictBuiltIns();
+    glslang::TShader heldShader(EShLangFragment);
+    ASSERT_TRUE(CompileFragment(heldShader, FragmentForVersion("450")));
+    const size_t budget = glslang::GetBuiltInMemoryUsage(held) * 3 / 2;
+    ASSERT_GT(budget, 0u);
+    glslang::SetBuiltInMemoryBudget(budget);
+
+    std::atomic<int> failures(0);
+    const auto compileAll = [&](int first) {
+        for (int round = 0; round < 2; ++round) {
+            for (int t = 0; t < 4; ++t) {
+                glslang::TShader shader(EShLangFragment);
+                if (! CompileFragment(shader, FragmentForVersion(churned[(first + t) % 4])))
+                    ++failures;
+            }
+        }
+    };
+    std::thread other(compileAll, 2);
+    compileAll(0);
+    other.join();
+    EXPECT_EQ(failures, 0);
+
+    // Held all along, so never evicted, and still usable.
+    EXPECT_GT(glslang::GetBuiltInMemoryUsage(held), 0u);
+    glslang::TProgram program;
+    program.addShader(&heldShader);
+    EXPECT_TRUE(program.link(EShMsgDefault));
+    EXPECT_TRUE(program.buildReflection());
+    EXPECT_EQ(program.getNumPipeOutputs(), 1);
+
+    glslang::SetBuiltInMemoryBudget(0);
+}
+
+TEST(BuiltInMemoryBudget, FreesTablesNothingHolds)
+{
+    {
+        glslang::TShader shader(EShLangFragment);
+        ASSERT_TRUE(CompileFragment(shader, FragmentForVersion("330")));
+        glslang::SetBuiltInMemoryBudget(1);
+        EXPECT_GT(glslang::GetBuiltInMemoryUsage(), 0u);
+    }
+
+    // Eviction happens as tables are used, or the budget is set.
+    glslang::SetBuiltInMemoryBudget(1);
+    EXPECT_EQ(glslang::GetBuiltInMemoryUsage(), 0u);
+    glslang::SetBuiltInMemoryBudget(0);
+}
+
+TEST(ContextBuiltIns, ReusedOnlyForSameResources)
+{
+    const glslang::TargetTuple target = { 450, ECoreProfile, glslang::EShClientNone, false, glslang::EShSourceGlsl };
+    const int defaultDrawBuffers = GetDefaultResources()->maxDrawBuffers;
+    TBuiltInResource fewerDrawBuffers = *GetDefaultResources();
+    fewerDrawBuffers.maxDrawBuffers = 4;
+
+    EvictBuiltIns();
+    {
+        glslang::TShader shader(EShLangFragment);
+        EXPECT_TRUE(CompileFragment(shader, FragmentForDrawBuffers(defaultDrawBuffers)));
+    }
+    const size_t first = glslang::GetBuiltInMemoryUsage(target);
+    EXPECT_GT(first, 0u);
+
+    // The same resources find the same tables, whatever the starting unique id.
+    for (unsigned long long uniqueId : { 0ull, 1000ull, 2000ull }) {
+        glslang::TShader shader(EShLangFragment);
+        shader.setUniqueId(uniqueId);
+        EXPECT_TRUE(CompileFragment(shader, FragmentForDrawBuffers(defaultDrawBuffers)));
+        EXPECT_EQ(glslang::GetBuiltInMemoryUsage(target), first);
+    }
+
+    // Other resources make tables of their own, built from those resources...
+    {
+        glslang::TShader shader(EShLangFragment);
+        EXPECT_TRUE(CompileFragment(shader, FragmentForDrawBuffers(4), fewerDrawBuffers));
+    }
+    const size_t second = glslang::GetBuiltInMemoryUsage(target);
+    EXPECT_GT(second, first);
+    {
+        glslang::TShader shader(EShLangFragment);
+        EXPECT_FALSE(CompileFragment(shader, FragmentForDrawBuffers(defaultDrawBuffers), fewerDrawBuffers));
+    }
+
+    // ...without disturbing the first ones.
+    {
+        glslang::TShader shader(EShLangFragment);
+        EXPECT_TRUE(CompileFragment(shader, FragmentForDrawBuffers(defaultDrawBuffers)));
+        EXPECT_FALSE(CompileFragment(shader, FragmentForDrawBuffers(4)));
+    }
+    EXPECT_EQ(glslang::GetBuiltInMemoryUsage(target), second);
+}
+
+TEST(ContextBuiltIns, EditsStayWithTheCompile)
+{
+    // Sizing gl_in edits a context-specific built-in; the next compile must not see that.
+    const char* const sizes =
+        "#version 450\n"
+        "layout(triangles) in;\n"
+        "layout(points, max_vertices = 1) out;\n"
+        "void main() { gl_Position = gl_in[2].gl_Position; EmitVertex(); }\n";
+    const char* const unsized =
+        "#version 450\n"
+        "layout(lines) in;\n"
+        "layout(points, max_vertices = 1) out;\n"
+        "void main() { gl_Position = gl_in[1].gl_Position; EmitVertex(); }\n";
+
+    for (const char* text : { sizes, unsized, sizes }) {
+        glslang::TShader shader(EShLangGeometry);
+        shader.setStrings(&text, 1);
+        EXPECT_TRUE(shader.parse(GetDefaultResources(), 100, false, EShMsgDefault)) << shader.getInfoLog();
+    }
+}
+
+// Compile 'text' as for CompileFragment(), putting the thread's pool back after.
+bool CompileFragmentKeepingPool(glslang::TShader& shader, const std::string& text)
+{
+    glslang::TPoolAllocator& previousAllocator = glslang::GetThreadPoolAllocator();
+    const bool compiled = CompileFragment(shader, text);
+    glslang::SetThreadPoolAllocator(&previousAllocator);
+
+    return compiled;
+}
+
+// A user function named like a built-in takes part in selecting overloads for
+// later calls, including ones a built-in overload was selected for before.
+TEST(BuiltInOverloads, SelectedAgainAfterUserOverload)
+{
+    const std::string first = "#version 460\n"
+                              "float first() { return max(1, 2.0); }\n";
+    const std::string second = "float second() { return max(1, 2.0); }\n"
+                               "void main() { }\n";
+
+    glslang::TShader builtInOnly(EShLangFragment);
+    EXPECT_TRUE(CompileFragmentKeepingPool(builtInOnly, first + second)) << builtInOnly.getInfoLog();
+
+    // The call in second() selects max(int, double), whose double result it can't return.
+    glslang::TShader overloaded(EShLangFragment);
+    EXPECT_FALSE(CompileFragmentKeepingPool(overloaded, first + "double max(int a, double b) { return b; }\n" + second));
+    EXPECT_NE(std::string(overloaded.getInfoLog()).find("0:4: 'return' : type does not match"), std::string::npos)
+        << overloaded.getInfoLog();
+}
+
+// Enabling an extension that adds implicit conversions changes the overloads
+// selected for later calls.
+TEST(BuiltInOverloads, SelectedAgainAfterExtensionChange)
+{
+    // Until GL_ARB_gpu_shader5, int doesn't convert to uint, so max(int, uint)
+    // is max(float, float); after, it is max(uint, uint).
+    const std::string before = "#version 150\n"
+                               "#extension GL_ARB_gpu_shader_fp64 : enable\n"
+                               "int i;\n"
+                               "uint u;\n"
+                               "float before() { return max(i, u); }\n";
+    const std::string after = "#extension GL_ARB_gpu_shader5 : enable\n"
+                              "uint after() { return max(i, u); }\n"
+                              "void main() { }\n";
+
+    glslang::TShader beforeOnly(EShLangFragment);
+    EXPECT_TRUE(CompileFragmentKeepingPool(beforeOnly, before + "void main() { }\n")) << beforeOnly.getInfoLog();
+
+    glslang::TShader both(EShLangFragment);
+    EXPECT_TRUE(CompileFragmentKeepingPool(both, before + after)) << both.getInfoLog();
+}
+
+}  // anonymous namespace
+}  // namespace glslangtest
@@ -0,0 +1,169 @@
+//
+// Copyright (C) 2026 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of The Khronos Group Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+
+#include "glslang/Include/PoolAlloc.h"
+#include "glslang/Include/intermediate.h"
+#include "glslang/MachineIndependent/NodeTypes.h"
+
+namespace glslangtest {
+namespace {
+
+using glslang::TNodeTypes;
+using glslang::TNodeTypeScope;
+using glslang::TType;
+
+// Runs the test in a pool of its own, as compiles do.
+class NodeTypes : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        previous = &glslang::GetThreadPoolAllocator();
+        glslang::SetThreadPoolAllocator(&pool);
+        pool.push();
+    }
+    void TearDown() override
+    {
+        pool.pop();
+        glslang::SetThreadPoolAllocator(previous);
+    }
+
+    glslang::TPoolAllocator pool;
+    glslang::TPoolAllocator* previous;
+};
+
+TEST_F(NodeTypes, SharedOnlyWhileInScope)
+{
+    const TType vec4(glslang::EbtFloat, glslang::EvqTemporary, 4);
+    EXPECT_EQ(TNodeTypes::share(vec4), nullptr);
+
+    {
+        TNodeTypes nodeTypes;
+        TNodeTypeScope scope(nodeTypes);
+        EXPECT_NE(TNodeTypes::share(vec4), nullptr);
+    }
+
+    EXPECT_EQ(TNodeTypes::share(vec4), nullptr);
+}
+
+TEST_F(NodeTypes, OneInstancePerDistinctType)
+{
+    TNodeTypes nodeTypes;
+    TNodeTypeScope scope(nodeTypes);
+
+    const TType vec4(glslang::EbtFloat, glslang::EvqTemporary, 4);
+    const TType sameVec4(glslang::EbtFloat, glslang::EvqTemporary, 4);
+    const TType* shared = TNodeTypes::share(vec4);
+    ASSERT_NE(shared, nullptr);
+    EXPECT_NE(shared, &vec4);
+    EXPECT_TRUE(shared->isShallowCopyOf(vec4));
+    EXPECT_EQ(TNodeTypes::share(sameVec4), shared);
+    EXPECT_EQ(TNodeTypes::share(*shared), shared);
+    EXPECT_EQ(nodeTypes.size(), 1u);
+
+    // Anything a shallow copy would keep tells types apart, qualification included.
+    const TType vec3(glslang::EbtFloat, glslang::EvqTemporary, 3);
+    const TType constVec4(glslang::EbtFloat, glslang::EvqConst, 4);
+    const TType ivec4(glslang::EbtInt, glslang::EvqTemporary, 4);
+    EXPECT_NE(TNodeTypes::share(vec3), shared);
+    EXPECT_NE(TNodeTypes::share(constVec4), shared);
+    EXPECT_NE(TNodeTypes::share(ivec4), shared);
+    EXPECT_EQ(nodeTypes.size(), 4u);
+}
+
+TEST_F(NodeTypes, InnerScopeTakesOverUntilItEnds)
+{
+    const TType vec2(glslang::EbtFloat, glslang::EvqTemporary, 2);
+    TNodeTypes outer;
+    TNodeTypeScope outerScope(outer);
+    const TType* fromOuter = TNodeTypes::share(vec2);
+
+    {
+        TNodeTypes inner;
+        TNodeTypeScope innerScope(inner);
+        const TType* fromInner = TNodeTypes::share(vec2);
+        EXPECT_NE(fromInner, fromOuter);
+        EXPECT_EQ(inner.size(), 1u);
+    }
+
+    EXPECT_EQ(TNodeTypes::share(vec2), fromOuter);
+    EXPECT_EQ(outer.size(), 1u);
+}
+
+TEST_F(NodeTypes, NotSharedFromAnotherPool)
+{
+    const TType vec4(glslang::EbtFloat, glslang::EvqTemporary, 4);
+    TNodeTypes nodeTypes;
+    TNodeTypeScope scope(nodeTypes);
+
+    // The shared types live in the pool the table was made with.
+    glslang::TPoolAllocator otherPool;
+    glslang::SetThreadPoolAllocator(&otherPool);
+    EXPECT_EQ(TNodeTypes::share(vec4), nullptr);
+    glslang::SetThreadPoolAllocator(&pool);
+    EXPECT_NE(TNodeTypes::share(vec4), nullptr);
+}
+
+TEST_F(NodeTypes, NodesShareUntilWrittenTo)
+{
+    TNodeTypes nodeTypes;
+    TNodeTypeScope scope(nodeTypes);
+
+    const TType vec4(glslang::EbtFloat, glslang::EvqTemporary, 4);
+    glslang::TIntermSymbol* a = new glslang::TIntermSymbol(1, "a", EShLangVertex, vec4);
+    glslang::TIntermSymbol* b = new glslang::TIntermSymbol(2, "b", EShLangVertex, vec4);
+    EXPECT_EQ(&a->getType(), &b->getType());
+    EXPECT_EQ(&a->getType(), TNodeTypes::share(vec4));
+
+    // Writing through the non-const qualifier gives 'a' a type of its own.
+    a->getQualifier().precision = glslang::EpqHigh;
+    EXPECT_NE(&a->getType(), &b->getType());
+    EXPECT_EQ(a->getType().getQualifier().precision, glslang::EpqHigh);
+    EXPECT_EQ(b->getType().getQualifier().precision, glslang::EpqNone);
+    EXPECT_EQ(&b->getType(), TNodeTypes::share(vec4));
+
+    // setPrecision() moves to the shared type for the result instead.
+    b->setPrecision(glslang::EpqMedium);
+    EXPECT_EQ(b->getType().getQualifier().precision, glslang::EpqMedium);
+    glslang::TIntermSymbol* c = new glslang::TIntermSymbol(3, "c", EShLangVertex, vec4);
+    c->setPrecision(glslang::EpqMedium);
+    EXPECT_EQ(&b->getType(), &c->getType());
+    EXPECT_EQ(c->getType().getQualifier().precision, glslang::EpqMedium);
+    EXPECT_EQ(a->getType().getQualifier().precision, glslang::EpqHigh);
+}
+
+}  // anonymous namespace
+}  // namespace glslangtest
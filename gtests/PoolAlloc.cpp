@@ -0,0 +1,300 @@
+//
+// Copyright (C) 2026 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of The Khronos Group Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SPIRV/GlslangToSpv.h"
+#include "glslang/Include/PoolAlloc.h"
+#include "glslang/Include/glslang_c_interface.h"
+#include "glslang/Public/ResourceLimits.h"
+#include "glslang/Public/ShaderLang.h"
+#include "glslang/Public/resource_limits_c.h"
+
+namespace glslangtest {
+namespace {
+
+using glslang::TPoolAllocator;
+
+// Make a pool take about 'bytes' in pages, then destroy it, giving the pages up.
+void UsePool(size_t bytes)
+{
+    TPoolAllocator pool;
+    for (size_t allocated = 0; allocated < bytes; allocated += 256)
+        pool.allocate(256);
+}
+
+TEST(PoolPageCache, ReusesPagesOfDestroyedPools)
+{
+    TPoolAllocator::setPageCacheLimit(0);
+    TPoolAllocator::setPageCacheLimit(1024 * 1024);
+
+    UsePool(64 * 1024);
+    const size_t kept = TPoolAllocator::getPageCacheBytes();
+    EXPECT_GT(kept, 0u);
+
+    {
+        TPoolAllocator pool;
+        pool.allocate(256);
+        EXPECT_LT(TPoolAllocator::getPageCacheBytes(), kept);
+    }
+    EXPECT_EQ(TPoolAllocator::getPageCacheBytes(), kept);
+
+    TPoolAllocator::setPageCacheLimit(0);
+    EXPECT_EQ(TPoolAllocator::getPageCacheBytes(), 0u);
+}
+
+TEST(PoolPageCache, KeepsNoMoreThanTheLimit)
+{
+    TPoolAllocator::setPageCacheLimit(0);
+    UsePool(64 * 1024);
+    EXPECT_EQ(TPoolAllocator::getPageCacheBytes(), 0u);
+
+    const size_t limit = 32 * 1024;
+    TPoolAllocator::setPageCacheLimit(limit);
+    UsePool(256 * 1024);
+    EXPECT_GT(TPoolAllocator::getPageCacheBytes(), 0u);
+    EXPECT_LE(TPoolAllocator::getPageCacheBytes(), limit);
+
+    // A limit lowered on another thread applies here once a pool next gives up pages.
+    TPoolAllocator::setPageCacheLimit(256 * 1024);
+    UsePool(256 * 1024);
+    EXPECT_GT(TPoolAllocator::getPageCacheBytes(), limit);
+    std::thread([limit]() { TPoolAllocator::setPageCacheLimit(limit); }).join();
+    UsePool(1);
+    EXPECT_LE(TPoolAllocator::getPageCacheBytes(), limit);
+
+    TPoolAllocator::setPageCacheLimit(0);
+}
+
+TEST(PoolPageCache, FreedAtThreadExit)
+{
+    // The thread's default pool gives up its pages as the thread exits, possibly
+    // after the cache was freed; either way, nothing may be left behind.
+    TPoolAllocator::setPageCacheLimit(1024 * 1024);
+    size_t kept = 0;
+    std::thread([&kept]() {
+        glslang::GetThreadPoolAllocator().allocate(64 * 1024);
+        UsePool(64 * 1024);
+        kept = TPoolAllocator::getPageCacheBytes();
+    }).join();
+    EXPECT_GT(kept, 0u);
+
+    TPoolAllocator::setPageCacheLimit(0);
+}
+
+TEST(PoolMemoryLimit, StaysOverOnceOver)
+{
+    TPoolAllocator pool;
+    pool.setLimit(64 * 1024);
+    pool.push();
+    for (int allocation = 0; allocation < 1024; ++allocation)
+        pool.allocate(256);
+    EXPECT_TRUE(pool.isOverLimit());
+
+    // Giving the pages back doesn't undo it; only setting the limit again does.
+    pool.pop();
+    EXPECT_LT(pool.getBytesInUse(), 64u * 1024);
+    EXPECT_TRUE(pool.isOverLimit());
+    pool.setLimit(64 * 1024);
+    EXPECT_FALSE(pool.isOverLimit());
+}
+
+// A fragment shader of 'statements' statements.
+std::string FragmentOfSize(int statements)
+{
+    std::string text = "#version 450\n"
+                       "layout(location = 0) out vec4 color;\n"
+                       "void main() {\n"
+                       "    color = vec4(0.0);\n";
+    for (int s = 0; s < statements; ++s)
+        text += "    color += vec4(sin(color.x), " + std::to_string(s) + ".0, color.yz);\n";
+
+    return text + "}\n";
+}
+
+bool CompileFragment(glslang::TShader& shader, const std::string& text)
+{
+    const char* strings = text.c_str();
+    shader.setStrings(&strings, 1);
+
+    return shader.parse(GetDefaultResources(), 100, false, EShMsgDefault);
+}
+
+TEST(MemoryStats, CountsEachPhaseWhereItRan)
+{
+    glslang::TShader shader(EShLangFragment);
+    ASSERT_TRUE(CompileFragment(shader, FragmentOfSize(10)));
+    const glslang::TMemoryStats& stats = shader.getMemoryStats();
+
+    const glslang::TMemoryPhaseStats& parse = stats.phases[glslang::EShMemoryPhaseParse];
+    EXPECT_GT(parse.allocations, 0u);
+    EXPECT_GE(parse.bytesAllocated, parse.allocations);
+    EXPECT_GT(parse.peakBytes, 0u);
+    EXPECT_GT(stats.phases[glslang::EShMemoryPhaseBuiltIns].allocations, 0u);
+    EXPECT_EQ(stats.phases[glslang::EShMemoryPhasePreprocess].allocations, 0u);
+    EXPECT_EQ(stats.phases[glslang::EShMemoryPhaseSpirv].allocations, 0u);
+    for (int phase = 0; phase < glslang::EShMemoryPhaseCount; ++phase)
+        EXPECT_LE(stats.phases[phase].peakBytes, stats.peakBytes);
+
+    // The only shader of its stage, so SPIR-V generation counts against the shader.
+    glslang::TProgram program;
+    program.addShader(&shader);
+    ASSERT_TRUE(program.link(EShMsgDefault));
+    EXPECT_GT(program.getMemoryStats().phases[glslang::EShMemoryPhaseLink].allocations, 0u);
+    std::vector<unsigned int> spirv;
+    glslang::GlslangToSpv(*program.getIntermediate(EShLangFragment), spirv);
+    EXPECT_GT(stats.phases[glslang::EShMemoryPhaseSpirv].allocations, 0u);
+    EXPECT_EQ(program.getMemoryStats().phases[glslang::EShMemoryPhaseSpirv].allocations, 0u);
+}
+
+TEST(MemoryStats, GrowWithTheShader)
+{
+    glslang::TShader small(EShLangFragment);
+    ASSERT_TRUE(CompileFragment(small, FragmentOfSize(10)));
+    glslang::TShader large(EShLangFragment);
+    ASSERT_TRUE(CompileFragment(large, FragmentOfSize(1000)));
+
+    const glslang::TMemoryPhaseStats& smallParse = small.getMemoryStats().phases[glslang::EShMemoryPhaseParse];
+    const glslang::TMemoryPhaseStats& largeParse = large.getMemoryStats().phases[glslang::EShMemoryPhaseParse];
+    EXPECT_GT(largeParse.allocations, smallParse.allocations * 10);
+    EXPECT_GT(largeParse.bytesAllocated, smallParse.bytesAllocated * 10);
+    EXPECT_GT(largeParse.pagesUsed, smallParse.pagesUsed);
+    EXPECT_GT(largeParse.peakBytes, smallParse.peakBytes);
+}
+
+TEST(ShaderMemoryLimit, StopsConstantFoldingCleanly)
+{
+    // Each line folds a constructor of 1024 constants.
+    std::string text = "#version 450\n"
+                       "#define A4(x) x, x, x, x\n"
+                       "#define A64(x) A4(A4(A4(x)))\n"
+                       "#define A1024(x) A4(A4(A64(x)))\n";
+    for (int c = 0; c < 64; ++c)
+        text += "const float c" + std::to_string(c) + "[1024] = float[1024](A1024(1.5));\n";
+    text += "layout(location = 0) out vec4 color;\n"
+            "void main() { color = vec4(c0[1] + c63[1023]); }\n";
+
+    const size_t limit = 1024 * 1024;
+    glslang::TShader unlimited(EShLangFragment);
+    ASSERT_TRUE(CompileFragment(unlimited, text)) << unlimited.getInfoLog();
+    ASSERT_GT(unlimited.getMemoryStats().phases[glslang::EShMemoryPhaseParse].peakBytes, 4 * limit);
+
+    glslang::TShader limited(EShLangFragment);
+    limited.setMemoryLimit(limit);
+    EXPECT_FALSE(CompileFragment(limited, text));
+    EXPECT_NE(std::string(limited.getInfoLog()).find("shader memory limit exceeded"), std::string::npos);
+    EXPECT_LT(limited.getMemoryStats().phases[glslang::EShMemoryPhaseParse].peakBytes, limit + limit / 2);
+}
+
+// Page allocator callbacks counting the blocks they have out.
+struct TCountedBlocks {
+    std::atomic<long> outstanding{0};
+    std::atomic<long> supplied{0};
+};
+
+void* AllocateCounted(void* ctx, size_t size)
+{
+    ++static_cast<TCountedBlocks*>(ctx)->outstanding;
+    ++static_cast<TCountedBlocks*>(ctx)->supplied;
+    return new (std::nothrow) char[size];
+}
+
+void DeallocateCounted(void* ctx, void* memory, size_t)
+{
+    --static_cast<TCountedBlocks*>(ctx)->outstanding;
+    delete[] static_cast<char*>(memory);
+}
+
+// Compile and link 'text' through the C interface.
+bool CompileAndLinkFromC(const std::string& text)
+{
+    glslang_input_t input = {};
+    input.language = GLSLANG_SOURCE_GLSL;
+    input.stage = GLSLANG_STAGE_FRAGMENT;
+    input.client = GLSLANG_CLIENT_NONE;
+    input.target_language = GLSLANG_TARGET_NONE;
+    input.code = text.c_str();
+    input.default_version = 100;
+    input.default_profile = GLSLANG_NO_PROFILE;
+    input.messages = GLSLANG_MSG_DEFAULT_BIT;
+    input.resource = glslang_default_resource();
+
+    glslang_shader_t* shader = glslang_shader_create(&input);
+    glslang_program_t* program = glslang_program_create();
+    bool linked = glslang_shader_preprocess(shader, &input) && glslang_shader_parse(shader, &input);
+    if (linked) {
+        glslang_program_add_shader(program, shader);
+        linked = glslang_program_link(program, GLSLANG_MSG_DEFAULT_BIT);
+    }
+
+    // Uninstalled before these are deleted, to leave them the last users of it.
+    glslang_set_page_allocator(nullptr);
+    glslang_program_delete(program);
+    glslang_shader_delete(shader);
+
+    return linked;
+}
+
+TEST(CPageAllocator, EverythingSuppliedComesBack)
+{
+    // The built-in tables are made first, so they don't come from the callbacks.
+    const std::string text = FragmentOfSize(10);
+    ASSERT_TRUE(CompileAndLinkFromC(text));
+
+    // Each set of callbacks, with the shader and program using it, and the thread's
+    // default pool, is done with by the end of the thread.
+    TCountedBlocks counts[3];
+    std::thread([&counts, &text]() {
+        for (TCountedBlocks& count : counts) {
+            glslang_page_allocator_t allocator = { AllocateCounted, DeallocateCounted, &count };
+            glslang_set_page_allocator(&allocator);
+            EXPECT_TRUE(CompileAndLinkFromC(text));
+        }
+    }).join();
+
+    for (const TCountedBlocks& count : counts) {
+        EXPECT_GT(count.supplied, 0);
+        EXPECT_EQ(count.outstanding, 0);
+    }
+}
+
+}  // anonymous namespace
+}  // namespace glslangtest
@@ -67,6 +67,8 @@ INSTANTIATE_TEST_SUITE_P(
         "preprocessor.defined.vert",
         "preprocessor.many.endif.vert",
         "preprocessor.eof_missing.vert",
+        "preprocessor.repeated_macro_call.vert",
+        "preprocessor.repeated_macro_call_errors.vert",
         "preprocess.arb_shading_language_include.vert",
         "preprocess.include_directive_missing_extension.vert",
         "preprocess.inactive_stringify.vert"
@@ -75,5 +77,108 @@ INSTANTIATE_TEST_SUITE_P(
 );
 // clang-format on
 
+TEST(PreprocessToSink, StreamsLargeOutputInBoundedPieces)
+{
+    std::string text = "#version 450\n#define SCALE(x) (x * 2.0 + 1.0)\n";
+    for (int line = 0; line < 20000; ++line)
+        text += "float f" + std::to_string(line) + " = SCALE(" + std::to_string(line) + ".5);\n";
+    const char* strings = text.c_str();
+    glslang::TShader::ForbidIncluder includer;
+
+    glslang::TShader whole(EShLangFragment);
+    whole.setStrings(&strings, 1);
+    std::string output;
+    ASSERT_TRUE(whole.preprocess(GetDefaultResources(), 100, ENoProfile, false, false, EShMsgOnlyPreprocessor,
+                                 &output, includer));
+    ASSERT_GT(output.size(), 512u * 1024);
+
+    // The output comes in many pieces, each no bigger than the 64KB the preprocessor
+    // holds back, plus what one token adds.
+    glslang::TShader streamed(EShLangFragment);
+    streamed.setStrings(&strings, 1);
+    std::vector<size_t> pieces;
+    std::string joined;
+    ASSERT_TRUE(streamed.preprocessToSink(GetDefaultResources(), 100, ENoProfile, false, false,
+                                          EShMsgOnlyPreprocessor,
+                                          [&pieces, &joined](const char* piece, size_t length) {
+                                              pieces.push_back(length);
+                                              joined.append(piece, length);
+                                          },
+                                          includer));
+    EXPECT_EQ(output, joined);
+    EXPECT_GE(pieces.size(), output.size() / (64 * 1024));
+    for (size_t length : pieces)
+        EXPECT_LE(length, 64u * 1024 + 1024);
+
+    // So does writing to a stream.
+    glslang::TShader written(EShLangFragment);
+    written.setStrings(&strings, 1);
+    std::ostringstream stream;
+    ASSERT_TRUE(written.preprocess(GetDefaultResources(), 100, ENoProfile, false, false, EShMsgOnlyPreprocessor,
+                                   stream, includer));
+    EXPECT_EQ(output, stream.str());
+}
+
+// Includes one header, from memory, whatever name is asked for.
+class HeaderIncluder : public glslang::TShader::Includer {
+public:
+    explicit HeaderIncluder(const std::string& text) : text(text) { }
+
+    IncludeResult* includeLocal(const char* headerName, const char*, size_t) override
+    {
+        return new IncludeResult(headerName, text.data(), text.size(), nullptr);
+    }
+    void releaseInclude(IncludeResult* result) override { delete result; }
+
+private:
+    const std::string text;
+};
+
+// The preprocessed text and info log of 'text', including 'header'.
+std::string PreprocessWithHeader(const std::string& text, const std::string& header)
+{
+    const char* strings = text.c_str();
+    glslang::TShader shader(EShLangFragment);
+    shader.setStrings(&strings, 1);
+    HeaderIncluder includer(header);
+    std::string output;
+    shader.preprocess(GetDefaultResources(), 100, ENoProfile, false, false, EShMsgOnlyPreprocessor, &output,
+                      includer);
+
+    return output + shader.getInfoLog();
+}
+
+TEST(IncludeTokenCache, ReplaysTheSameOutputAndDiagnostics)
+{
+    const std::string header = "float h0 = 1.5 + 2.0 * 3; // comment\n"
+                               "int64_t h1 = 5l;\n"
+                               "int h2 = 09 + 0x1u;\n"
+                               "uint h3 = 4294967296u;\n"
+                               "/* a comment\n"
+                               "   over lines */ vec2 h4 = vec2(.5e2,\n"
+                               "    1e-3);\n";
+    const std::string text = "#version 450\n"
+                             "#extension GL_ARB_gpu_shader_int64 : warn\n"
+                             "#extension GL_GOOGLE_include_directive : require\n"
+                             "#include \"h.glsl\"\n"
+                             "float between;\n"
+                             "#include \"h.glsl\"\n"
+                             "void main() { }\n";
+
+    const std::string scanned = PreprocessWithHeader(text, header);
+    ASSERT_NE(scanned.find("WARNING"), std::string::npos) << scanned;
+    ASSERT_NE(scanned.find("ERROR"), std::string::npos) << scanned;
+
+    // Once to keep the header's tokens (and replay them for the second include), once more
+    // to replay them all.
+    glslang::SetIncludeTokenCacheLimit(1024 * 1024);
+    const std::string kept = PreprocessWithHeader(text, header);
+    const std::string replayed = PreprocessWithHeader(text, header);
+    glslang::SetIncludeTokenCacheLimit(0);
+
+    EXPECT_EQ(scanned, kept);
+    EXPECT_EQ(scanned, replayed);
+}
+
 }  // anonymous namespace
 }  // namespace glslangtest
@@ -83,6 +83,7 @@ using CompileVulkanToSpirv14TestNV = GlslangTest<::testing::TestWithParam<std::s
 using CompileUpgradeTextureToSampledTextureAndDropSamplersTest = GlslangTest<::testing::TestWithParam<std::string>>;
 using GlslSpirvDebugInfoTest = GlslangTest<::testing::TestWithParam<std::string>>;
 using GlslNonSemanticShaderDebugInfoTest = GlslangTest<::testing::TestWithParam<std::string>>;
+using CompileDeepTreeToSpirvTest = GlslangTest<::testing::Test>;
 
 // Compiling GLSL to SPIR-V under Vulkan semantics. Expected to successfully
 // generate SPIR-V.
@@ -261,6 +262,27 @@ TEST_P(GlslNonSemanticShaderDebugInfoTest, FromFile)
                             "/baseResults/", false, true, true);
 }
 
+// A long chain of operations makes a very deep tree, which traversing must
+// not need a native stack frame per level for.
+TEST_F(CompileDeepTreeToSpirvTest, LongExpression)
+{
+    std::string code = "#version 450\n"
+                       "layout(location = 0) in float a;\n"
+                       "layout(location = 0) out float o;\n"
+                       "void main() {\n"
+                       "    o = a";
+    for (int i = 0; i < 50000; ++i)
+        code += " + a";
+    code += ";\n}\n";
+
+    GlslangResult result = compileAndLink("deepTree.frag", code, "main",
+                                          DeriveOptions(Source::GLSL, Semantics::Vulkan, Target::Spv),
+                                          glslang::EShTargetVulkan_1_0, glslang::EShTargetSpv_1_0);
+    EXPECT_EQ("", result.shaderResults.front().output);
+    EXPECT_EQ("", result.linkingError);
+    EXPECT_NE(std::string::npos, result.spirv.find(" FAdd "));
+}
+
 // clang-format off
 INSTANTIATE_TEST_SUITE_P(
     Glsl, CompileVulkanToSpirvTest,
@@ -701,6 +701,25 @@ public:
 
         std::string log = shader.getInfoLog();
         log += shader.getInfoDebugLog();
+
+        // Streaming the output gives the same text, in pieces no bigger than the
+        // preprocessor's flush size (64KB), plus what one token adds.
+        glslang::TShader streamShader(EShLangVertex);
+        streamShader.setStringsWithLengths(&shaderStrings, &shaderLengths, 1);
+        std::string streamed;
+        size_t largestPiece = 0;
+        const bool streamSuccess = streamShader.preprocessToSink(
+            GetDefaultResources(), defaultVersion, defaultProfile, forceVersionProfile, isForwardCompatible,
+            (EShMessages)(EShMsgOnlyPreprocessor | EShMsgCascadingErrors),
+            [&streamed, &largestPiece](const char* text, size_t length) {
+                streamed.append(text, length);
+                largestPiece = std::max(largestPiece, length);
+            },
+            includer);
+        EXPECT_EQ(success, streamSuccess);
+        EXPECT_EQ(ppShader, streamed);
+        EXPECT_LE(largestPiece, 64u * 1024 + 1024);
+
         if (success) {
             return std::make_tuple(true, ppShader, log);
         } else {
@@ -708,6 +727,46 @@ public:
         }
     }
 
+    // Parses the given test file under each of |preambles| with
+    // TShader::parsePermutations(), and checks each permutation has the same
+    // AST and messages as parsing it by itself does.
+    void loadFileParsePermutationsAndCheck(const std::string& testDir,
+                                           const std::string& testName,
+                                           const std::vector<std::string>& preambles)
+    {
+        std::string input;
+        tryLoadFile(testDir + "/" + testName, "input", &input);
+        const char* shaderStrings = input.data();
+        const int shaderLengths = static_cast<int>(input.size());
+        const EShLanguage stage = GetShaderStage(GetSuffix(testName));
+        const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+        glslang::TShader::ForbidIncluder includer;
+
+        glslang::TShader base(stage);
+        base.setStringsWithLengths(&shaderStrings, &shaderLengths, 1);
+        std::vector<std::unique_ptr<glslang::TShader>> permutations;
+        std::vector<glslang::TShader*> shaders;
+        for (size_t p = 0; p < preambles.size(); ++p) {
+            permutations.emplace_back(new glslang::TShader(stage));
+            shaders.push_back(permutations.back().get());
+        }
+        const bool success = base.parsePermutations(
+            GetDefaultResources(), defaultVersion, defaultProfile, forceVersionProfile, isForwardCompatible,
+            controls, preambles, shaders, includer);
+
+        bool allSuccess = true;
+        for (size_t p = 0; p < preambles.size(); ++p) {
+            glslang::TShader shader(stage);
+            shader.setStringsWithLengths(&shaderStrings, &shaderLengths, 1);
+            shader.setPreamble(preambles[p].c_str());
+            allSuccess = shader.parse(GetDefaultResources(), defaultVersion, defaultProfile, forceVersionProfile,
+                                      isForwardCompatible, controls, includer) && allSuccess;
+            EXPECT_EQ(std::string(shader.getInfoLog()), permutations[p]->getInfoLog()) << "preamble: " << preambles[p];
+            EXPECT_EQ(std::string(shader.getInfoDebugLog()), permutations[p]->getInfoDebugLog());
+        }
+        EXPECT_EQ(allSuccess, success);
+    }
+
     void loadFilePreprocessAndCheck(const std::string& testDir,
                                     const std::string& testName)
     {